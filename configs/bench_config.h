@@ -0,0 +1,93 @@
+/******************************************************************************
+* File Name:   bench_config.h
+*
+* Description: This file has the configuration of the publish benchmark
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_BENCH_CONFIG_H_
+#define SOURCE_BENCH_CONFIG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Topic used by the benchmark (kept apart from MQTT_PUB_TOPIC so that the
+ * subscriber does not act on benchmark traffic)
+ */
+#define PUBLISH_BENCH_TOPIC             "bench/publish"
+
+/* Number of messages published per run */
+#define PUBLISH_BENCH_MESSAGE_COUNT     (200u)
+
+/* Offered load in messages per second (0 = as fast as the queue accepts) */
+#define PUBLISH_BENCH_RATE_PER_SEC      (0u)
+
+/* Payload sizes (bytes) swept by the console benchmark. Keep these below
+ * MQTT_NETWORK_BUFFER_SIZE minus the PUBLISH header and topic.
+ */
+#define PUBLISH_BENCH_PAYLOAD_SIZES     { 16u, 64u, 256u }
+
+/* QoS levels swept by the console benchmark */
+#define PUBLISH_BENCH_QOS_LEVELS        { CY_MQTT_QOS0, (cy_mqtt_qos_t) MQTT_MESSAGES_QOS }
+
+/* Largest payload (bytes) accepted by publish_bench_run() */
+#define PUBLISH_BENCH_MAX_PAYLOAD_SIZE  (256u)
+
+/* Upper bound on the latency samples kept per run */
+#define PUBLISH_BENCH_MAX_SAMPLES       (1000u)
+
+/* Time allowed for outstanding publishes to complete after the last one
+ * has been enqueued
+ */
+#define PUBLISH_BENCH_DRAIN_TIMEOUT_MS  (30000u)
+
+/* Samples per telemetry frame swept by the console benchmark */
+#define TELEMETRY_BENCH_BATCH_SIZES     { 1u, 10u, 60u }
+
+/* Largest batch size above */
+#define TELEMETRY_BENCH_MAX_BATCH       (60u)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_BENCH_CONFIG_H_ */
+
+/* [] END OF FILE */
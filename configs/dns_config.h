@@ -0,0 +1,100 @@
+/******************************************************************************
+* File Name:   dns_config.h
+*
+* Description: This file contains the configuration macros of the DNS cache,
+*              which resolves the MQTT broker hostnames in the background.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ *  Include guard
+ ******************************************************************************/
+#ifndef SOURCE_DNS_CONFIG_H_
+#define SOURCE_DNS_CONFIG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of hostnames the cache holds, each with an address per link */
+#define DNS_CACHE_MAX_HOSTS               (2u)
+
+/* Longest hostname that can be cached; longer ones are resolved by the
+ * MQTT library on every connection, as without the cache.
+ */
+#define DNS_CACHE_HOSTNAME_MAX_LEN        (64u)
+
+/* The TTL of an answer is kept within these bounds, in seconds, so that a
+ * short TTL does not cost a query every few seconds on cellular.
+ */
+#define DNS_CACHE_TTL_MIN_SEC             (60u)
+#define DNS_CACHE_TTL_MAX_SEC             (86400u)
+
+/* An address is resolved again once this share of its TTL has passed,
+ * before it expires.
+ */
+#define DNS_CACHE_PREFETCH_PERCENT        (80u)
+
+/* An expired address is still served for this long, in seconds, while it
+ * is resolved again: a DNS failure does not stop a reconnection. A dozen
+ * DNS_CACHE_RETRY_MS, so that a broker that has moved is not looked for
+ * at its old address for long; a failed connection to a cached address
+ * is also retried with the hostname resolved.
+ */
+#define DNS_CACHE_STALE_MAX_SEC           (120u)
+
+/* Wait before resolving a hostname again after a failure, in milliseconds */
+#define DNS_CACHE_RETRY_MS                (10000u)
+
+/* Time to wait for the answer of each DNS server, in milliseconds */
+#define DNS_QUERY_TIMEOUT_MS              (2000u)
+
+/* How often the DNS cache task looks for addresses to prefetch, in
+ * milliseconds; a lookup that misses wakes it at once.
+ */
+#define DNS_CACHE_POLL_MS                 (1000u)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_DNS_CONFIG_H_ */
+
+/* [] END OF FILE */
@@ -42,6 +42,8 @@
 #ifndef SOURCE_FEATURE_CONFIG_H_
 #define SOURCE_FEATURE_CONFIG_H_
 
+#include "variant_config.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -55,13 +57,23 @@ extern "C"
 
 // core features
 #define FEATURE_PPP                     ENABLE_FEATURE
-#define FEATURE_WIFI                    DISABLE_FEATURE
+#ifndef FEATURE_WIFI    // LINK_MANAGER=1 in the Makefile enables it
+#define FEATURE_WIFI                    DISABLE_FEATURE // the kit ships for cellular; set the AP in wifi_config.h first
+#endif
 #define FEATURE_CONSOLE                 ENABLE_FEATURE
 #define FEATURE_ESIM_LPA_MENU           DISABLE_FEATURE // unused option
 #define FEATURE_APPS                    ENABLE_FEATURE
 #define FEATURE_MQTT                    ENABLE_FEATURE
+#if (VARIANT_MODEM == FAKE_VARIANT)
+#define FEATURE_BLE_MODEM               DISABLE_FEATURE // needs a real modem
+#else
 #define FEATURE_BLE_MODEM               ENABLE_FEATURE
+#endif
 #define FEATURE_FLASH_EEPROM            DISABLE_FEATURE // unused option
+#ifndef FEATURE_LINK_MANAGER    // LINK_MANAGER=1 in the Makefile enables it
+#define FEATURE_LINK_MANAGER            DISABLE_FEATURE // needs FEATURE_WIFI and FEATURE_PPP, so off with FEATURE_WIFI
+#endif
+#define FEATURE_DNS_CACHE               ENABLE_FEATURE
 
 // eSIM LPA menu features (only takes effect if FEATURE_ESIM_LPA_MENU is enabled)
 #define FEATURE_ADD_PROFILE             DISABLE_FEATURE // unused option
@@ -75,6 +87,10 @@ extern "C"
 #define FEATURE_UNIT_TEST_ESIM_LPA      DISABLE_FEATURE // unused option
 #define FEATURE_UNIT_TEST_RTOS          DISABLE_FEATURE // unused option
 
+// benchmarks (see bench_config.h)
+#define FEATURE_BENCHMARK_PUBLISH       DISABLE_FEATURE
+#define FEATURE_BENCHMARK_TELEMETRY     DISABLE_FEATURE
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,116 @@
+/******************************************************************************
+* File Name:   link_config.h
+*
+* Description: This file contains the configuration macros of the link
+*              manager, which picks the default I/O between Wi-Fi and cellular.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/*******************************************************************************
+ *  Include guard
+ ******************************************************************************/
+#ifndef SOURCE_LINK_CONFIG_H_
+#define SOURCE_LINK_CONFIG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of callbacks that can subscribe to the link events */
+#define LINK_EVENTS_MAX_SUBSCRIBERS       (8u)
+
+/* How often the link manager scores the links, in milliseconds */
+#define LINK_MANAGER_POLL_MS              (1000u)
+
+/* Signal score of a link that is up, from 0 (down) to 100. Wi-Fi scores
+ * by its RSSI, from 0 at LINK_WIFI_RSSI_MIN_DBM to 100 at
+ * LINK_WIFI_RSSI_MAX_DBM; cellular has a fixed score, so that a good Wi-Fi
+ * link, which is not metered, is preferred.
+ */
+#define LINK_WIFI_RSSI_MIN_DBM            (-85)
+#define LINK_WIFI_RSSI_MAX_DBM            (-55)
+#define LINK_CELLULAR_SCORE               (50u)
+
+/* The signal score is scaled down by the packet loss, and by up to half
+ * for a round-trip time from LINK_RTT_GOOD_MS to LINK_RTT_BAD_MS.
+ */
+#define LINK_RTT_GOOD_MS                  (150u)
+#define LINK_RTT_BAD_MS                   (1500u)
+
+/* Weight of a new RSSI, RTT or loss sample in the moving averages: 1/2^n */
+#define LINK_QUALITY_EWMA_SHIFT           (3u)
+
+/* Each link is probed once per interval with a TCP handshake to
+ * LINK_PROBE_HOST over its own netif; a probe that gets no answer in
+ * LINK_PROBE_TIMEOUT_MS counts as a loss. Each probe costs about 300
+ * bytes, hence the longer interval on cellular; 0 never.
+ */
+#define LINK_PROBE_HOST                   MQTT_BROKER_ADDRESS
+#define LINK_PROBE_PORT                   MQTT_PORT
+#define LINK_PROBE_INTERVAL_WIFI_MS       (30000u)
+#define LINK_PROBE_INTERVAL_CELLULAR_MS   (300000u)
+#define LINK_PROBE_TIMEOUT_MS             (3000u)
+
+/* The default I/O moves to a link that scores LINK_SWITCH_MARGIN more,
+ * once it has done so for LINK_SWITCH_HOLD_MS; at once if the default I/O
+ * is down.
+ */
+#define LINK_SWITCH_MARGIN                (15u)
+#define LINK_SWITCH_HOLD_MS               (10000u)
+
+/* Before a default I/O that is still up is left, each broker must answer a
+ * TCP connection over the new link, its address resolved over that link
+ * within LINK_SWITCH_PREPARE_MS; else the switch is retried later.
+ */
+#define LINK_SWITCH_PREPARE_MS            (5000u)
+
+/* How long a link may stay down, having failed to start or lost its
+ * connection, before the link manager restarts it; 0 never.
+ */
+#define LINK_REVIVE_INTERVAL_MS           (60000u)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_LINK_CONFIG_H_ */
+
+/* [] END OF FILE */
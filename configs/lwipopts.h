@@ -304,6 +304,15 @@
 
 #define LWIP_DNS                       (1)
 
+/**
+ * DNS_LOCAL_HOSTLIST: the MQTT client task puts the address of a broker from
+ * the DNS cache (dns_cache_task.c) in this list before connecting, so that
+ * the MQTT library does not wait for DNS. One entry per broker hostname.
+ */
+#define DNS_LOCAL_HOSTLIST             (1)
+#define DNS_LOCAL_HOSTLIST_IS_DYNAMIC  (1)
+#define MEMP_NUM_LOCALHOSTLIST         (2)
+
 #define LWIP_NETIF_TX_SINGLE_PBUF      (1)
 
 #define LWIP_RAND               rand
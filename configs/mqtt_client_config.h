@@ -44,6 +44,7 @@
 #define SOURCE_MQTT_CLIENT_CONFIG_H_
 
 #include "cy_mqtt_api.h"
+#include "variant_config.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -55,6 +56,23 @@ extern "C"
 ********************************************************************************/
 
 /***************** MQTT CLIENT CONNECTION CONFIGURATION MACROS *****************/
+#if (VARIANT_MODEM == FAKE_VARIANT)
+/* The fake variant talks to a non-secure broker stand-in (e.g. Mosquitto).
+ * On a board, 127.0.0.1 is the device itself: set FAKE_BROKER (and
+ * FAKE_WIFI=0) in the Makefile to reach a broker on the LAN.
+ */
+#ifndef FAKE_MQTT_BROKER_ADDRESS
+#define FAKE_MQTT_BROKER_ADDRESS          "127.0.0.1"
+#endif
+#ifndef FAKE_MQTT_PORT
+#define FAKE_MQTT_PORT                    1883
+#endif
+
+#define MQTT_BROKER_ADDRESS               FAKE_MQTT_BROKER_ADDRESS
+#define MQTT_PORT                         FAKE_MQTT_PORT
+#define MQTT_SECURE_CONNECTION            ( 0 )
+
+#else
 /* MQTT Broker/Server address and port used for the MQTT connection. */
 #define MQTT_BROKER_ADDRESS               "MY_MQTT_BROKER_ADDRESS"
 #define MQTT_PORT                         8883
@@ -63,17 +81,37 @@ extern "C"
  * required to be established, else 0.
  */
 #define MQTT_SECURE_CONNECTION            ( 1 )
+#endif
 
 /* Configure the user credentials to be sent as part of MQTT CONNECT packet */
 #define MQTT_USERNAME                     "User"
 #define MQTT_PASSWORD                     ""
 
+/* Number of MQTT connections: 1, or 2 to add a bulk connection. The command
+ * connection carries the subscriptions and the publisher task queue; the
+ * bulk connection carries the batches of publisher_publish_batch(), so that
+ * a telemetry flush does not hold up the commands. Each connection has its
+ * own network buffer, publisher task and reconnection, and its own TLS
+ * handshake and keep-alive traffic over the link. With 1, the bulk traffic
+ * goes over the command connection.
+ */
+#define MQTT_CONNECTION_COUNT             ( 1u )
+
+/* MQTT Broker/Server address and port of the bulk connection. */
+#define MQTT_BULK_BROKER_ADDRESS          MQTT_BROKER_ADDRESS
+#define MQTT_BULK_PORT                    MQTT_PORT
+
 
 /********************* MQTT MESSAGE CONFIGURATION MACROS **********************/
 /* The MQTT topics to be used by the publisher and subscriber. */
 #define MQTT_PUB_TOPIC                    "ledstatus"
 #define MQTT_SUB_TOPIC                    "ledstatus"
 
+/* Topic on which configuration blobs are streamed to the device in chunks
+ * (see mqtt_stream.h), e.g. with the host tool in tools/stream_send.
+ */
+#define MQTT_CONFIG_TOPIC                 "ledstatus/config"
+
 /* Set the QoS that is associated with the MQTT publish, and subscribe messages.
  * Valid choices are 0, 1, and 2. Other values should not be used in this macro.
  */
@@ -116,9 +154,21 @@ extern "C"
  * connections simultaneously, set this macro to 1. The device will then
  * generate a unique client identifier by appending a timestamp to the 
  * 'MQTT_CLIENT_IDENTIFIER' string. Example: 'psoc6-mqtt-client5927'
+ * With MQTT_PERSISTENT_SESSION, the silicon unique ID is appended instead,
+ * so that the identifier stays the same across connections.
  */
 #define GENERATE_UNIQUE_CLIENT_ID         ( 1 )
 
+/* Set this macro to 1 to connect with a persistent session
+ * (clean_session = false). The broker then keeps the subscriptions, and
+ * queues the QoS 1/2 messages while the device is offline. The topics are
+ * still subscribed again on every reconnection, as the MQTT library does not
+ * report whether the broker resumed the session.
+ * The TLS handshake is still a full one: the secure sockets library opens a
+ * new TLS session on every connection.
+ */
+#define MQTT_PERSISTENT_SESSION           ( 1 )
+
 /* The longest client identifier that an MQTT server must accept (as defined
  * by the MQTT 3.1.1 spec) is 23 characters. However some MQTT brokers support 
  * longer client IDs. Configure this macro as per the MQTT broker specification. 
@@ -158,14 +208,160 @@ extern "C"
  * Note: The minimum buffer size is defined by 'CY_MQTT_MIN_NETWORK_BUFFER_SIZE' 
  * macro in the MQTT library. Please ensure this macro value is larger than 
  * 'CY_MQTT_MIN_NETWORK_BUFFER_SIZE'.
+ * It can be set per build (e.g. DEFINES+=MQTT_NETWORK_BUFFER_SIZE=1024 in the
+ * Makefile); the subscriber statistics show the largest message received.
+ * Payloads larger than the buffer are received as streams (mqtt_stream.h).
  */
+#ifndef MQTT_NETWORK_BUFFER_SIZE
 #define MQTT_NETWORK_BUFFER_SIZE          ( 2 * CY_MQTT_MIN_NETWORK_BUFFER_SIZE )
+#endif
+
+/* Number of messages that publisher_publish_batch() can hold before the
+ * publisher task has drained them.
+ */
+#define MQTT_PUBLISH_RING_SIZE            (16u)
+
+/* Number of ring records that the bulk connection keeps in flight at once,
+ * so that the acknowledgements of QoS1/QoS2 messages overlap instead of
+ * costing a round trip each. Above 1, each slot is a task blocked in
+ * cy_mqtt_publish() (see mqtt_publish_window.h); 1 publishes from the
+ * publisher task. Raise it only after measuring the gain on the target
+ * link: the library may serialise the waits of concurrent callers. At
+ * most MQTT_STATE_ARRAY_MAX_COUNT of core_mqtt_config.h.
+ */
+#ifndef MQTT_PUBLISH_WINDOW_SIZE
+#define MQTT_PUBLISH_WINDOW_SIZE          (1u)
+#endif
+
+/* Sensor samples can be aggregated per topic before they are published:
+ * one message per window, holding either min/max/mean/last/count or the
+ * packed samples (see mqtt_aggregator.h). Each of the
+ * MQTT_AGGREGATOR_MAX_CHANNELS topics has two frame buffers of
+ * MQTT_AGGREGATOR_FRAME_SIZE bytes: one filling, one being published.
+ */
+#define MQTT_AGGREGATOR_MAX_CHANNELS      (4u)
+#define MQTT_AGGREGATOR_FRAME_SIZE        (256u)
+
+/* Number of PUBLISH_MQTT_MSG commands the publisher task queue can hold,
+ * plus the slots kept free for its control commands (init/deinit/batch).
+ */
+#define PUBLISHER_QUEUE_DEPTH             (16u)
+#define PUBLISHER_QUEUE_RESERVED_SLOTS    (4u)
+
+/* Number of commands that ISRs can put before the publisher task moves
+ * them into its queue; a power of two.
+ */
+#define PUBLISHER_QUEUE_ISR_RING_SIZE     (8u)
+
+/* What happens to a message when the publisher queue is full:
+ * PUBLISHER_QUEUE_DROP_OLDEST, PUBLISHER_QUEUE_DROP_NEWEST,
+ * PUBLISHER_QUEUE_COALESCE_BY_TOPIC or PUBLISHER_QUEUE_BLOCK. It can be
+ * changed at runtime with publisher_queue_set_policy().
+ */
+#define PUBLISHER_QUEUE_POLICY            PUBLISHER_QUEUE_DROP_OLDEST
+
+/* How long PUBLISHER_QUEUE_BLOCK lets a task wait for space, in ms */
+#define PUBLISHER_QUEUE_BLOCK_TIMEOUT_MS  (100u)
+
+/* The publisher queue has two lanes. PUBLISHER_PRIORITY_HIGH messages
+ * (alarms, commands) are taken before the PUBLISHER_PRIORITY_NORMAL ones
+ * (periodic telemetry), and evict a normal message from a full queue
+ * whatever the policy. Normal messages are paced: up to
+ * PUBLISHER_NORMAL_LANE_BURST back-to-back, then one every
+ * PUBLISHER_NORMAL_LANE_INTERVAL_MS (0 = not paced).
+ */
+#define PUBLISHER_NORMAL_LANE_INTERVAL_MS (20u)
+#define PUBLISHER_NORMAL_LANE_BURST       (8u)
+
+/* Uplink limits, applied while the default connectivity is cellular (the
+ * SIMs on PPP_APN are metered) and lifted on Wi-Fi. Publishes are paced by
+ * token buckets on bytes and on messages per second (0 = not limited);
+ * PUBLISHER_PRIORITY_HIGH messages never wait for tokens. Each publish
+ * counts its topic and payload plus MQTT_UPLINK_PUBLISH_OVERHEAD bytes of
+ * MQTT, TLS and TCP/IP headers.
+ */
+#define MQTT_UPLINK_BYTES_PER_SEC         (2048u)
+#define MQTT_UPLINK_BYTES_BURST           (8192u)
+#define MQTT_UPLINK_MSGS_PER_SEC          (10u)
+#define MQTT_UPLINK_MSGS_BURST            (20u)
+#define MQTT_UPLINK_PUBLISH_OVERHEAD      (60u)
+
+/* Bytes counted for each MQTT connection attempt on cellular: the TCP and
+ * TLS handshakes, with the client certificate, and the CONNECT packet.
+ */
+#define MQTT_UPLINK_CONNECT_OVERHEAD      (3072u)
+
+/* Cellular data budget per day, in bytes (0 = no budget). As it is used
+ * up, the publisher degrades in steps: messages on the same topic
+ * coalesce in the publisher queue, then the batches of
+ * publisher_publish_batch() are dropped, then only PUBLISHER_PRIORITY_HIGH
+ * messages (alarms) are sent. Connections, DNS queries and link probes on
+ * cellular count as well. The usage of the day is kept across resets, but
+ * not across power cycles: the day then starts over.
+ */
+#define MQTT_DAILY_BUDGET_BYTES           (1024u * 1024u)
+#define MQTT_BUDGET_COALESCE_PERCENT      (50u)
+#define MQTT_BUDGET_DROP_BULK_PERCENT     (75u)
+#define MQTT_BUDGET_ALARMS_ONLY_PERCENT   (90u)
+
+/* Messages that cannot be published while the MQTT connection is down are
+ * kept in an append-only offline store, and replayed after the reconnection
+ * in bursts of MQTT_OFFLINE_REPLAY_BURST messages every
+ * MQTT_OFFLINE_REPLAY_INTERVAL_MS. The store is a ring of blocks of
+ * MQTT_OFFLINE_STORE_BLOCK_SIZE bytes; when it is full, the oldest block is
+ * dropped. A record (topic and payload) must fit in one block. While a
+ * backlog is replayed, new normal priority messages are appended to it,
+ * so that the broker gets the messages in order; high priority messages
+ * are published at once.
+ */
+#define MQTT_OFFLINE_STORE_BLOCK_SIZE     (512u)
+#define MQTT_OFFLINE_STORE_RAM_BLOCKS     (8u)
+#define MQTT_OFFLINE_REPLAY_BURST         (4u)
+#define MQTT_OFFLINE_REPLAY_INTERVAL_MS   (500u)
+
+/* With FEATURE_FLASH_EEPROM, the blocks are flash rows instead of RAM, in
+ * the region the linker reserves for the Emulated EEPROM, and survive a
+ * reset. The block size must then equal the flash row size. The partly
+ * filled block is written once its oldest record is
+ * MQTT_OFFLINE_STORE_FLUSH_MS old, even if no further message comes.
+ */
+#define MQTT_OFFLINE_STORE_FLASH_ADDR     (CY_EM_EEPROM_BASE)
+#define MQTT_OFFLINE_STORE_FLASH_BLOCKS   (32u)
+#define MQTT_OFFLINE_STORE_FLUSH_MS       (30000u)
+
+/* Sizing of the subscription registry (topic filter trie): filters, trie
+ * nodes (one per distinct filter level), characters per level, and
+ * handlers that a single received message can match.
+ */
+#define MQTT_TOPIC_TRIE_MAX_FILTERS       (32u)
+#define MQTT_TOPIC_TRIE_MAX_NODES         (64u)
+#define MQTT_TOPIC_LEVEL_MAX_LEN          (32u)
+#define MQTT_TOPIC_TRIE_MAX_MATCHES       (8u)
+
+/* Received messages are copied into one of MQTT_RX_SLAB_COUNT slabs of
+ * MQTT_RX_SLAB_SIZE bytes (topic and payload) and handled by the subscriber
+ * task. Larger messages, and messages that find no free slab, are dropped.
+ */
+#define MQTT_RX_SLAB_COUNT                (8u)
+#define MQTT_RX_SLAB_SIZE                 (256u)
+
+/* Number of topic filters that can receive streamed payloads. */
+#define MQTT_STREAM_MAX_HANDLERS          (4u)
 
 /* Maximum MQTT connection re-connection limit. */
 #define MAX_MQTT_CONN_RETRIES            (150u)
 
-/* MQTT re-connection time interval in milliseconds. */
-#define MQTT_CONN_RETRY_INTERVAL_MS      (10000)
+/* MQTT re-connection backoff in milliseconds. After the n-th consecutive
+ * failure, the next attempt waits a random time in
+ * [0, min(MAX, BASE * 2^(n-1))] ("full jitter").
+ */
+#define MQTT_CONN_BACKOFF_BASE_MS        (1000u)
+#define MQTT_CONN_BACKOFF_MAX_MS         (60000u)
+
+/* When the PPP or Wi-Fi link comes up, reconnect within a random time of
+ * up to this many milliseconds (0 = at once).
+ */
+#define MQTT_CONN_IO_UP_JITTER_MS        (1000u)
 
 
 /**************** MQTT CLIENT CERTIFICATE CONFIGURATION MACROS ****************/
@@ -189,10 +385,18 @@ extern "C"
 "........base64 data........\n" \
 "-----END CERTIFICATE-----"
 
+/* The PEM credentials above are decoded once to DER in a static cache of this
+ * many bytes, and every TLS connection then parses the DER. A credential
+ * that does not fit stays PEM. The credentials can also be given directly as
+ * DER byte arrays (which take less flash than PEM); these are used as they
+ * are.
+ */
+#define MQTT_CREDENTIALS_DER_CACHE_SIZE    ( 4096 )
+
 /******************************************************************************
 * Global Variables
 *******************************************************************************/
-extern cy_mqtt_broker_info_t broker_info;
+extern cy_mqtt_broker_info_t broker_info[MQTT_CONNECTION_COUNT];
 extern cy_awsport_ssl_credentials_t  *security_info;
 extern cy_mqtt_connect_info_t g_mqtt_connection_info;
 
@@ -72,6 +72,22 @@ extern "C"
 /* PPP re-connection time interval in milliseconds */
 #define PPP_CONN_RETRY_INTERVAL_MSEC     (10000)
 
+/* Time given to the user to stop PPP from the console before the first
+ * connection attempt, in milliseconds; 0 starts at once, as an unattended
+ * device should.
+ */
+#define PPP_START_PROMPT_MSEC            (0)
+
+/* Power the modem up in command mode before the first connection attempt,
+ * as the console does for the eSIM menu, so that its start-up overlaps the
+ * start prompt and is timed apart from the registration and PPP
+ * negotiation. The modem stays powered when the command session closes.
+ * Off by default: the command session is opened and closed on top of the
+ * PPP connection, and nothing else runs meanwhile, so it only pays off
+ * with a start prompt, or to time the modem start-up on its own.
+ */
+#define PPP_PREWARM_MODEM                (0)
+
 #ifdef __cplusplus
 }
 #endif
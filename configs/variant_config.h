@@ -53,8 +53,37 @@ extern "C"
 #define HW_VARIANT      1
 #define FAKE_VARIANT    2
 
+/* Both variants can be overridden from the Makefile (see VARIANT) */
+#ifndef VARIANT_BLE
 #define VARIANT_BLE             HW_VARIANT
+#endif
+
+/* FAKE_VARIANT replaces the PPP connection manager (cy_pcm_*) and the Wi-Fi
+ * connection manager (cy_wcm_*) with the stand-ins in source/fake, so that
+ * the task layer can run on a board without a modem. It is still a PSoC 6
+ * build; there is no host build of the task layer.
+ */
+#ifndef VARIANT_MODEM
 #define VARIANT_MODEM           HW_VARIANT
+#endif
+
+#if (VARIANT_MODEM == FAKE_VARIANT)
+/* Time taken by a fake PPP / Wi-Fi link to come up */
+#define FAKE_IO_CONNECT_DELAY_MSEC      (200u)
+
+/* IPv4 address reported by the fake links (127.0.0.1) */
+#define FAKE_IO_IP_ADDRESS              (0x0100007Fu)
+
+/* Signal strength reported by the fake AP, in dBm */
+#define FAKE_IO_WIFI_RSSI_DBM           (-60)
+
+/* 1 to fake the Wi-Fi link too, 0 to keep the real cy_wcm_* so that the
+ * MQTT traffic can reach a broker on the LAN (see FAKE_WIFI in the Makefile)
+ */
+#ifndef FAKE_IO_WIFI
+#define FAKE_IO_WIFI                    (1)
+#endif
+#endif
 
 #ifdef __cplusplus
 }
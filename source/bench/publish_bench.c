@@ -0,0 +1,358 @@
+/******************************************************************************
+* File Name:   publish_bench.c
+*
+* Description: This file contains a benchmark that drives the publisher task
+*              through the publisher queue and reports throughput, enqueue-to-
+*              completion latency percentiles and heap usage.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "feature_config.h"
+
+#if (FEATURE_BENCHMARK_PUBLISH == ENABLE_FEATURE)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(__ARMCC_VERSION)
+#include <malloc.h>       /* for mallinfo */
+#endif
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* mallinfo() is deprecated from glibc 2.33, for host builds */
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+#define BENCH_MALLINFO()    mallinfo2()
+#define bench_mallinfo_t    struct mallinfo2
+#else
+#define BENCH_MALLINFO()    mallinfo()
+#define bench_mallinfo_t    struct mallinfo
+#endif
+
+#include "publish_bench.h"
+#include "publisher_task.h"
+#include "publisher_queue.h"
+#include "mqtt_client_config.h"
+#include "bench_config.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "publish_bench";
+
+static uint8_t s_payload_buf[PUBLISH_BENCH_MAX_PAYLOAD_SIZE];
+static mqtt_payload_t s_payload;
+
+/* Written by the publisher task through bench_publish_complete(). Each
+ * message carries the id of its run, so that a late completion of a run
+ * that timed out is not counted in the next one.
+ */
+static volatile uint32_t s_run_id = 0;
+static uint32_t s_latency_ms[PUBLISH_BENCH_MAX_SAMPLES];
+static volatile uint32_t s_completed = 0;
+static volatile uint32_t s_failed = 0;
+
+static size_t s_heap_baseline = 0;
+static volatile size_t s_heap_peak = 0;
+
+static cy_semaphore_t s_done_semaphore;
+static bool s_semaphore_initialized = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static size_t bench_heap_in_use(void)
+{
+#if defined(__GNUC__) && !defined(__ARMCC_VERSION)
+    bench_mallinfo_t info = BENCH_MALLINFO();
+    return (size_t)info.uordblks;
+#else
+    return 0;
+#endif
+}
+
+static void bench_sample_heap(void)
+{
+    size_t in_use = bench_heap_in_use();
+
+    if (in_use > s_heap_peak) {
+        s_heap_peak = in_use;
+    }
+}
+
+static void bench_publish_complete(cy_rslt_t result,
+                                   cy_time_t enqueue_time,
+                                   void *arg)
+{
+    cy_time_t now = 0;
+
+    if ((uint32_t)(uintptr_t)arg != s_run_id) {
+        CY_LOGD(TAG, "ignoring a completion of run %lu", (unsigned long)(uintptr_t)arg);
+        return;
+    }
+
+    cy_rtos_get_time(&now);
+
+    if (result == CY_RSLT_SUCCESS) {
+        if (s_completed < PUBLISH_BENCH_MAX_SAMPLES) {
+            s_latency_ms[s_completed] = (uint32_t)(now - enqueue_time);
+        }
+        s_completed++;
+
+    } else {
+        s_failed++;
+    }
+
+    bench_sample_heap();
+    cy_rtos_set_semaphore(&s_done_semaphore, false);
+}
+
+static int compare_uint32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array, permille = 500 for p50 */
+static uint32_t bench_percentile(const uint32_t *sorted,
+                                 uint32_t count,
+                                 uint32_t permille)
+{
+    uint32_t rank;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    rank = ((count * permille) + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    return sorted[rank - 1];
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t publish_bench_run(const publish_bench_config_t *config,
+                            publish_bench_result_t *result)
+{
+    cy_rslt_t rslt;
+    cy_time_t start_time = 0;
+    cy_time_t end_time = 0;
+    cy_time_t next_send_time = 0;
+    uint32_t interval_ms = 0;
+    uint32_t enqueue_failed = 0;
+    uint32_t samples;
+
+    if ((config == NULL) || (result == NULL) ||
+        (config->message_count == 0) ||
+        (config->payload_size > PUBLISH_BENCH_MAX_PAYLOAD_SIZE)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (g_publisher_task_handle[MQTT_CONN_COMMAND] == NULL) {
+        CY_LOGE(TAG, "MQTT is not started");
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (!s_semaphore_initialized) {
+        rslt = cy_rtos_init_semaphore(&s_done_semaphore,
+                                      PUBLISH_BENCH_MAX_SAMPLES,
+                                      0);
+        if (rslt != CY_RSLT_SUCCESS) {
+            CY_LOGE(TAG, "cy_rtos_init_semaphore failed!");
+            return rslt;
+        }
+        s_semaphore_initialized = true;
+    }
+
+    /* Completions of a previous run that timed out are ignored from now on */
+    s_run_id++;
+
+    /* Drain completions left over from a previous run that timed out */
+    while (cy_rtos_get_semaphore(&s_done_semaphore, 0, false) == CY_RSLT_SUCCESS);
+
+    /* Shared by every message of the run; no release callback needed */
+    memset(s_payload_buf, 'x', config->payload_size);
+    mqtt_payload_init(&s_payload, s_payload_buf, config->payload_size, NULL, NULL);
+
+    memset(result, 0, sizeof(*result));
+    s_completed = 0;
+    s_failed = 0;
+    s_heap_baseline = bench_heap_in_use();
+    s_heap_peak = s_heap_baseline;
+
+    if (config->rate_per_sec > 0) {
+        interval_ms = 1000 / config->rate_per_sec;
+    }
+
+    cy_rtos_get_time(&start_time);
+    next_send_time = start_time;
+
+    for (uint32_t i = 0; i < config->message_count; i++) {
+        publisher_data_t publisher_q_data;
+
+        if (interval_ms > 0) {
+            cy_time_t now = 0;
+
+            cy_rtos_get_time(&now);
+            if ((int32_t)(next_send_time - now) > 0) {
+                cy_rtos_delay_milliseconds(next_send_time - now);
+            }
+            next_send_time += interval_ms;
+        }
+
+        publisher_q_data.cmd = PUBLISH_MQTT_MSG;
+        publisher_q_data.payload = &s_payload;
+        publisher_q_data.topic = PUBLISH_BENCH_TOPIC;
+        publisher_q_data.qos = config->qos;
+        publisher_q_data.priority = PUBLISHER_PRIORITY_NORMAL;
+        publisher_q_data.complete_cb = bench_publish_complete;
+        publisher_q_data.complete_arg = (void *)(uintptr_t)s_run_id;
+        publisher_q_data.conn = MQTT_CONN_COMMAND;
+        cy_rtos_get_time(&publisher_q_data.enqueue_time);
+
+        if (CY_RSLT_SUCCESS != publisher_queue_put(&publisher_q_data, false)) {
+            enqueue_failed++;
+        } else {
+            result->sent++;
+        }
+
+        bench_sample_heap();
+    }
+
+    /* Wait for the outstanding publishes to complete */
+    while ((s_completed + s_failed) < result->sent) {
+        if (cy_rtos_get_semaphore(&s_done_semaphore,
+                                  PUBLISH_BENCH_DRAIN_TIMEOUT_MS,
+                                  false) != CY_RSLT_SUCCESS) {
+            CY_LOGE(TAG, "timed out waiting for %lu publishes",
+                    (unsigned long)(result->sent - s_completed - s_failed));
+            break;
+        }
+    }
+
+    cy_rtos_get_time(&end_time);
+
+    result->completed = s_completed;
+    result->failed = s_failed + enqueue_failed;
+    result->elapsed_ms = (uint32_t)(end_time - start_time);
+    if (result->elapsed_ms == 0) {
+        result->elapsed_ms = 1;
+    }
+    result->msgs_per_sec_x100 = (uint32_t)(((uint64_t)result->completed * 100000u) /
+                                           result->elapsed_ms);
+
+    samples = result->completed;
+    if (samples > PUBLISH_BENCH_MAX_SAMPLES) {
+        samples = PUBLISH_BENCH_MAX_SAMPLES;
+    }
+
+    qsort(s_latency_ms, samples, sizeof(s_latency_ms[0]), compare_uint32);
+
+    result->latency_p50_ms = bench_percentile(s_latency_ms, samples, 500);
+    result->latency_p99_ms = bench_percentile(s_latency_ms, samples, 990);
+    result->latency_p999_ms = bench_percentile(s_latency_ms, samples, 999);
+    result->latency_max_ms = (samples > 0) ? s_latency_ms[samples - 1] : 0;
+    result->heap_peak_bytes = s_heap_peak - s_heap_baseline;
+
+    return CY_RSLT_SUCCESS;
+}
+
+void publish_bench_print(const publish_bench_config_t *config,
+                         const publish_bench_result_t *result)
+{
+    VoidAssert(config != NULL);
+    VoidAssert(result != NULL);
+
+    /* One line per run, so that CI can parse the results */
+    PRINT_MSG(("BENCH publish qos=%d size=%u rate=%lu sent=%lu ok=%lu fail=%lu "
+               "ms=%lu msg/s=%lu.%02lu p50=%lu p99=%lu p999=%lu max=%lu heap=%u\n",
+               (int)config->qos,
+               (unsigned int)config->payload_size,
+               (unsigned long)config->rate_per_sec,
+               (unsigned long)result->sent,
+               (unsigned long)result->completed,
+               (unsigned long)result->failed,
+               (unsigned long)result->elapsed_ms,
+               (unsigned long)(result->msgs_per_sec_x100 / 100),
+               (unsigned long)(result->msgs_per_sec_x100 % 100),
+               (unsigned long)result->latency_p50_ms,
+               (unsigned long)result->latency_p99_ms,
+               (unsigned long)result->latency_p999_ms,
+               (unsigned long)result->latency_max_ms,
+               (unsigned int)result->heap_peak_bytes));
+}
+
+void publish_bench_main(void)
+{
+    const cy_mqtt_qos_t qos_levels[] = PUBLISH_BENCH_QOS_LEVELS;
+    const size_t payload_sizes[] = PUBLISH_BENCH_PAYLOAD_SIZES;
+
+    for (size_t q = 0; q < sizeof(qos_levels) / sizeof(qos_levels[0]); q++) {
+        for (size_t s = 0; s < sizeof(payload_sizes) / sizeof(payload_sizes[0]); s++) {
+            publish_bench_config_t config = {
+                .message_count = PUBLISH_BENCH_MESSAGE_COUNT,
+                .rate_per_sec = PUBLISH_BENCH_RATE_PER_SEC,
+                .qos = qos_levels[q],
+                .payload_size = payload_sizes[s],
+            };
+            publish_bench_result_t result;
+
+            /* Messages dropped by the queue's overflow policy count as failed */
+            publisher_queue_reset_stats();
+
+            if (publish_bench_run(&config, &result) != CY_RSLT_SUCCESS) {
+                PRINT_MSG(("# publish benchmark could not run\n"));
+                return;
+            }
+
+            publish_bench_print(&config, &result);
+            publisher_queue_print_stats();
+        }
+    }
+}
+
+#endif /* FEATURE_BENCHMARK_PUBLISH */
+
+/* [] END OF FILE */
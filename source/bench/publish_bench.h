@@ -0,0 +1,93 @@
+/******************************************************************************
+* File Name:   publish_bench.h
+*
+* Description: This file is the public interface of publish_bench.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_PUBLISH_BENCH_H_
+#define SOURCE_PUBLISH_BENCH_H_
+
+#include "feature_config.h"
+#include "cyabs_rtos.h"
+#include "cy_mqtt_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+typedef struct {
+    uint32_t message_count;
+    uint32_t rate_per_sec;      /* 0 = as fast as the queue accepts */
+    cy_mqtt_qos_t qos;
+    size_t payload_size;        /* up to PUBLISH_BENCH_MAX_PAYLOAD_SIZE */
+} publish_bench_config_t;
+
+typedef struct {
+    uint32_t sent;              /* messages enqueued to the publisher */
+    uint32_t completed;         /* messages published (acked for QoS1/2) */
+    uint32_t failed;            /* enqueue or publish failures */
+    uint32_t elapsed_ms;
+    uint32_t msgs_per_sec_x100; /* completed messages/s, fixed point */
+    uint32_t latency_p50_ms;    /* enqueue-to-completion latencies */
+    uint32_t latency_p99_ms;
+    uint32_t latency_p999_ms;
+    uint32_t latency_max_ms;
+    size_t heap_peak_bytes;     /* peak heap in use above the baseline */
+} publish_bench_result_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t publish_bench_run(const publish_bench_config_t *config,
+                            publish_bench_result_t *result);
+
+void publish_bench_print(const publish_bench_config_t *config,
+                         const publish_bench_result_t *result);
+
+/* Sweep the QoS levels and payload sizes in bench_config.h */
+void publish_bench_main(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_PUBLISH_BENCH_H_ */
+
+/* [] END OF FILE */
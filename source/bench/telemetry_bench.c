@@ -0,0 +1,232 @@
+/******************************************************************************
+* File Name:   telemetry_bench.c
+*
+* Description: This file contains a benchmark that compares the bytes per sample
+*              of text, binary and compressed telemetry frames
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "feature_config.h"
+
+#if (FEATURE_BENCHMARK_TELEMETRY == ENABLE_FEATURE)
+
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry_bench.h"
+#include "mqtt_telemetry.h"
+#include "bench_config.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define BENCH_FIELD_COUNT       (4u)
+
+/* Sampling period of the synthetic sensor */
+#define BENCH_PERIOD_MS         (1000u)
+
+#define BENCH_FRAME_SIZE        (MQTT_TELEMETRY_HEADER_MAX_SIZE + \
+                                 (TELEMETRY_BENCH_MAX_BATCH * \
+                                  MQTT_TELEMETRY_SAMPLE_MAX_SIZE(BENCH_FIELD_COUNT)))
+
+typedef struct {
+    uint32_t time_ms;
+    int32_t values[BENCH_FIELD_COUNT];
+} bench_sample_t;
+
+typedef struct {
+    const bench_sample_t *samples;
+    uint32_t decoded;
+    bool match;
+} bench_check_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const mqtt_telemetry_field_t s_fields[BENCH_FIELD_COUNT] = {
+    { .name = "temperature", .decimals = 2 },
+    { .name = "humidity",    .decimals = 1 },
+    { .name = "battery_mv",  .decimals = 0 },
+    { .name = "rssi_dbm",    .decimals = 0 },
+};
+
+static const mqtt_telemetry_schema_t s_schema = {
+    .id = 1,
+    .version = 1,
+    .field_count = BENCH_FIELD_COUNT,
+    .fields = s_fields,
+};
+
+static bench_sample_t s_samples[TELEMETRY_BENCH_MAX_BATCH];
+static uint8_t s_frame[BENCH_FRAME_SIZE];
+static uint8_t s_compressed[BENCH_FRAME_SIZE];
+static uint8_t s_scratch[BENCH_FRAME_SIZE];
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* Slowly drifting readings, the same on every run */
+static void bench_make_samples(size_t count)
+{
+    uint32_t random = 0x2545F491u;
+    int32_t values[BENCH_FIELD_COUNT] = { 2150, 455, 3700, -71 };
+    const int32_t steps[BENCH_FIELD_COUNT] = { 3, 2, 1, 2 };
+
+    for (size_t i = 0; i < count; i++) {
+        s_samples[i].time_ms = 1000000u + (uint32_t)i * BENCH_PERIOD_MS;
+
+        for (size_t f = 0; f < BENCH_FIELD_COUNT; f++) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            values[f] += (int32_t)(random % (2u * steps[f] + 1u)) - steps[f];
+            s_samples[i].values[f] = values[f];
+        }
+    }
+}
+
+/* Length of the samples as a JSON array, the way text payloads are built */
+static size_t bench_text_length(size_t count)
+{
+    char text[128];
+    size_t len = 2;     /* [] */
+
+    for (size_t i = 0; i < count; i++) {
+        const int32_t *v = s_samples[i].values;
+        int n = snprintf(text, sizeof(text),
+                         "{\"ts\":%lu,\"%s\":%ld.%02ld,\"%s\":%ld.%ld,\"%s\":%ld,\"%s\":%ld}",
+                         (unsigned long)s_samples[i].time_ms,
+                         s_fields[0].name, (long)(v[0] / 100), (long)(v[0] % 100),
+                         s_fields[1].name, (long)(v[1] / 10), (long)(v[1] % 10),
+                         s_fields[2].name, (long)v[2],
+                         s_fields[3].name, (long)v[3]);
+
+        len += (size_t)n + ((i > 0) ? 1u : 0u);
+    }
+    return len;
+}
+
+static void bench_check_sample(const mqtt_telemetry_header_t *header,
+                               uint32_t time_ms,
+                               const int32_t *values,
+                               void *arg)
+{
+    bench_check_t *check = (bench_check_t *)arg;
+    const bench_sample_t *expected = &check->samples[check->decoded];
+
+    if ((header->field_count != BENCH_FIELD_COUNT) ||
+        (time_ms != expected->time_ms) ||
+        (memcmp(values, expected->values, sizeof(expected->values)) != 0)) {
+        check->match = false;
+    }
+    check->decoded++;
+}
+
+/* Bytes per sample, x100 */
+static uint32_t bench_per_sample_x100(size_t len, size_t count)
+{
+    return (uint32_t)((len * 100u) / count);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void telemetry_bench_main(void)
+{
+    const size_t batch_sizes[] = TELEMETRY_BENCH_BATCH_SIZES;
+
+    bench_make_samples(TELEMETRY_BENCH_MAX_BATCH);
+
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        size_t count = batch_sizes[b];
+        mqtt_telemetry_encoder_t encoder;
+        bench_check_t check = { .samples = s_samples, .decoded = 0, .match = true };
+        size_t text_len;
+        size_t binary_len;
+        size_t compressed_len;
+        int32_t decoded;
+
+        if ((count == 0) || (count > TELEMETRY_BENCH_MAX_BATCH)) {
+            continue;
+        }
+
+        text_len = bench_text_length(count);
+
+        (void) mqtt_telemetry_begin(&encoder, &s_schema, s_frame, sizeof(s_frame),
+                                    s_samples[0].time_ms);
+        for (size_t i = 0; i < count; i++) {
+            if (!mqtt_telemetry_add(&encoder, s_samples[i].time_ms, s_samples[i].values)) {
+                check.match = false;
+            }
+        }
+        binary_len = mqtt_telemetry_length(&encoder);
+
+        compressed_len = mqtt_telemetry_compress(s_frame, binary_len,
+                                                 s_compressed, sizeof(s_compressed));
+
+        /* What would be sent is decoded again and compared */
+        if (compressed_len > 0) {
+            decoded = mqtt_telemetry_decode(s_compressed, compressed_len,
+                                            s_scratch, sizeof(s_scratch),
+                                            bench_check_sample, &check);
+        } else {
+            compressed_len = binary_len;
+            decoded = mqtt_telemetry_decode(s_frame, binary_len, NULL, 0,
+                                            bench_check_sample, &check);
+        }
+
+        /* One line per run, so that CI can parse the results */
+        PRINT_MSG(("BENCH telemetry batch=%u text=%u binary=%u compressed=%u "
+                   "bytes/sample text=%lu.%02lu binary=%lu.%02lu compressed=%lu.%02lu ok=%d\n",
+                   (unsigned int)count,
+                   (unsigned int)text_len,
+                   (unsigned int)binary_len,
+                   (unsigned int)compressed_len,
+                   (unsigned long)(bench_per_sample_x100(text_len, count) / 100),
+                   (unsigned long)(bench_per_sample_x100(text_len, count) % 100),
+                   (unsigned long)(bench_per_sample_x100(binary_len, count) / 100),
+                   (unsigned long)(bench_per_sample_x100(binary_len, count) % 100),
+                   (unsigned long)(bench_per_sample_x100(compressed_len, count) / 100),
+                   (unsigned long)(bench_per_sample_x100(compressed_len, count) % 100),
+                   (check.match && (decoded == (int32_t)count)) ? 1 : 0));
+    }
+}
+
+#endif /* FEATURE_BENCHMARK_TELEMETRY */
+
+/* [] END OF FILE */
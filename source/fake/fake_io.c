@@ -0,0 +1,274 @@
+/******************************************************************************
+* File Name:   fake_io.c
+*
+* Description: This file contains stand-ins for the PPP and Wi-Fi connection
+*              managers, so that the MQTT client can be exercised on a board
+*              without a modem. The fake links always come up on loopback;
+*              the broker is reached over the real Wi-Fi (FAKE_IO_WIFI 0).
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "fake_io.h"
+
+#if (VARIANT_MODEM == FAKE_VARIANT)
+
+#include <string.h>
+
+#include "cyabs_rtos.h"
+#include "cy_debug.h"
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "fake_io";
+
+static bool s_pcm_initialized = false;
+static bool s_wcm_initialized = false;
+static bool s_modem_connected = false;
+static bool s_ppp_connected = false;
+static bool s_wifi_connected = false;
+static connectivity_t s_default_io = NO_CONNECTIVITY;
+static cy_modem_mode_t s_modem_mode = CY_MODEM_COMMAND_MODE;
+static cy_pcm_connect_params_t s_ppp_params;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void fake_io_get_ip_address(cy_wcm_ip_address_t *ip_address)
+{
+    if (ip_address != NULL) {
+        memset(ip_address, 0, sizeof(*ip_address));
+        ip_address->version = CY_WCM_IP_VER_V4;
+        ip_address->ip.v4 = FAKE_IO_IP_ADDRESS;
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t fake_pcm_init(cy_pcm_config_t *config,
+                        bool wcm_initialized)
+{
+    (void)wcm_initialized;
+
+    if (config == NULL) {
+        return CY_RSLT_PCM_BAD_ARG;
+    }
+
+    s_default_io = config->default_type;
+    s_pcm_initialized = true;
+
+    CY_LOGD(TAG, "fake PCM initialized (default: %d)", s_default_io);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_pcm_deinit(void)
+{
+    s_pcm_initialized = false;
+    s_modem_connected = false;
+    s_ppp_connected = false;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_pcm_connect_modem(cy_pcm_connect_params_t *params,
+                                 cy_wcm_ip_address_t *ip_address,
+                                 uint32_t timeout_msec)
+{
+    if (!s_pcm_initialized || (params == NULL)) {
+        return CY_RSLT_PCM_FAILED;
+    }
+
+    if ((timeout_msec != CY_RTOS_NEVER_TIMEOUT) &&
+        (timeout_msec < FAKE_IO_CONNECT_DELAY_MSEC)) {
+        return CY_RSLT_PCM_TIMEOUT;
+    }
+
+    cy_rtos_delay_milliseconds(FAKE_IO_CONNECT_DELAY_MSEC);
+
+    memcpy(&s_ppp_params, params, sizeof(s_ppp_params));
+    s_modem_connected = true;
+
+    if (params->connect_ppp) {
+        s_modem_mode = CY_MODEM_PPP_MODE;
+        s_ppp_connected = true;
+        fake_io_get_ip_address(ip_address);
+    } else {
+        s_modem_mode = CY_MODEM_COMMAND_MODE;
+    }
+
+    CY_LOGD(TAG, "fake modem connected (ppp: %d)", params->connect_ppp);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_pcm_disconnect_modem(uint32_t timeout_msec,
+                                    bool power_off)
+{
+    (void)timeout_msec;
+    (void)power_off;
+
+    s_modem_connected = false;
+    s_ppp_connected = false;
+    s_modem_mode = CY_MODEM_COMMAND_MODE;
+    memset(&s_ppp_params, 0, sizeof(s_ppp_params));
+    return CY_RSLT_SUCCESS;
+}
+
+bool fake_pcm_is_ppp_connected(void)
+{
+    return s_ppp_connected;
+}
+
+connectivity_t fake_pcm_get_default_connectivity(void)
+{
+    return s_default_io;
+}
+
+cy_rslt_t fake_pcm_set_default_connectivity(connectivity_t type)
+{
+    s_default_io = type;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_pcm_get_modem_mode(cy_modem_mode_t *mode)
+{
+    if (mode == NULL) {
+        return CY_RSLT_PCM_BAD_ARG;
+    }
+
+    if (!s_modem_connected) {
+        return CY_RSLT_PCM_MODEM_IS_NULL;
+    }
+
+    *mode = s_modem_mode;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_pcm_change_modem_mode(cy_modem_mode_t mode)
+{
+    s_modem_mode = mode;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_wcm_init(cy_wcm_config_t *config)
+{
+    if (config == NULL) {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    s_wcm_initialized = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_wcm_deinit(void)
+{
+    s_wcm_initialized = false;
+    s_wifi_connected = false;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_wcm_connect_ap(const cy_wcm_connect_params_t *params,
+                              cy_wcm_ip_address_t *ip_address)
+{
+    if (!s_wcm_initialized) {
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if (params == NULL) {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    cy_rtos_delay_milliseconds(FAKE_IO_CONNECT_DELAY_MSEC);
+
+    s_wifi_connected = true;
+    fake_io_get_ip_address(ip_address);
+
+    CY_LOGD(TAG, "fake AP '%s' connected", params->ap_credentials.SSID);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t fake_wcm_disconnect_ap(void)
+{
+    s_wifi_connected = false;
+    return CY_RSLT_SUCCESS;
+}
+
+bool fake_wcm_is_connected_to_ap(void)
+{
+    return s_wifi_connected;
+}
+
+cy_rslt_t fake_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info)
+{
+    if (ap_info == NULL) {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if (!s_wifi_connected) {
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    memset(ap_info, 0, sizeof(*ap_info));
+    ap_info->signal_strength = FAKE_IO_WIFI_RSSI_DBM;
+    return CY_RSLT_SUCCESS;
+}
+
+void fake_io_simulate_link_loss(connectivity_t type)
+{
+    if ((type == CELLULAR_CONNECTIVITY) && s_ppp_connected) {
+        CY_LOGD(TAG, "simulating PPP link loss");
+        s_ppp_connected = false;
+
+        if (s_ppp_params.user_ip_lost_fn != NULL) {
+            s_ppp_params.user_ip_lost_fn();
+        }
+
+    } else if (type == WIFI_STA_CONNECTIVITY) {
+#if FAKE_IO_WIFI
+        if (s_wifi_connected) {
+            CY_LOGD(TAG, "simulating Wi-Fi link loss");
+            s_wifi_connected = false;
+        }
+#else
+        /* The Wi-Fi link is real: drop the AP */
+        CY_LOGD(TAG, "disconnecting the real AP");
+        (void)cy_wcm_disconnect_ap();
+#endif
+    }
+}
+
+#endif /* VARIANT_MODEM */
+
+/* [] END OF FILE */
@@ -0,0 +1,129 @@
+/******************************************************************************
+* File Name:   fake_io.h
+*
+* Description: This file is the public interface of fake_io.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_FAKE_IO_H_
+#define SOURCE_FAKE_IO_H_
+
+#include "variant_config.h"  /* for VARIANT_MODEM */
+
+#if (VARIANT_MODEM == FAKE_VARIANT)
+
+#include "cy_pcm.h"
+#include "cy_wcm.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Route the connection manager APIs used by the tasks to the fake links */
+#define cy_pcm_init                         fake_pcm_init
+#define cy_pcm_deinit                       fake_pcm_deinit
+#define cy_pcm_connect_modem                fake_pcm_connect_modem
+#define cy_pcm_disconnect_modem             fake_pcm_disconnect_modem
+#define cy_pcm_is_ppp_connected             fake_pcm_is_ppp_connected
+#define cy_pcm_get_default_connectivity     fake_pcm_get_default_connectivity
+#define cy_pcm_set_default_connectivity     fake_pcm_set_default_connectivity
+#define cy_pcm_get_modem_mode               fake_pcm_get_modem_mode
+#define cy_pcm_change_modem_mode            fake_pcm_change_modem_mode
+
+#if FAKE_IO_WIFI
+#define cy_wcm_init                         fake_wcm_init
+#define cy_wcm_deinit                       fake_wcm_deinit
+#define cy_wcm_connect_ap                   fake_wcm_connect_ap
+#define cy_wcm_disconnect_ap                fake_wcm_disconnect_ap
+#define cy_wcm_is_connected_to_ap           fake_wcm_is_connected_to_ap
+#define cy_wcm_get_associated_ap_info       fake_wcm_get_associated_ap_info
+#endif
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t fake_pcm_init(cy_pcm_config_t *config,
+                        bool wcm_initialized);
+
+cy_rslt_t fake_pcm_deinit(void);
+
+cy_rslt_t fake_pcm_connect_modem(cy_pcm_connect_params_t *params,
+                                 cy_wcm_ip_address_t *ip_address,
+                                 uint32_t timeout_msec);
+
+cy_rslt_t fake_pcm_disconnect_modem(uint32_t timeout_msec,
+                                    bool power_off);
+
+bool fake_pcm_is_ppp_connected(void);
+
+connectivity_t fake_pcm_get_default_connectivity(void);
+
+cy_rslt_t fake_pcm_set_default_connectivity(connectivity_t type);
+
+cy_rslt_t fake_pcm_get_modem_mode(cy_modem_mode_t *mode);
+
+cy_rslt_t fake_pcm_change_modem_mode(cy_modem_mode_t mode);
+
+cy_rslt_t fake_wcm_init(cy_wcm_config_t *config);
+
+cy_rslt_t fake_wcm_deinit(void);
+
+cy_rslt_t fake_wcm_connect_ap(const cy_wcm_connect_params_t *params,
+                              cy_wcm_ip_address_t *ip_address);
+
+cy_rslt_t fake_wcm_disconnect_ap(void);
+
+bool fake_wcm_is_connected_to_ap(void);
+
+cy_rslt_t fake_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info);
+
+/* Drop a fake link as if the carrier / AP went away. Also a console
+ * option of the Manage I/O menu.
+ */
+void fake_io_simulate_link_loss(connectivity_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VARIANT_MODEM */
+
+#endif /* SOURCE_FAKE_IO_H_ */
+
+/* [] END OF FILE */
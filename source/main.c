@@ -49,9 +49,12 @@
 
 #include "wifi_task.h"
 #include "ppp_task.h"
+#include "link_manager_task.h"
+#include "dns_cache_task.h"
 #include "mqtt_task.h"
 #include "console_task.h"
 #include "ble_modem_task.h"
+#include "bringup_timeline.h"
 
 #include "cyabs_rtos.h"
 #include "cy_log.h"
@@ -59,6 +62,7 @@
 
 #include "app_bt_gatt_handler.h"
 #include "cy_modem.h"
+#include "variant_config.h"
 
 /******************************************************************************
 * Global Variables
@@ -109,6 +113,9 @@ int main_thread(void)
     //result = cy_log_init(CY_LOG_PRINTF, NULL, NULL);
     //DEBUG_ASSERT(result == CY_RSLT_SUCCESS);
 
+    // time the stages up to the first MQTT publish
+    bringup_timeline_init();
+
 #if (FEATURE_WIFI == ENABLE_FEATURE)
     result = cy_rtos_create_thread( &g_wifi_task_handle,
                                     wifi_task,
@@ -122,7 +129,8 @@ int main_thread(void)
 
 #endif
 
-#if (FEATURE_PPP == ENABLE_FEATURE) || (FEATURE_BLE_MODEM == ENABLE_FEATURE)
+#if ((FEATURE_PPP == ENABLE_FEATURE) || (FEATURE_BLE_MODEM == ENABLE_FEATURE)) && \
+    (VARIANT_MODEM == HW_VARIANT)
     // modem is required by PPP or BLE feature
     cy_modem_init();
 #endif
@@ -140,6 +148,31 @@ int main_thread(void)
 
 #endif
 
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+    result = cy_rtos_create_thread( &g_link_manager_task_handle,
+                                    link_manager_task,
+                                    LINK_MANAGER_TASK_NAME,
+                                    NULL,
+                                    LINK_MANAGER_TASK_STACK_SIZE,
+                                    LINK_MANAGER_TASK_PRIORITY,
+                                    (cy_thread_arg_t) NULL
+                                  );
+    DEBUG_ASSERT(result == CY_RSLT_SUCCESS);
+#endif
+
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+    result = cy_rtos_create_thread( &g_dns_cache_task_handle,
+                                    dns_cache_task,
+                                    DNS_CACHE_TASK_NAME,
+                                    NULL,
+                                    DNS_CACHE_TASK_STACK_SIZE,
+                                    DNS_CACHE_TASK_PRIORITY,
+                                    (cy_thread_arg_t) NULL
+                                  );
+    DEBUG_ASSERT(result == CY_RSLT_SUCCESS);
+#endif
+
 
 #if (FEATURE_MQTT == ENABLE_FEATURE)
     result = cy_rtos_create_thread( &g_mqtt_task_handle,
@@ -0,0 +1,446 @@
+/******************************************************************************
+* File Name:   mqtt_aggregator.c
+*
+* Description: This file aggregates sensor samples per topic over time windows,
+*              and publishes one telemetry frame per window
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "mqtt_aggregator.h"
+#include "mqtt_telemetry.h"
+#include "publisher_task.h"
+#include "publisher_queue.h"
+
+#include "cyabs_rtos.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define AGGREGATOR_STATS_FIELDS     (5u)
+#define AGGREGATOR_RETRY_MS         (100u)
+
+typedef struct {
+    bool used;
+    mqtt_aggregator_config_t config;
+    mqtt_telemetry_field_t fields[AGGREGATOR_STATS_FIELDS];
+    mqtt_telemetry_schema_t schema;
+
+    /* Current window */
+    uint32_t count;
+    cy_time_t first_time;
+    cy_time_t last_time;
+    int32_t min;
+    int32_t max;
+    int32_t last;
+    int64_t sum;
+    mqtt_telemetry_encoder_t encoder;   /* MQTT_AGGREGATE_RAW */
+
+    /* Frame buffers: 'active' fills while the other one is published */
+    uint8_t active;
+    volatile bool in_flight[2];
+    mqtt_payload_t payload[2];
+    uint8_t frame[2][MQTT_AGGREGATOR_FRAME_SIZE];
+} aggregator_channel_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "aggregator";
+
+static const char *s_stats_names[AGGREGATOR_STATS_FIELDS] =
+{
+    "min", "max", "mean", "last", "count"
+};
+
+static aggregator_channel_t s_channels[MQTT_AGGREGATOR_MAX_CHANNELS];
+static uint8_t s_compressed[MQTT_AGGREGATOR_FRAME_SIZE];
+static mqtt_aggregator_stats_t s_stats;
+
+static cy_mutex_t s_mutex;
+static cy_timer_t s_timer;
+static bool s_initialized = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void aggregator_release_cb(mqtt_payload_t *payload, void *arg)
+{
+    (void)payload;
+    *(volatile bool *)arg = false;
+}
+
+/* Must be called with the mutex held */
+static cy_rslt_t aggregator_flush(aggregator_channel_t *ch)
+{
+    cy_rslt_t result;
+    mqtt_publish_record_t record;
+    uint8_t *frame = ch->frame[ch->active];
+    size_t len;
+
+    if (ch->count == 0) {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (ch->config.mode == MQTT_AGGREGATE_STATS) {
+        int32_t values[AGGREGATOR_STATS_FIELDS];
+        int64_t half = (ch->sum < 0) ? -(int64_t)(ch->count / 2u) : (int64_t)(ch->count / 2u);
+
+        values[0] = ch->min;
+        values[1] = ch->max;
+        values[2] = (int32_t)((ch->sum + half) / (int64_t)ch->count);
+        values[3] = ch->last;
+        values[4] = (int32_t)ch->count;
+
+        mqtt_telemetry_begin(&ch->encoder, &ch->schema, frame,
+                             MQTT_AGGREGATOR_FRAME_SIZE, (uint32_t)ch->first_time);
+        mqtt_telemetry_add(&ch->encoder, (uint32_t)ch->last_time, values);
+    }
+    len = mqtt_telemetry_length(&ch->encoder);
+
+    if (ch->config.compress) {
+        size_t compressed = mqtt_telemetry_compress(frame, len, s_compressed,
+                                                    sizeof(s_compressed));
+        if (compressed > 0) {
+            memcpy(frame, s_compressed, compressed);
+            len = compressed;
+        }
+    }
+
+    /* The ring takes over the reference; the callback frees the buffer. */
+    ch->in_flight[ch->active] = true;
+    mqtt_payload_init(&ch->payload[ch->active], frame, len,
+                      aggregator_release_cb, (void *)&ch->in_flight[ch->active]);
+
+    record.topic = ch->config.topic;
+    record.payload = &ch->payload[ch->active];
+    record.qos = ch->config.qos;
+
+    result = publisher_publish_batch(&record, 1);
+    if (result == CY_RSLT_SUCCESS) {
+        s_stats.published++;
+    } else {
+        CY_LOGD(TAG, "%s: window of %u samples dropped",
+                ch->config.topic, (unsigned int)ch->count);
+        mqtt_payload_release(&ch->payload[ch->active]);
+        s_stats.dropped += ch->count;
+    }
+
+    ch->active ^= 1u;
+    ch->count = 0;
+    return result;
+}
+
+/* Must be called with the mutex held. Arms the timer for the window that
+ * ends first.
+ */
+static void aggregator_arm_timer(void)
+{
+    cy_time_t now = 0;
+    uint32_t wait_ms = UINT32_MAX;
+
+    cy_rtos_get_time(&now);
+
+    for (uint32_t i = 0; i < MQTT_AGGREGATOR_MAX_CHANNELS; i++) {
+        aggregator_channel_t *ch = &s_channels[i];
+
+        if (ch->used && (ch->count > 0)) {
+            uint32_t elapsed = (uint32_t)(now - ch->first_time);
+            uint32_t left = (elapsed < ch->config.window_ms) ? (ch->config.window_ms - elapsed) : 1u;
+
+            if (left < wait_ms) {
+                wait_ms = left;
+            }
+        }
+    }
+
+    cy_rtos_stop_timer(&s_timer);
+    if (wait_ms != UINT32_MAX) {
+        cy_rtos_start_timer(&s_timer, wait_ms);
+    }
+}
+
+/* Runs in the timer task, which must not block: the bulk publisher task
+ * publishes the windows that have ended (see mqtt_aggregator_service()).
+ */
+static void aggregator_timer_cb(cy_timer_callback_arg_t arg)
+{
+    publisher_data_t publisher_q_data;
+
+    (void)arg;
+
+    memset(&publisher_q_data, 0, sizeof(publisher_q_data));
+    publisher_q_data.cmd = PUBLISH_MQTT_AGGREGATE;
+    publisher_q_data.conn = MQTT_CONN_ROUTE(MQTT_CONN_BULK);
+
+    if (publisher_queue_put(&publisher_q_data, false) != CY_RSLT_SUCCESS) {
+        /* Queue full: try again shortly. */
+        cy_rtos_start_timer(&s_timer, AGGREGATOR_RETRY_MS);
+    }
+}
+
+/* Must be called with the mutex held */
+static bool aggregator_open_window(aggregator_channel_t *ch, cy_time_t now)
+{
+    if (ch->in_flight[ch->active]) {
+        /* Both buffers wait for the broker: the ring is backed up. */
+        return false;
+    }
+
+    ch->first_time = now;
+    ch->sum = 0;
+    ch->min = INT32_MAX;
+    ch->max = INT32_MIN;
+
+    if (ch->config.mode == MQTT_AGGREGATE_RAW) {
+        mqtt_telemetry_begin(&ch->encoder, &ch->schema, ch->frame[ch->active],
+                             MQTT_AGGREGATOR_FRAME_SIZE, (uint32_t)now);
+    }
+    return true;
+}
+
+static cy_rslt_t aggregator_init(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (!s_initialized) {
+        result = cy_rtos_init_mutex(&s_mutex);
+        if (result != CY_RSLT_SUCCESS) {
+            CY_LOGE(TAG, "cy_rtos_init_mutex failed!");
+            return result;
+        }
+
+        result = cy_rtos_init_timer(&s_timer, CY_TIMER_TYPE_ONCE,
+                                    aggregator_timer_cb, 0);
+        if (result != CY_RSLT_SUCCESS) {
+            CY_LOGE(TAG, "cy_rtos_init_timer failed!");
+            cy_rtos_deinit_mutex(&s_mutex);
+            return result;
+        }
+        s_initialized = true;
+    }
+    return result;
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_aggregator_register(const mqtt_aggregator_config_t *config,
+                                   mqtt_aggregator_t *channel)
+{
+    cy_rslt_t result;
+    aggregator_channel_t *ch = NULL;
+    uint32_t index;
+
+    if ((config == NULL) || (channel == NULL) || (config->topic == NULL) ||
+        (config->window_ms == 0)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    result = aggregator_init();
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    for (index = 0; index < MQTT_AGGREGATOR_MAX_CHANNELS; index++) {
+        if (!s_channels[index].used) {
+            ch = &s_channels[index];
+            break;
+        }
+    }
+
+    if (ch == NULL) {
+        CY_LOGD(TAG, "no free channel for %s", config->topic);
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+
+    } else {
+        memset(ch, 0, sizeof(*ch));
+        ch->used = true;
+        ch->config = *config;
+
+        if (config->mode == MQTT_AGGREGATE_STATS) {
+            for (uint32_t i = 0; i < AGGREGATOR_STATS_FIELDS; i++) {
+                ch->fields[i].name = s_stats_names[i];
+                ch->fields[i].decimals = config->decimals;
+            }
+            ch->fields[AGGREGATOR_STATS_FIELDS - 1].decimals = 0;
+            ch->schema.field_count = AGGREGATOR_STATS_FIELDS;
+        } else {
+            ch->fields[0].name = "value";
+            ch->fields[0].decimals = config->decimals;
+            ch->schema.field_count = 1;
+        }
+        ch->schema.id = config->schema_id;
+        ch->schema.version = (uint8_t)config->mode;
+        ch->schema.fields = ch->fields;
+
+        *channel = (mqtt_aggregator_t)index;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+cy_rslt_t mqtt_aggregator_add(mqtt_aggregator_t channel, int32_t value)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    aggregator_channel_t *ch;
+    cy_time_t now = 0;
+    bool opened = false;
+
+    if (!s_initialized || (channel >= MQTT_AGGREGATOR_MAX_CHANNELS) ||
+        !s_channels[channel].used) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+    ch = &s_channels[channel];
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    cy_rtos_get_time(&now);
+    s_stats.samples++;
+
+    /* A sample after the end of the window starts the next one. */
+    if ((ch->count > 0) && ((uint32_t)(now - ch->first_time) >= ch->config.window_ms)) {
+        aggregator_flush(ch);
+    }
+
+    if (ch->count == 0) {
+        if (!aggregator_open_window(ch, now)) {
+            result = CY_RSLT_MODULE_MQTT_ERROR;
+        }
+        opened = true;
+    }
+
+    if ((result == CY_RSLT_SUCCESS) && (ch->config.mode == MQTT_AGGREGATE_RAW) &&
+        !mqtt_telemetry_add(&ch->encoder, (uint32_t)now, &value)) {
+        /* The frame is full: send it and start the next window with this
+         * sample.
+         */
+        aggregator_flush(ch);
+        opened = true;
+        if (!aggregator_open_window(ch, now) ||
+            !mqtt_telemetry_add(&ch->encoder, (uint32_t)now, &value)) {
+            result = CY_RSLT_MODULE_MQTT_ERROR;
+        }
+    }
+
+    if (result == CY_RSLT_SUCCESS) {
+        ch->count++;
+        ch->last_time = now;
+        ch->last = value;
+        ch->sum += value;
+        if (value < ch->min) {
+            ch->min = value;
+        }
+        if (value > ch->max) {
+            ch->max = value;
+        }
+
+        if ((ch->config.max_samples > 0) && (ch->count >= ch->config.max_samples)) {
+            aggregator_flush(ch);
+        }
+    } else {
+        s_stats.dropped++;
+    }
+
+    /* Windows only end earlier when a sample opens one. */
+    if (opened) {
+        aggregator_arm_timer();
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+cy_rslt_t mqtt_aggregator_flush(mqtt_aggregator_t channel)
+{
+    cy_rslt_t result;
+
+    if (!s_initialized || (channel >= MQTT_AGGREGATOR_MAX_CHANNELS) ||
+        !s_channels[channel].used) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    result = aggregator_flush(&s_channels[channel]);
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+void mqtt_aggregator_service(void)
+{
+    cy_time_t now = 0;
+
+    if (!s_initialized) {
+        return;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    cy_rtos_get_time(&now);
+
+    for (uint32_t i = 0; i < MQTT_AGGREGATOR_MAX_CHANNELS; i++) {
+        aggregator_channel_t *ch = &s_channels[i];
+
+        if (ch->used && (ch->count > 0) &&
+            ((uint32_t)(now - ch->first_time) >= ch->config.window_ms)) {
+            aggregator_flush(ch);
+        }
+    }
+
+    aggregator_arm_timer();
+    cy_rtos_set_mutex(&s_mutex);
+}
+
+void mqtt_aggregator_get_stats(mqtt_aggregator_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    if (!s_initialized) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    *stats = s_stats;
+    cy_rtos_set_mutex(&s_mutex);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,120 @@
+/******************************************************************************
+* File Name:   mqtt_aggregator.h
+*
+* Description: This file is the public interface of mqtt_aggregator.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_AGGREGATOR_H_
+#define SOURCE_MQTT_AGGREGATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cy_mqtt_api.h"
+#include "mqtt_client_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* What the message of a window holds, as a telemetry frame (see
+ * mqtt_telemetry.h) whose base time is the time of the first sample
+ */
+typedef enum
+{
+    MQTT_AGGREGATE_STATS,       /* one sample: min, max, mean, last, count,
+                                   at the time of the last sample */
+    MQTT_AGGREGATE_RAW,         /* every sample, field "value" */
+} mqtt_aggregate_mode_t;
+
+typedef struct {
+    const char *topic;          /* must stay valid while registered */
+    mqtt_aggregate_mode_t mode;
+    uint32_t window_ms;         /* from the first sample of the window */
+    uint16_t max_samples;       /* flush early at this count, 0 = none */
+    cy_mqtt_qos_t qos;
+    uint8_t schema_id;          /* carried in the frames, the schema
+                                   version is the mode */
+    uint8_t decimals;           /* of the values, see mqtt_telemetry_field_t */
+    bool compress;              /* see mqtt_telemetry_compress() */
+} mqtt_aggregator_config_t;
+
+typedef uint8_t mqtt_aggregator_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t published;         /* messages, one per flushed window */
+    uint32_t dropped;           /* samples lost, e.g. on a full ring */
+} mqtt_aggregator_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* The application has no sensor of its own, so nothing registers a channel:
+ * this module is an API for the sensors added to it.
+ */
+
+/* Register a topic. Its messages go through publisher_publish_batch(). */
+cy_rslt_t mqtt_aggregator_register(const mqtt_aggregator_config_t *config,
+                                   mqtt_aggregator_t *channel);
+
+/* Add a sample, timed now. A full frame buffer or 'max_samples' flush the
+ * window early. Not for ISRs.
+ */
+cy_rslt_t mqtt_aggregator_add(mqtt_aggregator_t channel, int32_t value);
+
+/* Publish the current window now, if it holds samples */
+cy_rslt_t mqtt_aggregator_flush(mqtt_aggregator_t channel);
+
+/* Publish the windows that have ended and re-arm the timer. The timer only
+ * asks for it with a PUBLISH_MQTT_AGGREGATE command, so this runs in the
+ * publisher task of the bulk connection.
+ */
+void mqtt_aggregator_service(void);
+
+void mqtt_aggregator_get_stats(mqtt_aggregator_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_AGGREGATOR_H_ */
+
+/* [] END OF FILE */
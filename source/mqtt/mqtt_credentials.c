@@ -0,0 +1,184 @@
+/******************************************************************************
+* File Name:   mqtt_credentials.c
+*
+* Description: This file caches the TLS credentials of the MQTT connection
+*              as DER, decoded once from the PEM text of mqtt_client_config.h
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "mbedtls/base64.h"
+
+#include "mqtt_credentials.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define PEM_BEGIN       "-----BEGIN "
+#define PEM_END         "-----END "
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "mqtt_credentials";
+
+static uint8_t s_der_cache[MQTT_CREDENTIALS_DER_CACHE_SIZE];
+static size_t s_der_used = 0;
+static bool s_initialized = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/******************************************************************************
+ * Function Name: pem_to_der
+ ******************************************************************************
+ * Summary:
+ *  Function that decodes the base64 body of a PEM credential to the free
+ *  part of the DER cache. mbedTLS tells DER from PEM by the "-----BEGIN"
+ *  text, and parses a single DER object only, so a bundle of certificates
+ *  stays PEM.
+ *
+ * Parameters:
+ *  const char *pem : NUL-terminated PEM text
+ *  size_t pem_size : size of it, NUL included
+ *  size_t *der_size : size of the DER, output
+ *
+ * Return:
+ *  const uint8_t* : the DER in the cache, or NULL if not converted
+ *
+ ******************************************************************************/
+static const uint8_t* pem_to_der(const char *pem, size_t pem_size, size_t *der_size)
+{
+    const char *body;
+    const char *footer;
+    uint8_t *der = &s_der_cache[s_der_used];
+
+    /* PEM is passed NUL-terminated; DER (or nothing) is left as it is. */
+    if ((pem == NULL) || (pem_size == 0) || (pem[pem_size - 1] != '\0')) {
+        return NULL;
+    }
+
+    body = strstr(pem, PEM_BEGIN);
+    if (body == NULL) {
+        return NULL;
+    }
+    body = strchr(body, '\n');
+    if (body == NULL) {
+        return NULL;
+    }
+    body++;
+
+    footer = strstr(body, PEM_END);
+    if ((footer == NULL) ||
+        (strstr(footer, PEM_BEGIN) != NULL) ||  /* several certificates */
+        (strstr(pem, "Proc-Type:") != NULL)) {  /* encrypted key */
+        return NULL;
+    }
+
+    if (0 != mbedtls_base64_decode(der, sizeof(s_der_cache) - s_der_used, der_size,
+                                   (const unsigned char *)body, (size_t)(footer - body))) {
+        return NULL;
+    }
+
+    s_der_used += *der_size;
+    return der;
+}
+
+/******************************************************************************
+ * Function Name: credential_to_der
+ ******************************************************************************
+ * Summary:
+ *  Function that replaces one PEM credential by its DER in the cache, if it
+ *  can be converted.
+ *
+ * Parameters:
+ *  const char **data : credential, updated
+ *  size_t *size : size of the credential, updated
+ *  const char *name : name of the credential for the log
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void credential_to_der(const char **data, size_t *size, const char *name)
+{
+    size_t der_size = 0;
+    const uint8_t *der;
+
+    if (*data == NULL) {
+        return;
+    }
+
+    der = pem_to_der(*data, *size, &der_size);
+    if (der == NULL) {
+        CY_LOGD(TAG, "%s kept as PEM (%u bytes)", name, (unsigned int)*size);
+        return;
+    }
+
+    CY_LOGD(TAG, "%s: PEM %u bytes -> DER %u bytes", name,
+            (unsigned int)*size, (unsigned int)der_size);
+
+    *data = (const char *)der;
+    *size = der_size;
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void mqtt_credentials_init(cy_awsport_ssl_credentials_t *credentials)
+{
+    if ((credentials == NULL) || s_initialized) {
+        return;
+    }
+
+    credential_to_der(&credentials->client_cert, &credentials->client_cert_size,
+                      "Client certificate");
+    credential_to_der(&credentials->private_key, &credentials->private_key_size,
+                      "Private key");
+    credential_to_der(&credentials->root_ca, &credentials->root_ca_size,
+                      "Root CA");
+
+    CY_LOGD(TAG, "DER cache: %u of %u bytes used", (unsigned int)s_der_used,
+            (unsigned int)sizeof(s_der_cache));
+
+    s_initialized = true;
+}
+
+/* [] END OF FILE */
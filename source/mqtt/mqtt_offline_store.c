@@ -0,0 +1,601 @@
+/******************************************************************************
+* File Name:   mqtt_offline_store.c
+*
+* Description: Append-only store of the publishes that could not be sent while
+*              the MQTT connection was down. Records are packed into blocks
+*              held in RAM, or in flash rows when FEATURE_FLASH_EEPROM is
+*              enabled. A flash row is erased once per use, when its block
+*              leaves the log.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cyhal.h"
+
+#include "feature_config.h"
+#include "mqtt_offline_store.h"
+#include "mqtt_client_config.h"
+
+#include "cyabs_rtos.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define STORE_BLOCK_MAGIC       (0x474C514Du)   /* "MQLG" */
+#define STORE_ERASED_MAGIC      (0xFFFFFFFFu)
+
+#if (FEATURE_FLASH_EEPROM == ENABLE_FEATURE)
+#define STORE_BLOCKS            MQTT_OFFLINE_STORE_FLASH_BLOCKS
+#else
+#define STORE_BLOCKS            MQTT_OFFLINE_STORE_RAM_BLOCKS
+#endif
+
+#define STORE_BLOCK_WORDS       (MQTT_OFFLINE_STORE_BLOCK_SIZE / sizeof(uint32_t))
+#define STORE_ALIGN(size)       (((size) + 3u) & ~3u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t checksum;      /* of the bytes after the header */
+    uint16_t count;         /* records in the block */
+    uint16_t used;          /* bytes in the block, header included */
+} store_block_header_t;
+
+typedef struct {
+    uint16_t topic_len;
+    uint16_t payload_len;
+    uint8_t qos;
+    uint8_t reserved[3];
+} store_record_header_t;
+
+#define STORE_HEADER_SIZE       (sizeof(store_block_header_t))
+#define STORE_MAX_RECORD_SIZE   (MQTT_OFFLINE_STORE_BLOCK_SIZE - STORE_HEADER_SIZE)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "offline_store";
+
+static bool s_initialized = false;
+
+#if (FEATURE_FLASH_EEPROM == ENABLE_FEATURE)
+static cyhal_flash_t s_flash;
+#else
+static uint32_t s_ram_blocks[STORE_BLOCKS][STORE_BLOCK_WORDS];
+#endif
+
+/* Committed blocks: s_used of them, starting at s_first */
+static size_t s_first = 0;
+static size_t s_used = 0;
+static uint32_t s_next_seq = 0;
+
+/* The oldest committed block, once replay has started on it */
+static uint32_t s_read_buf[STORE_BLOCK_WORDS];
+static bool s_read_loaded = false;
+static size_t s_read_offset = 0;
+static uint16_t s_read_left = 0;
+
+/* The block being filled; its records can be replayed before it is
+ * committed, s_open_consumed of them already were.
+ */
+static uint32_t s_open_buf[STORE_BLOCK_WORDS];
+static size_t s_open_read_offset = STORE_HEADER_SIZE;
+static uint16_t s_open_consumed = 0;
+static cy_time_t s_open_time = 0;
+
+static mqtt_offline_store_stats_t s_stats;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static store_block_header_t* store_header(uint32_t *buf)
+{
+    return (store_block_header_t *)buf;
+}
+
+static uint32_t store_checksum(const uint32_t *buf)
+{
+    const store_block_header_t *header = (const store_block_header_t *)buf;
+    const uint8_t *bytes = (const uint8_t *)buf;
+    uint32_t sum1 = 0;
+    uint32_t sum2 = 0;
+
+    /* Fletcher-style, catches a row that was only partly programmed */
+    for (size_t i = STORE_HEADER_SIZE; i < header->used; i++) {
+        sum1 = (sum1 + bytes[i]) % 65535u;
+        sum2 = (sum2 + sum1) % 65535u;
+    }
+    return (sum2 << 16) | sum1;
+}
+
+static bool store_block_is_valid(const uint32_t *buf)
+{
+    const store_block_header_t *header = (const store_block_header_t *)buf;
+
+    return (header->magic == STORE_BLOCK_MAGIC) &&
+           (header->used >= STORE_HEADER_SIZE) &&
+           (header->used <= MQTT_OFFLINE_STORE_BLOCK_SIZE) &&
+           (header->checksum == store_checksum(buf));
+}
+
+static void store_open_reset(void)
+{
+    store_block_header_t *header = store_header(s_open_buf);
+
+    memset(s_open_buf, 0xFF, sizeof(s_open_buf));
+    header->magic = STORE_BLOCK_MAGIC;
+    header->count = 0;
+    header->used = STORE_HEADER_SIZE;
+
+    s_open_read_offset = STORE_HEADER_SIZE;
+    s_open_consumed = 0;
+}
+
+/*-- Block backend: flash rows or RAM -------------------------------------*/
+
+#if (FEATURE_FLASH_EEPROM == ENABLE_FEATURE)
+
+static uint32_t store_block_addr(size_t index)
+{
+    return (uint32_t)(MQTT_OFFLINE_STORE_FLASH_ADDR + (index * MQTT_OFFLINE_STORE_BLOCK_SIZE));
+}
+
+static cy_rslt_t store_backend_init(void)
+{
+    cyhal_flash_info_t info;
+    cy_rslt_t result;
+
+    result = cyhal_flash_init(&s_flash);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGE(TAG, "cyhal_flash_init failed!");
+        return result;
+    }
+
+    /* A block has to be exactly one erasable/programmable row */
+    cyhal_flash_get_info(&s_flash, &info);
+    for (uint8_t i = 0; i < info.block_count; i++) {
+        const cyhal_flash_block_info_t *block = &info.blocks[i];
+
+        if ((MQTT_OFFLINE_STORE_FLASH_ADDR >= block->start_address) &&
+            (MQTT_OFFLINE_STORE_FLASH_ADDR < (block->start_address + block->size))) {
+            DEBUG_ASSERT(block->page_size == MQTT_OFFLINE_STORE_BLOCK_SIZE);
+            DEBUG_ASSERT(block->sector_size == MQTT_OFFLINE_STORE_BLOCK_SIZE);
+        }
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static void store_block_read(size_t index, uint32_t *buf)
+{
+    if (cyhal_flash_read(&s_flash, store_block_addr(index), (uint8_t *)buf,
+                         MQTT_OFFLINE_STORE_BLOCK_SIZE) != CY_RSLT_SUCCESS) {
+        memset(buf, 0xFF, MQTT_OFFLINE_STORE_BLOCK_SIZE);
+    }
+}
+
+/* The row was erased when it left the log, so it is only programmed */
+static void store_block_write(size_t index, const uint32_t *buf)
+{
+    if (cyhal_flash_program(&s_flash, store_block_addr(index), buf) != CY_RSLT_SUCCESS) {
+        CY_LOGE(TAG, "cyhal_flash_program failed!");
+    }
+}
+
+static void store_block_erase(size_t index)
+{
+    if (cyhal_flash_erase(&s_flash, store_block_addr(index)) != CY_RSLT_SUCCESS) {
+        CY_LOGE(TAG, "cyhal_flash_erase failed!");
+    }
+}
+
+#else
+
+static cy_rslt_t store_backend_init(void)
+{
+    memset(s_ram_blocks, 0xFF, sizeof(s_ram_blocks));
+    return CY_RSLT_SUCCESS;
+}
+
+static void store_block_read(size_t index, uint32_t *buf)
+{
+    memcpy(buf, s_ram_blocks[index], MQTT_OFFLINE_STORE_BLOCK_SIZE);
+}
+
+static void store_block_write(size_t index, const uint32_t *buf)
+{
+    memcpy(s_ram_blocks[index], buf, MQTT_OFFLINE_STORE_BLOCK_SIZE);
+}
+
+static void store_block_erase(size_t index)
+{
+    memset(s_ram_blocks[index], 0xFF, MQTT_OFFLINE_STORE_BLOCK_SIZE);
+}
+
+#endif
+
+/******************************************************************************
+ * Function Name: store_recover
+ ******************************************************************************
+ * Summary:
+ *  Rebuilds the log from the blocks found in the backend. The committed
+ *  blocks form one circular run of consecutive sequence numbers; anything
+ *  else (e.g. a row torn by a reset) is erased.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void store_recover(void)
+{
+    bool found = false;
+    uint32_t first_seq = 0;
+
+    s_first = 0;
+    s_used = 0;
+    s_next_seq = 0;
+    s_stats.count = 0;
+
+    /* The oldest valid block starts the run */
+    for (size_t i = 0; i < STORE_BLOCKS; i++) {
+        store_block_read(i, s_read_buf);
+
+        if (store_block_is_valid(s_read_buf)) {
+            uint32_t seq = store_header(s_read_buf)->seq;
+
+            if (!found || ((int32_t)(seq - first_seq) < 0)) {
+                first_seq = seq;
+                s_first = i;
+                found = true;
+            }
+        }
+    }
+
+    if (found) {
+        s_next_seq = first_seq;
+
+        for (size_t n = 0; n < STORE_BLOCKS; n++) {
+            size_t index = (s_first + n) % STORE_BLOCKS;
+
+            store_block_read(index, s_read_buf);
+            if (!store_block_is_valid(s_read_buf) ||
+                (store_header(s_read_buf)->seq != s_next_seq)) {
+                break;
+            }
+            s_stats.count += store_header(s_read_buf)->count;
+            s_next_seq++;
+            s_used++;
+        }
+    }
+
+    /* Erase whatever is outside the run */
+    for (size_t n = s_used; n < STORE_BLOCKS; n++) {
+        size_t index = (s_first + n) % STORE_BLOCKS;
+
+        store_block_read(index, s_read_buf);
+        if (store_header(s_read_buf)->magic != STORE_ERASED_MAGIC) {
+            store_block_erase(index);
+        }
+    }
+
+    if (s_stats.count > 0) {
+        CY_LOGI(TAG, "recovered %lu records in %u blocks",
+                (unsigned long)s_stats.count, (unsigned int)s_used);
+    }
+}
+
+/* Erase the oldest committed block; its unreplayed records are lost */
+static void store_drop_oldest_block(void)
+{
+    uint32_t lost;
+
+    if (s_read_loaded) {
+        lost = s_read_left;
+        s_read_loaded = false;
+    } else {
+        store_block_read(s_first, s_read_buf);
+        lost = store_block_is_valid(s_read_buf) ? store_header(s_read_buf)->count : 0;
+    }
+
+    store_block_erase(s_first);
+    s_first = (s_first + 1) % STORE_BLOCKS;
+    s_used--;
+
+    s_stats.dropped += lost;
+    s_stats.count -= lost;
+}
+
+/* Move the open block into the log */
+static void store_commit_open(void)
+{
+    store_block_header_t *header = store_header(s_open_buf);
+
+    if (header->count == 0) {
+        return;
+    }
+
+    if (s_used == STORE_BLOCKS) {
+        store_drop_oldest_block();
+    }
+
+    header->magic = STORE_BLOCK_MAGIC;
+    header->seq = s_next_seq++;
+    header->checksum = store_checksum(s_open_buf);
+
+    store_block_write((s_first + s_used) % STORE_BLOCKS, s_open_buf);
+    s_used++;
+    s_stats.blocks_written++;
+
+    store_open_reset();
+}
+
+/* Reclaim the space of the open-block records that were already replayed */
+static void store_compact_open(void)
+{
+    store_block_header_t *header = store_header(s_open_buf);
+    uint8_t *bytes = (uint8_t *)s_open_buf;
+    size_t consumed_bytes = s_open_read_offset - STORE_HEADER_SIZE;
+
+    if (s_open_consumed == 0) {
+        return;
+    }
+
+    memmove(&bytes[STORE_HEADER_SIZE],
+            &bytes[s_open_read_offset],
+            header->used - s_open_read_offset);
+    header->used -= (uint16_t)consumed_bytes;
+    header->count -= s_open_consumed;
+
+    s_open_read_offset = STORE_HEADER_SIZE;
+    s_open_consumed = 0;
+}
+
+static void store_parse(const uint32_t *buf,
+                        size_t offset,
+                        mqtt_offline_record_t *record)
+{
+    const uint8_t *bytes = (const uint8_t *)buf;
+    const store_record_header_t *header = (const store_record_header_t *)&bytes[offset];
+
+    record->topic = (const char *)&bytes[offset + sizeof(*header)];
+    record->topic_len = header->topic_len;
+    record->payload = &bytes[offset + sizeof(*header) + header->topic_len];
+    record->payload_len = header->payload_len;
+    record->qos = (cy_mqtt_qos_t)header->qos;
+}
+
+static size_t store_record_size(const uint32_t *buf, size_t offset)
+{
+    const store_record_header_t *header =
+        (const store_record_header_t *)&((const uint8_t *)buf)[offset];
+
+    return STORE_ALIGN(sizeof(*header) + header->topic_len + header->payload_len);
+}
+
+/* Load the oldest committed block for replay, skipping corrupt ones */
+static bool store_load_oldest(void)
+{
+    while (!s_read_loaded && (s_used > 0)) {
+        store_block_read(s_first, s_read_buf);
+
+        if (store_block_is_valid(s_read_buf) && (store_header(s_read_buf)->count > 0)) {
+            s_read_loaded = true;
+            s_read_offset = STORE_HEADER_SIZE;
+            s_read_left = store_header(s_read_buf)->count;
+        } else {
+            CY_LOGE(TAG, "skipping corrupt block %u", (unsigned int)s_first);
+            store_block_erase(s_first);
+            s_first = (s_first + 1) % STORE_BLOCKS;
+            s_used--;
+        }
+    }
+    return s_read_loaded;
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_offline_store_init(void)
+{
+    cy_rslt_t result;
+
+    if (s_initialized) {
+        return CY_RSLT_SUCCESS;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    result = store_backend_init();
+    if (result == CY_RSLT_SUCCESS) {
+        store_recover();
+        store_open_reset();
+        s_read_loaded = false;
+        s_initialized = true;
+    }
+    return result;
+}
+
+cy_rslt_t mqtt_offline_store_append(const char *topic,
+                                    const mqtt_payload_t *payload,
+                                    cy_mqtt_qos_t qos)
+{
+    store_block_header_t *header = store_header(s_open_buf);
+    store_record_header_t record;
+    uint8_t *bytes = (uint8_t *)s_open_buf;
+    size_t record_size;
+    cy_time_t now = 0;
+
+    if (!s_initialized || (topic == NULL) || (payload == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.topic_len = (uint16_t)strlen(topic);
+    record.payload_len = (uint16_t)payload->len;
+    record.qos = (uint8_t)qos;
+
+    record_size = STORE_ALIGN(sizeof(record) + record.topic_len + record.payload_len);
+    if ((record_size > STORE_MAX_RECORD_SIZE) || (record.payload_len != payload->len)) {
+        s_stats.rejected++;
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if ((header->used + record_size) > MQTT_OFFLINE_STORE_BLOCK_SIZE) {
+        store_compact_open();
+    }
+    if ((header->used + record_size) > MQTT_OFFLINE_STORE_BLOCK_SIZE) {
+        store_commit_open();
+    }
+
+    cy_rtos_get_time(&now);
+    if (header->count == 0) {
+        s_open_time = now;
+    }
+
+    memcpy(&bytes[header->used], &record, sizeof(record));
+    memcpy(&bytes[header->used + sizeof(record)], topic, record.topic_len);
+    memcpy(&bytes[header->used + sizeof(record) + record.topic_len],
+           payload->data, record.payload_len);
+    header->used += (uint16_t)record_size;
+    header->count++;
+
+    s_stats.stored++;
+    s_stats.count++;
+
+    (void) mqtt_offline_store_poll();
+    return CY_RSLT_SUCCESS;
+}
+
+bool mqtt_offline_store_peek(mqtt_offline_record_t *record)
+{
+    if (!s_initialized || (record == NULL)) {
+        return false;
+    }
+
+    if (store_load_oldest()) {
+        store_parse(s_read_buf, s_read_offset, record);
+        return true;
+    }
+
+    if (s_open_consumed < store_header(s_open_buf)->count) {
+        store_parse(s_open_buf, s_open_read_offset, record);
+        return true;
+    }
+    return false;
+}
+
+void mqtt_offline_store_drop(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+
+    if (store_load_oldest()) {
+        s_read_offset += store_record_size(s_read_buf, s_read_offset);
+        s_read_left--;
+
+        if (s_read_left == 0) {
+            /* Fully replayed; the row is free again */
+            store_block_erase(s_first);
+            s_first = (s_first + 1) % STORE_BLOCKS;
+            s_used--;
+            s_read_loaded = false;
+        }
+
+    } else if (s_open_consumed < store_header(s_open_buf)->count) {
+        s_open_read_offset += store_record_size(s_open_buf, s_open_read_offset);
+        s_open_consumed++;
+
+        if (s_open_consumed == store_header(s_open_buf)->count) {
+            store_open_reset();
+        }
+
+    } else {
+        return;
+    }
+
+    s_stats.replayed++;
+    s_stats.count--;
+}
+
+void mqtt_offline_store_flush(void)
+{
+    if (s_initialized) {
+        store_compact_open();
+        store_commit_open();
+    }
+}
+
+cy_time_t mqtt_offline_store_poll(void)
+{
+#if (FEATURE_FLASH_EEPROM == ENABLE_FEATURE)
+    cy_time_t now = 0;
+    uint32_t age;
+
+    if (!s_initialized || (store_header(s_open_buf)->count == 0)) {
+        return CY_RTOS_NEVER_TIMEOUT;
+    }
+
+    /* Bound what a reset can lose, at the cost of a partly used row */
+    cy_rtos_get_time(&now);
+    age = (uint32_t)(now - s_open_time);
+    if (age >= MQTT_OFFLINE_STORE_FLUSH_MS) {
+        mqtt_offline_store_flush();
+        return CY_RTOS_NEVER_TIMEOUT;
+    }
+    return MQTT_OFFLINE_STORE_FLUSH_MS - age;
+#else
+    return CY_RTOS_NEVER_TIMEOUT;
+#endif
+}
+
+size_t mqtt_offline_store_count(void)
+{
+    return s_stats.count;
+}
+
+void mqtt_offline_store_get_stats(mqtt_offline_store_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
+
+/* [] END OF FILE */
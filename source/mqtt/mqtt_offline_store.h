@@ -0,0 +1,119 @@
+/******************************************************************************
+* File Name:   mqtt_offline_store.h
+*
+* Description: This file is the public interface of mqtt_offline_store.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_OFFLINE_STORE_H_
+#define SOURCE_MQTT_OFFLINE_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cyabs_rtos.h"
+#include "cy_mqtt_api.h"
+#include "mqtt_payload.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* A stored message. The pointers refer to the store's own buffers and stay
+ * valid until the next call into the store.
+ */
+typedef struct {
+    const char *topic;
+    size_t topic_len;
+    const uint8_t *payload;
+    size_t payload_len;
+    cy_mqtt_qos_t qos;
+} mqtt_offline_record_t;
+
+typedef struct {
+    uint32_t stored;
+    uint32_t replayed;
+    uint32_t dropped;       /* oldest records lost to a full store */
+    uint32_t rejected;      /* records larger than a block */
+    uint32_t blocks_written;
+    uint32_t count;         /* records currently held */
+} mqtt_offline_store_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* The store is owned by the publisher task; none of these functions are
+ * thread-safe. With FEATURE_FLASH_EEPROM, init recovers the records that
+ * were written to flash before a reset. Replay progress within a block is
+ * not persisted, so a partly replayed block is replayed again in full.
+ */
+cy_rslt_t mqtt_offline_store_init(void);
+
+/* Copy a message into the log; the oldest block is dropped when full */
+cy_rslt_t mqtt_offline_store_append(const char *topic,
+                                    const mqtt_payload_t *payload,
+                                    cy_mqtt_qos_t qos);
+
+/* Look at the oldest record without removing it */
+bool mqtt_offline_store_peek(mqtt_offline_record_t *record);
+
+/* Remove the oldest record */
+void mqtt_offline_store_drop(void);
+
+/* Commit the partially filled block, so that it survives a reset */
+void mqtt_offline_store_flush(void);
+
+/* Commit the partially filled block once its oldest record has waited
+ * MQTT_OFFLINE_STORE_FLUSH_MS, also when no further message comes. Returns
+ * how long until it is due, or CY_RTOS_NEVER_TIMEOUT (e.g. in RAM).
+ */
+cy_time_t mqtt_offline_store_poll(void);
+
+size_t mqtt_offline_store_count(void);
+
+void mqtt_offline_store_get_stats(mqtt_offline_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_OFFLINE_STORE_H_ */
+
+/* [] END OF FILE */
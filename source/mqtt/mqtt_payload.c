@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   mqtt_payload.c
+*
+* Description: This file contains the reference-counted payload descriptors
+*              that carry publish data to the publisher task without copying.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "mqtt_payload.h"
+
+#include "cyhal.h"
+#include "cy_debug.h"
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void mqtt_payload_init(mqtt_payload_t *payload,
+                       const void *data,
+                       size_t len,
+                       mqtt_payload_release_cb_t release_cb,
+                       void *release_arg)
+{
+    VoidAssert(payload != NULL);
+
+    payload->data = (const uint8_t *)data;
+    payload->len = len;
+    payload->release_cb = release_cb;
+    payload->release_arg = release_arg;
+    payload->ref_count = 1;
+}
+
+mqtt_payload_t* mqtt_payload_retain(mqtt_payload_t *payload)
+{
+    if ((payload != NULL) && (payload->release_cb != NULL)) {
+        uint32_t saved_intr = cyhal_system_critical_section_enter();
+        payload->ref_count++;
+        cyhal_system_critical_section_exit(saved_intr);
+    }
+    return payload;
+}
+
+void mqtt_payload_release(mqtt_payload_t *payload)
+{
+    uint16_t ref_count;
+    uint32_t saved_intr;
+
+    if ((payload == NULL) || (payload->release_cb == NULL)) {
+        return;
+    }
+
+    saved_intr = cyhal_system_critical_section_enter();
+    DEBUG_ASSERT(payload->ref_count > 0);
+    ref_count = --payload->ref_count;
+    cyhal_system_critical_section_exit(saved_intr);
+
+    if (ref_count == 0) {
+        payload->release_cb(payload, payload->release_arg);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   mqtt_payload.h
+*
+* Description: This file is the public interface of mqtt_payload.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_PAYLOAD_H_
+#define SOURCE_MQTT_PAYLOAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+typedef struct mqtt_payload mqtt_payload_t;
+
+/* Called when the last reference to a payload is released. The owner of
+ * the buffer (e.g. a sensor driver) can then reuse or free it.
+ */
+typedef void (*mqtt_payload_release_cb_t)(mqtt_payload_t *payload,
+                                          void *arg);
+
+/* Reference-counted descriptor of a publish payload. The payload is not
+ * copied; 'data' must stay valid until 'release_cb' has been called.
+ * Payloads without a release callback (e.g. string literals) are not
+ * reference-counted.
+ */
+struct mqtt_payload {
+    const uint8_t *data;
+    size_t len;
+    mqtt_payload_release_cb_t release_cb;
+    void *release_arg;
+    volatile uint16_t ref_count;
+};
+
+/* Initializer for a payload that lives forever, e.g. a string literal */
+#define MQTT_PAYLOAD_STATIC_INIT(str)           \
+    {                                           \
+        .data = (const uint8_t *)(str),         \
+        .len = (sizeof(str) - 1),               \
+        .release_cb = NULL,                     \
+        .release_arg = NULL,                    \
+        .ref_count = 1                          \
+    }
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Set up a payload holding one reference, owned by the caller */
+void mqtt_payload_init(mqtt_payload_t *payload,
+                       const void *data,
+                       size_t len,
+                       mqtt_payload_release_cb_t release_cb,
+                       void *release_arg);
+
+/* Take another reference (safe from an ISR) */
+mqtt_payload_t* mqtt_payload_retain(mqtt_payload_t *payload);
+
+/* Drop a reference (safe from an ISR) */
+void mqtt_payload_release(mqtt_payload_t *payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_PAYLOAD_H_ */
+
+/* [] END OF FILE */
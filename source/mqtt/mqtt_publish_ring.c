@@ -0,0 +1,202 @@
+/******************************************************************************
+* File Name:   mqtt_publish_ring.c
+*
+* Description: This file contains the bounded ring of outbound MQTT messages
+*              that the publisher task drains back-to-back.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "mqtt_publish_ring.h"
+#include "mqtt_client_config.h"
+
+#include "cyabs_rtos.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* The records in flight in the publish window can come back, and so can
+ * the one refused by the window, so they keep their slots.
+ */
+#define RING_CAPACITY   (MQTT_PUBLISH_RING_SIZE + MQTT_PUBLISH_WINDOW_SIZE + 1u)
+
+#define RING_INDEX(pos) ((s_head + (pos)) % RING_CAPACITY)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "publish_ring";
+
+static mqtt_publish_record_t s_records[RING_CAPACITY];
+static size_t s_head = 0;     /* next record to publish */
+static size_t s_count = 0;
+static uint32_t s_next_seq = 0;
+static cy_mutex_t s_mutex;
+static bool s_initialized = false;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_publish_ring_init(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (!s_initialized) {
+        result = cy_rtos_init_mutex(&s_mutex);
+
+        if (result == CY_RSLT_SUCCESS) {
+            s_head = 0;
+            s_count = 0;
+            s_initialized = true;
+        } else {
+            CY_LOGE(TAG, "cy_rtos_init_mutex failed!");
+        }
+    }
+    return result;
+}
+
+void mqtt_publish_ring_deinit(void)
+{
+    if (s_initialized) {
+        s_initialized = false;
+        cy_rtos_deinit_mutex(&s_mutex);
+    }
+}
+
+cy_rslt_t mqtt_publish_ring_push(const mqtt_publish_record_t *records,
+                                 size_t count)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (!s_initialized || (records == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if ((s_count + count) > MQTT_PUBLISH_RING_SIZE) {
+        CY_LOGD(TAG, "ring full, batch of %u rejected", (unsigned int)count);
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            size_t tail = RING_INDEX(s_count);
+
+            s_records[tail] = records[i];
+            s_records[tail].seq = s_next_seq++;
+            s_count++;
+        }
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+bool mqtt_publish_ring_peek(mqtt_publish_record_t *record)
+{
+    bool found = false;
+
+    if (!s_initialized || (record == NULL)) {
+        return false;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if (s_count > 0) {
+        *record = s_records[s_head];
+        found = true;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return found;
+}
+
+void mqtt_publish_ring_drop(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if (s_count > 0) {
+        s_head = RING_INDEX(1);
+        s_count--;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+}
+
+cy_rslt_t mqtt_publish_ring_requeue(const mqtt_publish_record_t *record)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    size_t pos = 0;
+
+    if (!s_initialized || (record == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if (s_count >= RING_CAPACITY) {
+        /* More records back than MQTT_PUBLISH_WINDOW_SIZE + 1 */
+        CY_LOGE(TAG, "no slot left for a returned record");
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+
+    } else {
+        /* Records of the window may fail in any order: slide the older
+         * ones down so that the ring stays in push order.
+         */
+        s_head = (s_head + RING_CAPACITY - 1u) % RING_CAPACITY;
+        while ((pos < s_count) &&
+               ((int32_t)(s_records[RING_INDEX(pos + 1u)].seq - record->seq) < 0)) {
+            s_records[RING_INDEX(pos)] = s_records[RING_INDEX(pos + 1u)];
+            pos++;
+        }
+        s_records[RING_INDEX(pos)] = *record;
+        s_count++;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+size_t mqtt_publish_ring_count(void)
+{
+    return s_count;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,101 @@
+/******************************************************************************
+* File Name:   mqtt_publish_ring.h
+*
+* Description: This file is the public interface of mqtt_publish_ring.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_PUBLISH_RING_H_
+#define SOURCE_MQTT_PUBLISH_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_mqtt_api.h"
+#include "mqtt_payload.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* One outbound message. The topic must stay valid until the record has
+ * been published; the ring takes over the caller's payload reference.
+ */
+typedef struct {
+    const char *topic;          /* NULL = MQTT_PUB_TOPIC */
+    mqtt_payload_t *payload;
+    cy_mqtt_qos_t qos;
+    uint32_t seq;               /* set by mqtt_publish_ring_push() */
+} mqtt_publish_record_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_publish_ring_init(void);
+
+void mqtt_publish_ring_deinit(void);
+
+/* Append all 'count' records, or none of them if the ring lacks space
+ * (the caller then keeps its payload references)
+ */
+cy_rslt_t mqtt_publish_ring_push(const mqtt_publish_record_t *records,
+                                 size_t count);
+
+/* Look at the oldest record without removing it */
+bool mqtt_publish_ring_peek(mqtt_publish_record_t *record);
+
+/* Remove the oldest record, without releasing its payload */
+void mqtt_publish_ring_drop(void);
+
+/* Put back a record taken from the ring that could not be published,
+ * ahead of the records pushed after it. The records in flight have slots
+ * of their own, so this only fails for a record that never was in the ring.
+ */
+cy_rslt_t mqtt_publish_ring_requeue(const mqtt_publish_record_t *record);
+
+size_t mqtt_publish_ring_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_PUBLISH_RING_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,321 @@
+/******************************************************************************
+* File Name:   mqtt_publish_window.c
+*
+* Description: This file keeps several MQTT publishes in flight at once, so that
+*              their acknowledgements overlap
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_publish_window.h"
+#include "mqtt_client_config.h"
+#include "core_mqtt_config.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#if (MQTT_PUBLISH_WINDOW_SIZE > MQTT_STATE_ARRAY_MAX_COUNT)
+#error "MQTT_PUBLISH_WINDOW_SIZE exceeds the MQTT_STATE_ARRAY_MAX_COUNT of the MQTT library"
+#endif
+
+typedef struct {
+#if (MQTT_PUBLISH_WINDOW_SIZE > 1)
+    cy_thread_t thread;
+    cy_semaphore_t start;
+    char name[sizeof(MQTT_PUBLISH_WINDOW_TASK_NAME) + 4];
+#endif
+    cy_mqtt_t mqtt_handle;
+    mqtt_publish_record_t record;
+    cy_mqtt_publish_info_t publish_info;
+    bool busy;
+} window_slot_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "publish_window";
+
+static window_slot_t s_slots[MQTT_PUBLISH_WINDOW_SIZE];
+
+/* Counts the free slots */
+static cy_semaphore_t s_free;
+static cy_mutex_t s_mutex;
+
+/* Set by the last slot to finish once the window is stopped */
+static cy_semaphore_t s_idle;
+static bool s_stopped = false;
+
+static mqtt_publish_window_cb_t s_complete_cb = NULL;
+static void *s_complete_arg = NULL;
+static mqtt_publish_window_stats_t s_stats;
+static bool s_initialized = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* Publishes the record of 'slot', then frees the slot */
+static void window_publish(window_slot_t *slot)
+{
+    cy_rslt_t result;
+    bool idle;
+
+    /* Blocks until the broker acknowledges the message */
+    result = cy_mqtt_publish(slot->mqtt_handle, &slot->publish_info);
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    if (result == CY_RSLT_SUCCESS) {
+        s_stats.completed++;
+    } else {
+        s_stats.failed++;
+    }
+    cy_rtos_set_mutex(&s_mutex);
+
+    /* Report before freeing the slot, so that a failure is seen before the
+     * next submission, and a failed record is back in the ring before
+     * mqtt_publish_window_stop() returns.
+     */
+    s_complete_cb(result, &slot->record, s_complete_arg);
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    slot->busy = false;
+    s_stats.in_flight--;
+    idle = s_stopped && (s_stats.in_flight == 0);
+    cy_rtos_set_mutex(&s_mutex);
+
+    cy_rtos_set_semaphore(&s_free, false);
+    if (idle) {
+        cy_rtos_set_semaphore(&s_idle, false);
+    }
+}
+
+#if (MQTT_PUBLISH_WINDOW_SIZE > 1)
+static void window_slot_task(cy_thread_arg_t arg)
+{
+    window_slot_t *slot = (window_slot_t *)arg;
+
+    while (true)
+    {
+        if (cy_rtos_get_semaphore(&slot->start, CY_RTOS_NEVER_TIMEOUT, false) == CY_RSLT_SUCCESS) {
+            window_publish(slot);
+        }
+    }
+}
+#endif
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_publish_window_init(mqtt_publish_window_cb_t complete_cb,
+                                   void *arg)
+{
+    cy_rslt_t result;
+
+    if (s_initialized) {
+        /* Restart of the app: the slots were stopped by the MQTT task */
+        mqtt_publish_window_start();
+        return CY_RSLT_SUCCESS;
+    }
+    if (complete_cb == NULL) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    s_complete_cb = complete_cb;
+    s_complete_arg = arg;
+    s_stopped = false;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    result = cy_rtos_init_mutex(&s_mutex);
+    if (result == CY_RSLT_SUCCESS) {
+        result = cy_rtos_init_semaphore(&s_free, MQTT_PUBLISH_WINDOW_SIZE,
+                                        MQTT_PUBLISH_WINDOW_SIZE);
+    }
+    if (result == CY_RSLT_SUCCESS) {
+        result = cy_rtos_init_semaphore(&s_idle, 1, 0);
+    }
+
+    for (uint32_t i = 0; (result == CY_RSLT_SUCCESS) && (i < MQTT_PUBLISH_WINDOW_SIZE); i++) {
+        window_slot_t *slot = &s_slots[i];
+
+        slot->busy = false;
+        slot->publish_info.retain = false;
+        slot->publish_info.dup = false;
+
+#if (MQTT_PUBLISH_WINDOW_SIZE > 1)
+        snprintf(slot->name, sizeof(slot->name), "%s %u",
+                 MQTT_PUBLISH_WINDOW_TASK_NAME, (unsigned int)(i + 1));
+
+        result = cy_rtos_init_semaphore(&slot->start, 1, 0);
+        if (result == CY_RSLT_SUCCESS) {
+            result = cy_rtos_create_thread(&slot->thread,
+                                           window_slot_task,
+                                           slot->name,
+                                           NULL,
+                                           MQTT_PUBLISH_WINDOW_TASK_STACK_SIZE,
+                                           MQTT_PUBLISH_WINDOW_TASK_PRIORITY,
+                                           (cy_thread_arg_t)slot);
+        }
+#endif
+    }
+
+    if (result == CY_RSLT_SUCCESS) {
+        s_initialized = true;
+    } else {
+        CY_LOGE(TAG, "failed to create the publish window!");
+    }
+    return result;
+}
+
+cy_rslt_t mqtt_publish_window_submit(cy_mqtt_t mqtt_handle,
+                                     const mqtt_publish_record_t *record,
+                                     cy_time_t timeout_ms)
+{
+    window_slot_t *slot = NULL;
+    const char *topic;
+
+    if (!s_initialized || (record == NULL) || (record->payload == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (cy_rtos_get_semaphore(&s_free, timeout_ms, false) != CY_RSLT_SUCCESS) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    if (s_stopped) {
+        cy_rtos_set_mutex(&s_mutex);
+        cy_rtos_set_semaphore(&s_free, false);
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    for (uint32_t i = 0; i < MQTT_PUBLISH_WINDOW_SIZE; i++) {
+        if (!s_slots[i].busy) {
+            slot = &s_slots[i];
+            slot->busy = true;
+            break;
+        }
+    }
+
+    s_stats.in_flight++;
+    if (s_stats.in_flight > s_stats.peak) {
+        s_stats.peak = s_stats.in_flight;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+
+    /* The semaphore counts the free slots, so there is one. */
+    DEBUG_ASSERT(slot != NULL);
+
+    topic = (record->topic != NULL) ? record->topic : MQTT_PUB_TOPIC;
+
+    slot->mqtt_handle = mqtt_handle;
+    slot->record = *record;
+    slot->publish_info.qos = record->qos;
+    slot->publish_info.topic = topic;
+    slot->publish_info.topic_len = (uint16_t)strlen(topic);
+    slot->publish_info.payload = (const char *)record->payload->data;
+    slot->publish_info.payload_len = record->payload->len;
+
+    CY_LOGD(TAG, "slot %u: publishing %u bytes on the topic '%s'",
+            (unsigned int)(slot - s_slots), (unsigned int)record->payload->len, topic);
+
+#if (MQTT_PUBLISH_WINDOW_SIZE > 1)
+    cy_rtos_set_semaphore(&slot->start, false);
+#else
+    window_publish(slot);
+#endif
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t mqtt_publish_window_stop(cy_time_t timeout_ms)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t in_flight;
+
+    if (!s_initialized) {
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Clear the wakeup of an earlier stop */
+    (void) cy_rtos_get_semaphore(&s_idle, 0, false);
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    s_stopped = true;
+    in_flight = s_stats.in_flight;
+    cy_rtos_set_mutex(&s_mutex);
+
+    if (in_flight > 0) {
+        CY_LOGD(TAG, "waiting for %u messages in flight", (unsigned int)in_flight);
+        result = cy_rtos_get_semaphore(&s_idle, timeout_ms, false);
+        if (result != CY_RSLT_SUCCESS) {
+            CY_LOGE(TAG, "messages still in flight after %u ms", (unsigned int)timeout_ms);
+        }
+    }
+    return result;
+}
+
+void mqtt_publish_window_start(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    s_stopped = false;
+    cy_rtos_set_mutex(&s_mutex);
+}
+
+void mqtt_publish_window_get_stats(mqtt_publish_window_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    if (!s_initialized) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    *stats = s_stats;
+    cy_rtos_set_mutex(&s_mutex);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,122 @@
+/******************************************************************************
+* File Name:   mqtt_publish_window.h
+*
+* Description: This file is the public interface of mqtt_publish_window.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_PUBLISH_WINDOW_H_
+#define SOURCE_MQTT_PUBLISH_WINDOW_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cyabs_rtos.h"
+#include "cy_mqtt_api.h"
+#include "mqtt_publish_ring.h"
+#include "mqtt_client_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* cy_mqtt_publish() returns once a QoS1/QoS2 message is acknowledged, so
+ * one caller has a single message in flight. With a MQTT_PUBLISH_WINDOW_SIZE
+ * above 1, the window runs that many slot tasks ("Publish window 1", ...),
+ * each blocked in its own cy_mqtt_publish(); the MQTT library matches the
+ * PUBACK/PUBREC to the packet id of each one. With 1, the submitting task
+ * publishes the record itself.
+ */
+#define MQTT_PUBLISH_WINDOW_TASK_NAME         "Publish window"
+#define MQTT_PUBLISH_WINDOW_TASK_PRIORITY     CY_RTOS_PRIORITY_LOW
+#define MQTT_PUBLISH_WINDOW_TASK_STACK_SIZE   (1024 * 2)
+
+/* How long mqtt_publish_window_stop() waits for the messages in flight;
+ * each cy_mqtt_publish() gives up after MQTT_TIMEOUT_MS.
+ */
+#define MQTT_PUBLISH_WINDOW_STOP_TIMEOUT_MS   (MQTT_TIMEOUT_MS * 2)
+
+/* Called by the slot task once the message is acknowledged (or sent, for
+ * QoS0), or has failed. The record, and its payload reference, are the
+ * callback's.
+ */
+typedef void (*mqtt_publish_window_cb_t)(cy_rslt_t result,
+                                         const mqtt_publish_record_t *record,
+                                         void *arg);
+
+typedef struct {
+    uint32_t in_flight;
+    uint32_t peak;              /* most messages in flight at once */
+    uint32_t completed;
+    uint32_t failed;
+} mqtt_publish_window_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Create the slot tasks, or start the window again once created */
+cy_rslt_t mqtt_publish_window_init(mqtt_publish_window_cb_t complete_cb,
+                                   void *arg);
+
+/* Publish 'record' on a free slot, waiting up to 'timeout_ms' for one.
+ * The window takes over the record on success; its topic must stay valid
+ * until the callback. Fails while the window is stopped.
+ */
+cy_rslt_t mqtt_publish_window_submit(cy_mqtt_t mqtt_handle,
+                                     const mqtt_publish_record_t *record,
+                                     cy_time_t timeout_ms);
+
+/* Refuse new records and wait up to 'timeout_ms' until the messages in
+ * flight have returned and their callbacks have run. Call it before the
+ * MQTT connection is disconnected or its publisher task deleted.
+ */
+cy_rslt_t mqtt_publish_window_stop(cy_time_t timeout_ms);
+
+/* Accept records again, after the reconnection */
+void mqtt_publish_window_start(void);
+
+void mqtt_publish_window_get_stats(mqtt_publish_window_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_PUBLISH_WINDOW_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,148 @@
+/******************************************************************************
+* File Name:   mqtt_rx_pool.c
+*
+* Description: Fixed pool of slabs that received MQTT messages are copied into,
+*              so that they can be handled outside the MQTT library thread.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cyhal.h"
+
+#include "mqtt_rx_pool.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static mqtt_rx_msg_t s_slabs[MQTT_RX_SLAB_COUNT];
+static mqtt_rx_msg_t *s_free = NULL;
+static mqtt_rx_pool_stats_t s_stats;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void mqtt_rx_pool_init(void)
+{
+    uint32_t state = cyhal_system_critical_section_enter();
+
+    s_free = NULL;
+    for (size_t i = 0; i < MQTT_RX_SLAB_COUNT; i++) {
+        s_slabs[i].next = s_free;
+        s_free = &s_slabs[i];
+    }
+    s_stats.in_use = 0;
+
+    cyhal_system_critical_section_exit(state);
+}
+
+mqtt_rx_msg_t* mqtt_rx_pool_copy(const cy_mqtt_publish_info_t *msg)
+{
+    mqtt_rx_msg_t *slab = NULL;
+    uint32_t state;
+
+    if (msg == NULL) {
+        return NULL;
+    }
+
+    state = cyhal_system_critical_section_enter();
+
+    if ((msg->topic_len + msg->payload_len) > s_stats.largest) {
+        s_stats.largest = msg->topic_len + msg->payload_len;
+    }
+
+    if ((msg->topic_len + msg->payload_len) > MQTT_RX_SLAB_SIZE) {
+        s_stats.too_big++;
+
+    } else if (s_free == NULL) {
+        s_stats.no_slab++;
+
+    } else {
+        slab = s_free;
+        s_free = slab->next;
+
+        s_stats.copied++;
+        s_stats.in_use++;
+        if (s_stats.in_use > s_stats.peak_in_use) {
+            s_stats.peak_in_use = s_stats.in_use;
+        }
+    }
+
+    cyhal_system_critical_section_exit(state);
+
+    if (slab != NULL) {
+        /* The one copy out of the network buffer */
+        slab->info = *msg;
+        memcpy(slab->data, msg->topic, msg->topic_len);
+        memcpy(&slab->data[msg->topic_len], msg->payload, msg->payload_len);
+        slab->info.topic = (const char *)slab->data;
+        slab->info.payload = (const char *)&slab->data[msg->topic_len];
+        slab->next = NULL;
+    }
+    return slab;
+}
+
+void mqtt_rx_pool_free(mqtt_rx_msg_t *slab)
+{
+    uint32_t state;
+
+    if (slab == NULL) {
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    slab->next = s_free;
+    s_free = slab;
+    s_stats.in_use--;
+    cyhal_system_critical_section_exit(state);
+}
+
+void mqtt_rx_pool_get_stats(mqtt_rx_pool_stats_t *stats)
+{
+    uint32_t state;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    *stats = s_stats;
+    cyhal_system_critical_section_exit(state);
+}
+
+/* [] END OF FILE */
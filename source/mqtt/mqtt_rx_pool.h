@@ -0,0 +1,97 @@
+/******************************************************************************
+* File Name:   mqtt_rx_pool.h
+*
+* Description: This file is the public interface of mqtt_rx_pool.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_RX_POOL_H_
+#define SOURCE_MQTT_RX_POOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_mqtt_api.h"
+#include "mqtt_client_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* A received message copied out of the MQTT library's network buffer.
+ * 'info.topic' and 'info.payload' point into 'data'.
+ */
+typedef struct mqtt_rx_msg {
+    cy_mqtt_publish_info_t info;
+    struct mqtt_rx_msg *next;       /* free list */
+    uint8_t data[MQTT_RX_SLAB_SIZE];
+} mqtt_rx_msg_t;
+
+typedef struct {
+    uint32_t copied;
+    uint32_t no_slab;               /* pool exhausted */
+    uint32_t too_big;               /* topic + payload > MQTT_RX_SLAB_SIZE */
+    uint32_t largest;               /* largest topic + payload received */
+    uint16_t in_use;
+    uint16_t peak_in_use;
+} mqtt_rx_pool_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Put every slab back in the pool */
+void mqtt_rx_pool_init(void);
+
+/* Copy a message into a free slab; NULL if there is none or it is too big.
+ * Never blocks.
+ */
+mqtt_rx_msg_t* mqtt_rx_pool_copy(const cy_mqtt_publish_info_t *msg);
+
+void mqtt_rx_pool_free(mqtt_rx_msg_t *slab);
+
+void mqtt_rx_pool_get_stats(mqtt_rx_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_RX_POOL_H_ */
+
+/* [] END OF FILE */
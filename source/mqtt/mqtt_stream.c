@@ -0,0 +1,269 @@
+/******************************************************************************
+* File Name:   mqtt_stream.c
+*
+* Description: This file follows payloads streamed in chunks over several
+*              MQTT messages, and passes each chunk to its stream handler
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cyhal.h"
+
+#include "mqtt_stream.h"
+#include "mqtt_topic_trie.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+typedef struct {
+    const char *filter;             /* NULL: free slot */
+    mqtt_stream_handler_t handler;
+    void *arg;
+
+    /* Stream being followed */
+    bool active;
+    uint32_t stream_id;
+    uint32_t next_offset;
+    uint32_t total;
+} stream_slot_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "mqtt_stream";
+
+static stream_slot_t s_slots[MQTT_STREAM_MAX_HANDLERS];
+static mqtt_stream_stats_t s_stats;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/******************************************************************************
+ * Function Name: stream_abort
+ ******************************************************************************
+ * Summary:
+ *  Function that stops following the current stream of a slot, and tells
+ *  its handler.
+ *
+ * Parameters:
+ *  stream_slot_t *slot : the registration
+ *  mqtt_stream_chunk_t *chunk : the chunk that aborts the stream
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void stream_abort(stream_slot_t *slot, mqtt_stream_chunk_t *chunk)
+{
+    CY_LOGD(TAG, "stream %lu on '%.*s' aborted at %lu of %lu",
+            (unsigned long)slot->stream_id, (int)chunk->topic_len, chunk->topic,
+            (unsigned long)slot->next_offset, (unsigned long)slot->total);
+
+    chunk->stream_id = slot->stream_id;
+    chunk->offset = slot->next_offset;
+    chunk->total = slot->total;
+    chunk->data = NULL;
+    chunk->len = 0;
+    slot->handler(chunk, slot->arg);
+
+    slot->active = false;
+    s_stats.aborted++;
+}
+
+/******************************************************************************
+ * Function Name: stream_dispatch
+ ******************************************************************************
+ * Summary:
+ *  Topic trie handler of the stream registrations: checks the position of a
+ *  chunk message against the stream being followed, and passes it on.
+ *
+ * Parameters:
+ *  const cy_mqtt_publish_info_t *msg : the chunk message
+ *  void *arg : the stream_slot_t of the registration
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void stream_dispatch(const cy_mqtt_publish_info_t *msg, void *arg)
+{
+    stream_slot_t *slot = (stream_slot_t *)arg;
+    const uint8_t *payload = (const uint8_t *)msg->payload;
+    mqtt_stream_chunk_t chunk;
+
+    if (msg->payload_len < MQTT_STREAM_HEADER_SIZE) {
+        s_stats.ignored++;
+        return;
+    }
+
+    chunk.topic = msg->topic;
+    chunk.topic_len = msg->topic_len;
+    chunk.stream_id = get_be32(&payload[0]);
+    chunk.offset = get_be32(&payload[4]);
+    chunk.total = get_be32(&payload[8]);
+    chunk.data = &payload[MQTT_STREAM_HEADER_SIZE];
+    chunk.len = msg->payload_len - MQTT_STREAM_HEADER_SIZE;
+
+    if ((chunk.offset > chunk.total) || (chunk.len > (chunk.total - chunk.offset))) {
+        s_stats.ignored++;
+        return;
+    }
+
+    if (slot->active && (chunk.stream_id == slot->stream_id)) {
+        if (chunk.offset < slot->next_offset) {
+            s_stats.duplicates++;
+            return;
+        }
+        if (chunk.offset > slot->next_offset) {
+            /* A chunk in between was lost. */
+            stream_abort(slot, &chunk);
+            return;
+        }
+    } else if (chunk.offset == 0) {
+        if (slot->active) {
+            /* A new stream replaces the incomplete one. */
+            mqtt_stream_chunk_t aborted = chunk;
+
+            stream_abort(slot, &aborted);
+        }
+        slot->active = true;
+        slot->stream_id = chunk.stream_id;
+        slot->next_offset = 0;
+        slot->total = chunk.total;
+    } else {
+        /* Rest of a stream that was aborted, or whose start was missed */
+        s_stats.ignored++;
+        return;
+    }
+
+    s_stats.chunks++;
+    slot->next_offset += chunk.len;
+    if (slot->next_offset == slot->total) {
+        slot->active = false;
+        s_stats.completed++;
+    }
+
+    slot->handler(&chunk, slot->arg);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_stream_register(const char *filter,
+                               cy_mqtt_qos_t qos,
+                               mqtt_stream_handler_t handler,
+                               void *arg)
+{
+    stream_slot_t *slot = NULL;
+    cy_rslt_t result;
+    uint32_t state;
+
+    if ((filter == NULL) || (handler == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    state = cyhal_system_critical_section_enter();
+
+    /* Registering a filter again replaces its handler, as in the trie. */
+    for (size_t i = 0; i < MQTT_STREAM_MAX_HANDLERS; i++) {
+        if ((s_slots[i].filter != NULL) && (strcmp(s_slots[i].filter, filter) == 0)) {
+            slot = &s_slots[i];
+            break;
+        }
+    }
+    for (size_t i = 0; (i < MQTT_STREAM_MAX_HANDLERS) && (slot == NULL); i++) {
+        if (s_slots[i].filter == NULL) {
+            slot = &s_slots[i];
+        }
+    }
+    if (slot != NULL) {
+        memset(slot, 0, sizeof(*slot));
+        slot->filter = filter;
+        slot->handler = handler;
+        slot->arg = arg;
+    }
+    cyhal_system_critical_section_exit(state);
+
+    if (slot == NULL) {
+        CY_LOGE(TAG, "no free stream slot for '%s'", filter);
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    result = mqtt_topic_trie_init();
+    if (result == CY_RSLT_SUCCESS) {
+        result = mqtt_topic_trie_add(filter, qos, stream_dispatch, slot);
+    }
+    if (result != CY_RSLT_SUCCESS) {
+        slot->filter = NULL;
+    }
+    return result;
+}
+
+cy_rslt_t mqtt_stream_unregister(const char *filter)
+{
+    cy_rslt_t result = CY_RSLT_MODULE_MQTT_ERROR;
+
+    if (filter == NULL) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    for (size_t i = 0; i < MQTT_STREAM_MAX_HANDLERS; i++) {
+        if ((s_slots[i].filter != NULL) && (strcmp(s_slots[i].filter, filter) == 0)) {
+            result = mqtt_topic_trie_remove(filter);
+            s_slots[i].filter = NULL;
+            break;
+        }
+    }
+    return result;
+}
+
+void mqtt_stream_get_stats(mqtt_stream_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,117 @@
+/******************************************************************************
+* File Name:   mqtt_stream.h
+*
+* Description: This file is the public interface of mqtt_stream.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_STREAM_H_
+#define SOURCE_MQTT_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_mqtt_api.h"
+#include "mqtt_client_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* A payload larger than the network buffer is published as a stream of
+ * chunk messages on one topic, in order. Each chunk message carries this
+ * header, big-endian, followed by its part of the payload:
+ *   uint32_t stream_id : same for all the chunks of a stream
+ *   uint32_t offset    : position of the part in the payload
+ *   uint32_t total     : size of the whole payload
+ * A chunk message, topic included, must fit in MQTT_RX_SLAB_SIZE.
+ */
+#define MQTT_STREAM_HEADER_SIZE         (12u)
+
+typedef struct {
+    const char *topic;
+    uint16_t topic_len;
+    uint32_t stream_id;
+    uint32_t offset;
+    uint32_t total;
+    const uint8_t *data;            /* NULL: the stream is aborted */
+    size_t len;
+} mqtt_stream_chunk_t;
+
+/* Called on the subscriber task with the chunks of a stream, in order of
+ * offset and each once. When a chunk is lost, or a new stream starts before
+ * the current one is complete, it is called once with 'data' NULL, and the
+ * rest of that stream is ignored.
+ */
+typedef void (*mqtt_stream_handler_t)(const mqtt_stream_chunk_t *chunk,
+                                      void *arg);
+
+typedef struct {
+    uint32_t chunks;
+    uint32_t completed;
+    uint32_t aborted;
+    uint32_t duplicates;            /* QoS 1 redeliveries, skipped */
+    uint32_t ignored;               /* malformed, or of an aborted stream */
+} mqtt_stream_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Register a stream handler for a topic filter in the topic trie. One
+ * stream at a time is followed per registration. The filter string must
+ * stay valid while it is registered. Registering a filter again replaces
+ * its handler, and drops the stream being followed.
+ */
+cy_rslt_t mqtt_stream_register(const char *filter,
+                               cy_mqtt_qos_t qos,
+                               mqtt_stream_handler_t handler,
+                               void *arg);
+
+cy_rslt_t mqtt_stream_unregister(const char *filter);
+
+void mqtt_stream_get_stats(mqtt_stream_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_STREAM_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,418 @@
+/******************************************************************************
+* File Name:   mqtt_telemetry.c
+*
+* Description: This file encodes telemetry samples into compact binary frames,
+*              compresses them, and decodes them again
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "mqtt_telemetry.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define TELEMETRY_FIXED_HEADER_SIZE     (4u)
+
+#define LZ_WINDOW_SIZE                  (256u)
+#define LZ_MIN_MATCH                    (3u)
+#define LZ_MAX_MATCH                    (LZ_MIN_MATCH + 255u)
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* Returns the number of bytes written, 0 if they do not fit */
+static size_t telemetry_put_varint(uint8_t *buf, size_t size, uint32_t value)
+{
+    size_t len = 0;
+
+    do {
+        if (len >= size) {
+            return 0;
+        }
+        buf[len] = (uint8_t)(value & 0x7Fu);
+        value >>= 7;
+        if (value != 0) {
+            buf[len] |= 0x80u;
+        }
+        len++;
+    } while (value != 0);
+
+    return len;
+}
+
+/* Returns the number of bytes read, 0 if the varint is malformed */
+static size_t telemetry_get_varint(const uint8_t *buf, size_t size, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (size_t i = 0; (i < size) && (i < 5u); i++) {
+        result |= (uint32_t)(buf[i] & 0x7Fu) << (7u * i);
+        if ((buf[i] & 0x80u) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t telemetry_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t telemetry_unzigzag(uint32_t value)
+{
+    return (int32_t)((value >> 1) ^ (0u - (value & 1u)));
+}
+
+/* Returns the compressed length, 0 if it does not fit in 'size' */
+static size_t lz_compress(const uint8_t *in, size_t len, uint8_t *out, size_t size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    size_t control = 0;
+    uint8_t bit = 8;
+
+    while (i < len) {
+        size_t best_len = 0;
+        size_t best_dist = 0;
+        size_t start = (i > LZ_WINDOW_SIZE) ? (i - LZ_WINDOW_SIZE) : 0;
+
+        if (bit == 8) {
+            if (o >= size) {
+                return 0;
+            }
+            control = o;
+            out[o++] = 0;
+            bit = 0;
+        }
+
+        for (size_t j = start; j < i; j++) {
+            size_t match = 0;
+
+            while (((i + match) < len) && (match < LZ_MAX_MATCH) &&
+                   (in[j + match] == in[i + match])) {
+                match++;
+            }
+            if (match > best_len) {
+                best_len = match;
+                best_dist = i - j;
+            }
+        }
+
+        if (best_len >= LZ_MIN_MATCH) {
+            if ((o + 2) > size) {
+                return 0;
+            }
+            out[control] |= (uint8_t)(1u << bit);
+            out[o++] = (uint8_t)(best_dist - 1);
+            out[o++] = (uint8_t)(best_len - LZ_MIN_MATCH);
+            i += best_len;
+        } else {
+            if (o >= size) {
+                return 0;
+            }
+            out[o++] = in[i++];
+        }
+        bit++;
+    }
+    return o;
+}
+
+/* Returns the decompressed length, or SIZE_MAX if 'in' is malformed or
+ * does not fit in 'size'
+ */
+static size_t lz_decompress(const uint8_t *in, size_t len, uint8_t *out, size_t size)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        uint8_t control = in[i++];
+
+        for (uint8_t bit = 0; (bit < 8) && (i < len); bit++) {
+            if (control & (1u << bit)) {
+                size_t dist;
+                size_t match;
+
+                if ((i + 2) > len) {
+                    return SIZE_MAX;
+                }
+                dist = (size_t)in[i] + 1;
+                match = (size_t)in[i + 1] + LZ_MIN_MATCH;
+                i += 2;
+
+                if ((dist > o) || (match > (size - o))) {
+                    return SIZE_MAX;
+                }
+                /* Byte by byte: the match may overlap its own output */
+                for (size_t k = 0; k < match; k++, o++) {
+                    out[o] = out[o - dist];
+                }
+            } else {
+                if (o >= size) {
+                    return SIZE_MAX;
+                }
+                out[o++] = in[i++];
+            }
+        }
+    }
+    return o;
+}
+
+/* Returns the header length, 0 if it is malformed */
+static size_t telemetry_get_header(const uint8_t *frame,
+                                   size_t len,
+                                   mqtt_telemetry_header_t *header)
+{
+    size_t n;
+
+    if ((len < TELEMETRY_FIXED_HEADER_SIZE) ||
+        ((frame[0] & ~MQTT_TELEMETRY_FLAG_COMPRESSED) != MQTT_TELEMETRY_FORMAT_VERSION)) {
+        return 0;
+    }
+
+    header->schema_id = frame[1];
+    header->schema_version = frame[2];
+    header->field_count = frame[3];
+    if (header->field_count > MQTT_TELEMETRY_MAX_FIELDS) {
+        return 0;
+    }
+
+    n = telemetry_get_varint(&frame[TELEMETRY_FIXED_HEADER_SIZE],
+                             len - TELEMETRY_FIXED_HEADER_SIZE,
+                             &header->base_time_ms);
+    if (n == 0) {
+        return 0;
+    }
+    return TELEMETRY_FIXED_HEADER_SIZE + n;
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+bool mqtt_telemetry_begin(mqtt_telemetry_encoder_t *encoder,
+                          const mqtt_telemetry_schema_t *schema,
+                          uint8_t *buf,
+                          size_t size,
+                          uint32_t base_time_ms)
+{
+    size_t n;
+
+    if ((encoder == NULL) || (schema == NULL) || (buf == NULL) ||
+        (schema->field_count > MQTT_TELEMETRY_MAX_FIELDS) ||
+        (size < TELEMETRY_FIXED_HEADER_SIZE)) {
+        return false;
+    }
+
+    buf[0] = MQTT_TELEMETRY_FORMAT_VERSION;
+    buf[1] = schema->id;
+    buf[2] = schema->version;
+    buf[3] = schema->field_count;
+
+    n = telemetry_put_varint(&buf[TELEMETRY_FIXED_HEADER_SIZE],
+                             size - TELEMETRY_FIXED_HEADER_SIZE,
+                             base_time_ms);
+    if (n == 0) {
+        return false;
+    }
+
+    encoder->schema = schema;
+    encoder->buf = buf;
+    encoder->size = size;
+    encoder->len = TELEMETRY_FIXED_HEADER_SIZE + n;
+    encoder->sample_count = 0;
+    encoder->prev_time_ms = base_time_ms;
+    memset(encoder->prev, 0, sizeof(encoder->prev));
+    return true;
+}
+
+bool mqtt_telemetry_add(mqtt_telemetry_encoder_t *encoder,
+                        uint32_t time_ms,
+                        const int32_t *values)
+{
+    size_t len;
+    size_t n;
+
+    if ((encoder == NULL) || (encoder->schema == NULL) || (values == NULL)) {
+        return false;
+    }
+
+    len = encoder->len;
+
+    n = telemetry_put_varint(&encoder->buf[len], encoder->size - len,
+                             time_ms - encoder->prev_time_ms);
+    if (n == 0) {
+        return false;
+    }
+    len += n;
+
+    for (uint8_t f = 0; f < encoder->schema->field_count; f++) {
+        /* Wraps around like the decoder, so no change can overflow */
+        uint32_t delta = (uint32_t)values[f] - (uint32_t)encoder->prev[f];
+
+        n = telemetry_put_varint(&encoder->buf[len], encoder->size - len,
+                                 telemetry_zigzag((int32_t)delta));
+        if (n == 0) {
+            return false;
+        }
+        len += n;
+    }
+
+    /* Commit the sample */
+    encoder->len = len;
+    encoder->prev_time_ms = time_ms;
+    memcpy(encoder->prev, values, encoder->schema->field_count * sizeof(int32_t));
+    encoder->sample_count++;
+    return true;
+}
+
+size_t mqtt_telemetry_length(const mqtt_telemetry_encoder_t *encoder)
+{
+    return (encoder != NULL) ? encoder->len : 0;
+}
+
+size_t mqtt_telemetry_compress(const uint8_t *frame,
+                               size_t len,
+                               uint8_t *out,
+                               size_t out_size)
+{
+    mqtt_telemetry_header_t header;
+    size_t header_len;
+    size_t o;
+    size_t n;
+
+    if ((frame == NULL) || (out == NULL) ||
+        (frame[0] & MQTT_TELEMETRY_FLAG_COMPRESSED)) {
+        return 0;
+    }
+
+    header_len = telemetry_get_header(frame, len, &header);
+    if ((header_len == 0) || (out_size < header_len)) {
+        return 0;
+    }
+
+    /* Compare against the uncompressed frame, not the buffer */
+    if (out_size > len) {
+        out_size = len;
+    }
+
+    memcpy(out, frame, header_len);
+    out[0] |= MQTT_TELEMETRY_FLAG_COMPRESSED;
+    o = header_len;
+
+    n = telemetry_put_varint(&out[o], out_size - o, (uint32_t)(len - header_len));
+    if (n == 0) {
+        return 0;
+    }
+    o += n;
+
+    n = lz_compress(&frame[header_len], len - header_len, &out[o], out_size - o);
+    if ((n == 0) || ((o + n) >= len)) {
+        return 0;
+    }
+    return o + n;
+}
+
+int32_t mqtt_telemetry_decode(const uint8_t *frame,
+                              size_t len,
+                              uint8_t *scratch,
+                              size_t scratch_size,
+                              mqtt_telemetry_sample_cb_t sample_cb,
+                              void *arg)
+{
+    mqtt_telemetry_header_t header;
+    int32_t values[MQTT_TELEMETRY_MAX_FIELDS] = {0};
+    const uint8_t *body;
+    size_t body_len;
+    size_t i = 0;
+    uint32_t time_ms;
+    int32_t count = 0;
+
+    if (frame == NULL) {
+        return -1;
+    }
+
+    i = telemetry_get_header(frame, len, &header);
+    if (i == 0) {
+        return -1;
+    }
+    body = &frame[i];
+    body_len = len - i;
+
+    if (frame[0] & MQTT_TELEMETRY_FLAG_COMPRESSED) {
+        uint32_t raw_len;
+        size_t n = telemetry_get_varint(body, body_len, &raw_len);
+
+        if ((n == 0) || (scratch == NULL) || (raw_len > scratch_size) ||
+            (lz_decompress(&body[n], body_len - n, scratch, raw_len) != raw_len)) {
+            return -1;
+        }
+        body = scratch;
+        body_len = raw_len;
+    }
+
+    time_ms = header.base_time_ms;
+
+    for (i = 0; i < body_len; count++) {
+        uint32_t value;
+        size_t n = telemetry_get_varint(&body[i], body_len - i, &value);
+
+        if (n == 0) {
+            return -1;
+        }
+        i += n;
+        time_ms += value;
+
+        for (uint8_t f = 0; f < header.field_count; f++) {
+            n = telemetry_get_varint(&body[i], body_len - i, &value);
+            if (n == 0) {
+                return -1;
+            }
+            i += n;
+            values[f] = (int32_t)((uint32_t)values[f] + (uint32_t)telemetry_unzigzag(value));
+        }
+
+        if (sample_cb != NULL) {
+            sample_cb(&header, time_ms, values, arg);
+        }
+    }
+    return count;
+}
+
+/* [] END OF FILE */
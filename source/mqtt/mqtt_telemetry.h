@@ -0,0 +1,165 @@
+/******************************************************************************
+* File Name:   mqtt_telemetry.h
+*
+* Description: This file is the public interface of mqtt_telemetry.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_TELEMETRY_H_
+#define SOURCE_MQTT_TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* A telemetry frame carries a batch of samples of one schema:
+ *   uint8_t  format     : MQTT_TELEMETRY_FORMAT_VERSION, plus
+ *                         MQTT_TELEMETRY_FLAG_COMPRESSED
+ *   uint8_t  schema_id, schema_version, field_count
+ *   varint   base_time_ms
+ *   [varint  body length, before compression, if compressed]
+ *   body     : per sample, the varint time delta to the previous sample
+ *              (to base_time_ms for the first one), then per field the
+ *              zigzag varint of the change from the previous sample.
+ * Varints are LEB128. A compressed body is LZ77-coded: a control byte
+ * flags the next 8 items, 0 for a literal byte, 1 for a match of two bytes
+ * (distance - 1, length - 3) into the last 256 bytes.
+ *
+ * This module has no RTOS dependency, so that host tools can decode the
+ * frames with the same code (see tools/telemetry_decode).
+ */
+#define MQTT_TELEMETRY_FORMAT_VERSION   (1u)
+#define MQTT_TELEMETRY_FLAG_COMPRESSED  (0x80u)
+
+#ifndef MQTT_TELEMETRY_MAX_FIELDS
+#define MQTT_TELEMETRY_MAX_FIELDS       (16u)
+#endif
+
+/* Largest header, and largest encoded sample of 'fields' fields */
+#define MQTT_TELEMETRY_HEADER_MAX_SIZE  (4u + 5u + 5u)
+#define MQTT_TELEMETRY_SAMPLE_MAX_SIZE(fields)  (5u * (1u + (fields)))
+
+/* Values are integers; a field with 'decimals' 2 sends 21.53 as 2153. */
+typedef struct {
+    const char *name;
+    uint8_t decimals;
+} mqtt_telemetry_field_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t version;
+    uint8_t field_count;            /* up to MQTT_TELEMETRY_MAX_FIELDS */
+    const mqtt_telemetry_field_t *fields;
+} mqtt_telemetry_schema_t;
+
+typedef struct {
+    const mqtt_telemetry_schema_t *schema;
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    uint32_t sample_count;
+    uint32_t prev_time_ms;
+    int32_t prev[MQTT_TELEMETRY_MAX_FIELDS];
+} mqtt_telemetry_encoder_t;
+
+typedef struct {
+    uint8_t schema_id;
+    uint8_t schema_version;
+    uint8_t field_count;
+    uint32_t base_time_ms;
+} mqtt_telemetry_header_t;
+
+/* Called by mqtt_telemetry_decode() for each sample, in order */
+typedef void (*mqtt_telemetry_sample_cb_t)(const mqtt_telemetry_header_t *header,
+                                           uint32_t time_ms,
+                                           const int32_t *values,
+                                           void *arg);
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Start a frame in 'buf' */
+bool mqtt_telemetry_begin(mqtt_telemetry_encoder_t *encoder,
+                          const mqtt_telemetry_schema_t *schema,
+                          uint8_t *buf,
+                          size_t size,
+                          uint32_t base_time_ms);
+
+/* Append a sample of 'schema->field_count' values. Fails, leaving the
+ * frame as it was, when the buffer is full; the frame can then be sent and
+ * a new one begun.
+ */
+bool mqtt_telemetry_add(mqtt_telemetry_encoder_t *encoder,
+                        uint32_t time_ms,
+                        const int32_t *values);
+
+/* Length of the frame in the encoder's buffer */
+size_t mqtt_telemetry_length(const mqtt_telemetry_encoder_t *encoder);
+
+/* Write the compressed form of 'frame' to 'out'. Returns its length, or 0
+ * when it does not fit or would not be smaller; the frame is then sent as
+ * it is. Meant for batches: single samples rarely shrink.
+ */
+size_t mqtt_telemetry_compress(const uint8_t *frame,
+                               size_t len,
+                               uint8_t *out,
+                               size_t out_size);
+
+/* Decode a frame, compressed or not. 'scratch' holds the decompressed
+ * body, and may be NULL for uncompressed frames. Returns the number of
+ * samples, or -1 if the frame is malformed.
+ */
+int32_t mqtt_telemetry_decode(const uint8_t *frame,
+                              size_t len,
+                              uint8_t *scratch,
+                              size_t scratch_size,
+                              mqtt_telemetry_sample_cb_t sample_cb,
+                              void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_TELEMETRY_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,422 @@
+/******************************************************************************
+* File Name:   mqtt_topic_trie.c
+*
+* Description: Registry of MQTT subscriptions: a trie of topic filter levels,
+*              with '+' and '#' wildcards, that routes each received PUBLISH
+*              to the handlers of the matching filters.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "mqtt_topic_trie.h"
+#include "mqtt_client_config.h"
+
+#include "cyabs_rtos.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define TRIE_NONE       (-1)
+#define TRIE_ROOT       (0)
+
+typedef struct {
+    char label[MQTT_TOPIC_LEVEL_MAX_LEN + 1];
+    int16_t parent;
+    int16_t child;                  /* first child */
+    int16_t sibling;                /* next child of the parent */
+    bool used;
+
+    /* Set if a filter ends at this node */
+    const char *filter;
+    cy_mqtt_qos_t qos;
+    mqtt_topic_handler_t handler;
+    void *arg;
+} trie_node_t;
+
+typedef struct {
+    mqtt_topic_handler_t handler;
+    void *arg;
+} trie_match_t;
+
+typedef struct {
+    trie_match_t items[MQTT_TOPIC_TRIE_MAX_MATCHES];
+    size_t count;
+} trie_matches_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "topic_trie";
+
+static trie_node_t s_nodes[MQTT_TOPIC_TRIE_MAX_NODES];
+static size_t s_filter_count = 0;
+static cy_mutex_t s_mutex;
+static bool s_initialized = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static bool trie_label_equals(const trie_node_t *node, const char *level, size_t len)
+{
+    return (strlen(node->label) == len) && (memcmp(node->label, level, len) == 0);
+}
+
+static int16_t trie_find_child(int16_t parent, const char *level, size_t len)
+{
+    for (int16_t i = s_nodes[parent].child; i != TRIE_NONE; i = s_nodes[i].sibling) {
+        if (trie_label_equals(&s_nodes[i], level, len)) {
+            return i;
+        }
+    }
+    return TRIE_NONE;
+}
+
+static int16_t trie_add_child(int16_t parent, const char *level, size_t len)
+{
+    for (int16_t i = 1; i < (int16_t)MQTT_TOPIC_TRIE_MAX_NODES; i++) {
+        trie_node_t *node = &s_nodes[i];
+
+        if (!node->used) {
+            memset(node, 0, sizeof(*node));
+            memcpy(node->label, level, len);
+            node->label[len] = '\0';
+            node->used = true;
+            node->parent = parent;
+            node->child = TRIE_NONE;
+            node->sibling = s_nodes[parent].child;
+            s_nodes[parent].child = i;
+            return i;
+        }
+    }
+    return TRIE_NONE;
+}
+
+/* Free the nodes that no longer lead to a filter, from 'index' upwards */
+static void trie_prune(int16_t index)
+{
+    while ((index != TRIE_ROOT) &&
+           (s_nodes[index].child == TRIE_NONE) &&
+           (s_nodes[index].filter == NULL)) {
+        int16_t parent = s_nodes[index].parent;
+        int16_t *link = &s_nodes[parent].child;
+
+        while (*link != index) {
+            link = &s_nodes[*link].sibling;
+        }
+        *link = s_nodes[index].sibling;
+        s_nodes[index].used = false;
+
+        index = parent;
+    }
+}
+
+/******************************************************************************
+ * Function Name: trie_walk_filter
+ ******************************************************************************
+ * Summary:
+ *  Finds, and optionally creates, the node at which a topic filter ends.
+ *  The filter is validated on the way: '+' and '#' must fill a level, and
+ *  '#' must be the last level.
+ *
+ * Parameters:
+ *  const char *filter : NUL-terminated topic filter
+ *  bool create : create the missing nodes
+ *
+ * Return:
+ *  int16_t : node index, or TRIE_NONE
+ *
+ ******************************************************************************/
+static int16_t trie_walk_filter(const char *filter, bool create)
+{
+    int16_t index = TRIE_ROOT;
+    const char *level = filter;
+
+    while (true) {
+        const char *end = strchr(level, '/');
+        size_t len = (end != NULL) ? (size_t)(end - level) : strlen(level);
+        int16_t next;
+
+        if ((len > MQTT_TOPIC_LEVEL_MAX_LEN) ||
+            ((memchr(level, '+', len) != NULL) && (len != 1)) ||
+            ((memchr(level, '#', len) != NULL) && ((len != 1) || (end != NULL)))) {
+            CY_LOGE(TAG, "invalid topic filter '%s'", filter);
+            return TRIE_NONE;
+        }
+
+        next = trie_find_child(index, level, len);
+        if ((next == TRIE_NONE) && create) {
+            next = trie_add_child(index, level, len);
+            if (next == TRIE_NONE) {
+                CY_LOGE(TAG, "out of nodes for '%s'", filter);
+                if (index != TRIE_ROOT) {
+                    trie_prune(index);
+                }
+                return TRIE_NONE;
+            }
+        }
+        if (next == TRIE_NONE) {
+            return TRIE_NONE;
+        }
+        index = next;
+
+        if (end == NULL) {
+            return index;
+        }
+        level = end + 1;
+    }
+}
+
+static void trie_add_match(trie_matches_t *matches, const trie_node_t *node)
+{
+    if (node->handler == NULL) {
+        return;
+    }
+
+    if (matches->count < MQTT_TOPIC_TRIE_MAX_MATCHES) {
+        matches->items[matches->count].handler = node->handler;
+        matches->items[matches->count].arg = node->arg;
+        matches->count++;
+    } else {
+        CY_LOGE(TAG, "more than %u matching filters", (unsigned int)MQTT_TOPIC_TRIE_MAX_MATCHES);
+    }
+}
+
+/******************************************************************************
+ * Function Name: trie_match
+ ******************************************************************************
+ * Summary:
+ *  Collects the handlers of the filters below 'index' that match the topic
+ *  from 'pos' on. Only the exact, '+' and '#' children are followed at
+ *  each level, so the recursion is as deep as the topic has levels.
+ *
+ * Parameters:
+ *  int16_t index : node matched by the levels before 'pos'
+ *  const char *topic : topic of the received message
+ *  size_t topic_len : length of the topic
+ *  size_t pos : start of the current level
+ *  trie_matches_t *matches : collected handlers
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void trie_match(int16_t index,
+                       const char *topic,
+                       size_t topic_len,
+                       size_t pos,
+                       trie_matches_t *matches)
+{
+    const char *level = &topic[pos];
+    const char *slash = memchr(level, '/', topic_len - pos);
+    size_t len = (slash != NULL) ? (size_t)(slash - level) : (topic_len - pos);
+    bool last = (slash == NULL);
+
+    /* Wildcards do not match the '$' topics (e.g. $SYS) at the first level */
+    bool wildcards = !((pos == 0) && (topic_len > 0) && (topic[0] == '$'));
+
+    for (int16_t i = s_nodes[index].child; i != TRIE_NONE; i = s_nodes[i].sibling) {
+        const trie_node_t *node = &s_nodes[i];
+
+        if (trie_label_equals(node, "#", 1)) {
+            if (wildcards) {
+                trie_add_match(matches, node);
+            }
+            continue;
+        }
+
+        if (!trie_label_equals(node, level, len) &&
+            !(wildcards && trie_label_equals(node, "+", 1))) {
+            continue;
+        }
+
+        if (last) {
+            int16_t hash = trie_find_child(i, "#", 1);
+
+            trie_add_match(matches, node);
+
+            /* "a/#" also matches "a" */
+            if (hash != TRIE_NONE) {
+                trie_add_match(matches, &s_nodes[hash]);
+            }
+        } else {
+            trie_match(i, topic, topic_len, pos + len + 1, matches);
+        }
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_topic_trie_init(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (!s_initialized) {
+        result = cy_rtos_init_mutex(&s_mutex);
+
+        if (result == CY_RSLT_SUCCESS) {
+            memset(s_nodes, 0, sizeof(s_nodes));
+            s_nodes[TRIE_ROOT].used = true;
+            s_nodes[TRIE_ROOT].parent = TRIE_NONE;
+            s_nodes[TRIE_ROOT].child = TRIE_NONE;
+            s_nodes[TRIE_ROOT].sibling = TRIE_NONE;
+            s_filter_count = 0;
+            s_initialized = true;
+        } else {
+            CY_LOGE(TAG, "cy_rtos_init_mutex failed!");
+        }
+    }
+    return result;
+}
+
+cy_rslt_t mqtt_topic_trie_add(const char *filter,
+                              cy_mqtt_qos_t qos,
+                              mqtt_topic_handler_t handler,
+                              void *arg)
+{
+    cy_rslt_t result = CY_RSLT_MODULE_MQTT_ERROR;
+    int16_t index;
+
+    if (!s_initialized || (filter == NULL) || (*filter == '\0') || (handler == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    index = trie_walk_filter(filter, true);
+    if (index != TRIE_NONE) {
+        trie_node_t *node = &s_nodes[index];
+
+        if ((node->filter == NULL) && (s_filter_count >= MQTT_TOPIC_TRIE_MAX_FILTERS)) {
+            CY_LOGE(TAG, "more than %u filters", (unsigned int)MQTT_TOPIC_TRIE_MAX_FILTERS);
+            trie_prune(index);
+
+        } else {
+            if (node->filter == NULL) {
+                s_filter_count++;
+            }
+            node->filter = filter;
+            node->qos = qos;
+            node->handler = handler;
+            node->arg = arg;
+            result = CY_RSLT_SUCCESS;
+        }
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+cy_rslt_t mqtt_topic_trie_remove(const char *filter)
+{
+    cy_rslt_t result = CY_RSLT_MODULE_MQTT_ERROR;
+    int16_t index;
+
+    if (!s_initialized || (filter == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    index = trie_walk_filter(filter, false);
+    if ((index != TRIE_NONE) && (s_nodes[index].filter != NULL)) {
+        s_nodes[index].filter = NULL;
+        s_nodes[index].handler = NULL;
+        s_nodes[index].arg = NULL;
+        s_filter_count--;
+        trie_prune(index);
+        result = CY_RSLT_SUCCESS;
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return result;
+}
+
+size_t mqtt_topic_trie_dispatch(const cy_mqtt_publish_info_t *msg)
+{
+    trie_matches_t matches;
+
+    if (!s_initialized || (msg == NULL) || (msg->topic == NULL)) {
+        return 0;
+    }
+
+    matches.count = 0;
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+    trie_match(TRIE_ROOT, msg->topic, msg->topic_len, 0, &matches);
+    cy_rtos_set_mutex(&s_mutex);
+
+    /* Handlers run unlocked, so that they may (un)register filters */
+    for (size_t i = 0; i < matches.count; i++) {
+        matches.items[i].handler(msg, matches.items[i].arg);
+    }
+
+    if (matches.count == 0) {
+        CY_LOGD(TAG, "no handler for topic '%.*s'", (int)msg->topic_len, msg->topic);
+    }
+    return matches.count;
+}
+
+size_t mqtt_topic_trie_get_subscriptions(cy_mqtt_subscribe_info_t *infos,
+                                         size_t max)
+{
+    size_t count = 0;
+
+    if (!s_initialized || (infos == NULL)) {
+        return 0;
+    }
+
+    cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+
+    for (size_t i = 0; (i < MQTT_TOPIC_TRIE_MAX_NODES) && (count < max); i++) {
+        const trie_node_t *node = &s_nodes[i];
+
+        if (node->used && (node->filter != NULL)) {
+            memset(&infos[count], 0, sizeof(infos[count]));
+            infos[count].qos = node->qos;
+            infos[count].topic = node->filter;
+            infos[count].topic_len = (uint16_t)strlen(node->filter);
+            count++;
+        }
+    }
+
+    cy_rtos_set_mutex(&s_mutex);
+    return count;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,98 @@
+/******************************************************************************
+* File Name:   mqtt_topic_trie.h
+*
+* Description: This file is the public interface of mqtt_topic_trie.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_TOPIC_TRIE_H_
+#define SOURCE_MQTT_TOPIC_TRIE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_mqtt_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Called from the MQTT library thread for each received PUBLISH whose topic
+ * matches the handler's filter. Must not block.
+ */
+typedef void (*mqtt_topic_handler_t)(const cy_mqtt_publish_info_t *msg,
+                                     void *arg);
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t mqtt_topic_trie_init(void);
+
+/* Register a handler for a topic filter, which may use the '+' (one level)
+ * and '#' (remaining levels, last only) wildcards. The filter string must
+ * stay valid while it is registered; re-adding a filter replaces its
+ * handler.
+ */
+cy_rslt_t mqtt_topic_trie_add(const char *filter,
+                              cy_mqtt_qos_t qos,
+                              mqtt_topic_handler_t handler,
+                              void *arg);
+
+cy_rslt_t mqtt_topic_trie_remove(const char *filter);
+
+/* Call the handlers of every filter matching the message's topic; the
+ * cost grows with the number of topic levels, not of filters.
+ * Returns the number of handlers called.
+ */
+size_t mqtt_topic_trie_dispatch(const cy_mqtt_publish_info_t *msg);
+
+/* Fill 'infos' with up to 'max' registered filters, for cy_mqtt_subscribe()
+ * and cy_mqtt_unsubscribe(). Returns the number of filters written.
+ */
+size_t mqtt_topic_trie_get_subscriptions(cy_mqtt_subscribe_info_t *infos,
+                                         size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_TOPIC_TRIE_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,420 @@
+/******************************************************************************
+* File Name:   mqtt_uplink_budget.c
+*
+* Description: This file paces the MQTT publishes on metered cellular links,
+*              and degrades the publisher as the daily data budget is used up
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "mqtt_uplink_budget.h"
+#include "mqtt_client_config.h"
+#include "feature_config.h"
+
+#include "cyhal.h"
+#include "cyabs_rtos.h"
+#include "cy_pcm.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define BUDGET_DAY_MS                   (24u * 60u * 60u * 1000u)
+
+#define BUDGET_SAVED_MAGIC              (0x42554447u)   /* "BUDG" */
+
+/* Token bucket. The tokens are scaled by 1000, so that 'rate' tokens per
+ * second refill 'rate' scaled tokens per millisecond. They go below zero
+ * when a publish takes more than is left.
+ */
+typedef struct
+{
+    int64_t tokens;
+    uint32_t rate;                      /* per second, 0 = not limited */
+    uint32_t burst;
+} budget_bucket_t;
+
+/* Usage of the current day, kept where the startup code does not clear
+ * the RAM: a reset does not start a new day. After a power cycle, the RAM
+ * content fails the check and the day starts over.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t day;
+    uint32_t day_elapsed_ms;            /* into the day, at the last update */
+    uint32_t used_bytes;
+    uint32_t other_bytes;
+    uint32_t check;
+} budget_saved_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static budget_bucket_t s_bytes =
+{
+    .tokens = (int64_t)MQTT_UPLINK_BYTES_BURST * 1000,
+    .rate = MQTT_UPLINK_BYTES_PER_SEC,
+    .burst = MQTT_UPLINK_BYTES_BURST
+};
+
+static budget_bucket_t s_msgs =
+{
+    .tokens = (int64_t)MQTT_UPLINK_MSGS_BURST * 1000,
+    .rate = MQTT_UPLINK_MSGS_PER_SEC,
+    .burst = MQTT_UPLINK_MSGS_BURST
+};
+
+static cy_time_t s_refill_time = 0;
+static cy_time_t s_day_start = 0;
+
+static volatile mqtt_budget_level_t s_level = MQTT_BUDGET_LEVEL_NORMAL;
+static volatile bool s_metered = false;
+
+static mqtt_budget_stats_t s_stats;
+
+CY_NOINIT static budget_saved_t s_saved;
+static bool s_restored = false;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static bool budget_is_metered(void)
+{
+#if (FEATURE_PPP == ENABLE_FEATURE)
+    return (cy_pcm_get_default_connectivity() == CELLULAR_CONNECTIVITY);
+#else
+    return false;
+#endif
+}
+
+static void budget_refill(budget_bucket_t *bucket, uint32_t elapsed_ms)
+{
+    int64_t max = (int64_t)bucket->burst * 1000;
+
+    bucket->tokens += (int64_t)bucket->rate * elapsed_ms;
+    if (bucket->tokens > max) {
+        bucket->tokens = max;
+    }
+}
+
+/* Time in ms until the bucket has a token again */
+static uint32_t budget_bucket_wait_ms(const budget_bucket_t *bucket)
+{
+    if ((bucket->rate == 0) || (bucket->tokens > 0)) {
+        return 0;
+    }
+    return (uint32_t)(-bucket->tokens / bucket->rate) + 1;
+}
+
+static void budget_take(budget_bucket_t *bucket, uint32_t count)
+{
+    if (bucket->rate > 0) {
+        bucket->tokens -= (int64_t)count * 1000;
+    }
+}
+
+static uint32_t budget_saved_check(const budget_saved_t *saved)
+{
+    return ~(saved->magic ^ saved->day ^ saved->day_elapsed_ms ^
+             saved->used_bytes ^ saved->other_bytes);
+}
+
+/* Must be called inside the critical section */
+static void budget_save(cy_time_t now)
+{
+    s_saved.magic = BUDGET_SAVED_MAGIC;
+    s_saved.day = s_stats.day;
+    s_saved.day_elapsed_ms = (uint32_t)(now - s_day_start);
+    s_saved.used_bytes = s_stats.used_bytes;
+    s_saved.other_bytes = s_stats.other_bytes;
+    s_saved.check = budget_saved_check(&s_saved);
+}
+
+/* Must be called inside the critical section. Carries the usage of the
+ * day over from before the last reset.
+ */
+static void budget_restore(cy_time_t now)
+{
+    if ((s_saved.magic == BUDGET_SAVED_MAGIC) &&
+        (s_saved.check == budget_saved_check(&s_saved)) &&
+        (s_saved.day_elapsed_ms < BUDGET_DAY_MS)) {
+        s_stats.day = s_saved.day;
+        s_stats.used_bytes = s_saved.used_bytes;
+        s_stats.other_bytes = s_saved.other_bytes;
+        s_day_start = now - s_saved.day_elapsed_ms;
+    } else {
+        s_day_start = now;
+    }
+    s_restored = true;
+}
+
+/* Must be called inside the critical section */
+static void budget_count(uint32_t *counter, uint32_t bytes)
+{
+    if (*counter > (UINT32_MAX - bytes)) {
+        *counter = UINT32_MAX;
+    } else {
+        *counter += bytes;
+    }
+}
+
+/* Must be called inside the critical section */
+static void budget_update(cy_time_t now)
+{
+    uint32_t elapsed;
+
+    if (!s_restored) {
+        budget_restore(now);
+        s_refill_time = now;
+    }
+
+    elapsed = (uint32_t)(now - s_refill_time);
+
+    s_refill_time = now;
+    budget_refill(&s_bytes, elapsed);
+    budget_refill(&s_msgs, elapsed);
+
+    elapsed = (uint32_t)(now - s_day_start);
+    if (elapsed >= BUDGET_DAY_MS) {
+        uint32_t days = elapsed / BUDGET_DAY_MS;
+
+        s_day_start += days * BUDGET_DAY_MS;
+        s_stats.day += days;
+        s_stats.used_bytes = 0;
+        s_stats.other_bytes = 0;
+        s_stats.throttled = 0;
+        s_stats.dropped = 0;
+    }
+    budget_save(now);
+}
+
+/* Must be called inside the critical section */
+static mqtt_budget_level_t budget_level(void)
+{
+#if (MQTT_DAILY_BUDGET_BYTES > 0)
+    uint32_t percent;
+
+    if (!s_metered) {
+        return MQTT_BUDGET_LEVEL_NORMAL;
+    }
+
+    percent = (uint32_t)(((uint64_t)s_stats.used_bytes * 100u) / MQTT_DAILY_BUDGET_BYTES);
+
+    if (percent >= MQTT_BUDGET_ALARMS_ONLY_PERCENT) {
+        return MQTT_BUDGET_LEVEL_ALARMS_ONLY;
+    }
+    if (percent >= MQTT_BUDGET_DROP_BULK_PERCENT) {
+        return MQTT_BUDGET_LEVEL_DROP_BULK;
+    }
+    if (percent >= MQTT_BUDGET_COALESCE_PERCENT) {
+        return MQTT_BUDGET_LEVEL_COALESCE;
+    }
+#endif
+    return MQTT_BUDGET_LEVEL_NORMAL;
+}
+
+/* Brings the buckets, the day and the level up to date */
+static void budget_refresh(void)
+{
+    cy_time_t now = 0;
+    uint32_t state;
+
+    s_metered = budget_is_metered();
+    cy_rtos_get_time(&now);
+
+    state = cyhal_system_critical_section_enter();
+    budget_update(now);
+    s_level = budget_level();
+    cyhal_system_critical_section_exit(state);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+mqtt_budget_level_t mqtt_uplink_budget_level(void)
+{
+    return s_level;
+}
+
+const char* mqtt_uplink_budget_level_name(mqtt_budget_level_t level)
+{
+    switch (level) {
+        case MQTT_BUDGET_LEVEL_NORMAL:      return "normal";
+        case MQTT_BUDGET_LEVEL_COALESCE:    return "coalesce";
+        case MQTT_BUDGET_LEVEL_DROP_BULK:   return "drop-bulk";
+        case MQTT_BUDGET_LEVEL_ALARMS_ONLY: return "alarms-only";
+        default:                            return "unknown";
+    }
+}
+
+bool mqtt_uplink_budget_admit(bool high, bool bulk)
+{
+    bool admitted = true;
+    uint32_t state;
+
+    budget_refresh();
+
+    if (s_level >= MQTT_BUDGET_LEVEL_ALARMS_ONLY) {
+        admitted = high;
+    } else if (s_level >= MQTT_BUDGET_LEVEL_DROP_BULK) {
+        admitted = !bulk;
+    }
+
+    if (!admitted) {
+        state = cyhal_system_critical_section_enter();
+        s_stats.dropped++;
+        cyhal_system_critical_section_exit(state);
+    }
+    return admitted;
+}
+
+uint32_t mqtt_uplink_budget_acquire(size_t len, bool high)
+{
+    cy_time_t now = 0;
+    uint32_t wait_ms = 0;
+    uint32_t bytes;
+    uint32_t state;
+
+    budget_refresh();
+
+    if (!s_metered) {
+        return 0;
+    }
+
+    bytes = (uint32_t)len + MQTT_UPLINK_PUBLISH_OVERHEAD;
+    cy_rtos_get_time(&now);
+
+    state = cyhal_system_critical_section_enter();
+
+    if (!high) {
+        wait_ms = budget_bucket_wait_ms(&s_bytes);
+        if (wait_ms < budget_bucket_wait_ms(&s_msgs)) {
+            wait_ms = budget_bucket_wait_ms(&s_msgs);
+        }
+    }
+
+    if (wait_ms == 0) {
+        budget_take(&s_bytes, bytes);
+        budget_take(&s_msgs, 1);
+        budget_count(&s_stats.used_bytes, bytes);
+        budget_save(now);
+        s_level = budget_level();
+    } else {
+        s_stats.throttled++;
+    }
+
+    cyhal_system_critical_section_exit(state);
+    return wait_ms;
+}
+
+void mqtt_uplink_budget_charge(size_t bytes, bool cellular)
+{
+    cy_time_t now = 0;
+    uint32_t state;
+
+    if (!cellular) {
+        return;
+    }
+
+    budget_refresh();
+    cy_rtos_get_time(&now);
+
+    state = cyhal_system_critical_section_enter();
+    budget_take(&s_bytes, (uint32_t)bytes);
+    budget_count(&s_stats.used_bytes, (uint32_t)bytes);
+    budget_count(&s_stats.other_bytes, (uint32_t)bytes);
+    budget_save(now);
+    s_level = budget_level();
+    cyhal_system_critical_section_exit(state);
+}
+
+uint32_t mqtt_uplink_budget_wait_ms(void)
+{
+    cy_time_t now = 0;
+    uint32_t wait_ms;
+    uint32_t state;
+
+    if (!s_metered) {
+        return 0;
+    }
+
+    cy_rtos_get_time(&now);
+
+    state = cyhal_system_critical_section_enter();
+    budget_update(now);
+    wait_ms = budget_bucket_wait_ms(&s_bytes);
+    if (wait_ms < budget_bucket_wait_ms(&s_msgs)) {
+        wait_ms = budget_bucket_wait_ms(&s_msgs);
+    }
+    cyhal_system_critical_section_exit(state);
+
+    return wait_ms;
+}
+
+void mqtt_uplink_budget_get_stats(mqtt_budget_stats_t *stats)
+{
+    uint32_t state;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    budget_refresh();
+
+    state = cyhal_system_critical_section_enter();
+    *stats = s_stats;
+    cyhal_system_critical_section_exit(state);
+}
+
+void mqtt_uplink_budget_print_stats(void)
+{
+    mqtt_budget_stats_t stats;
+
+    mqtt_uplink_budget_get_stats(&stats);
+
+    PRINT_MSG(("uplink budget: %s level=%s used=%lu/%lu bytes (other=%lu) day=%lu "
+               "throttled=%lu dropped=%lu\n",
+               s_metered ? "cellular" : "not metered",
+               mqtt_uplink_budget_level_name(s_level),
+               (unsigned long)stats.used_bytes,
+               (unsigned long)MQTT_DAILY_BUDGET_BYTES,
+               (unsigned long)stats.other_bytes,
+               (unsigned long)stats.day,
+               (unsigned long)stats.throttled,
+               (unsigned long)stats.dropped));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,120 @@
+/******************************************************************************
+* File Name:   mqtt_uplink_budget.h
+*
+* Description: This file is the public interface of mqtt_uplink_budget.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_MQTT_UPLINK_BUDGET_H_
+#define SOURCE_MQTT_UPLINK_BUDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_result.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Degradation steps as the daily budget is used up (see
+ * MQTT_DAILY_BUDGET_BYTES). Always MQTT_BUDGET_LEVEL_NORMAL off cellular.
+ */
+typedef enum
+{
+    MQTT_BUDGET_LEVEL_NORMAL,
+    MQTT_BUDGET_LEVEL_COALESCE,         /* messages on one topic coalesce */
+    MQTT_BUDGET_LEVEL_DROP_BULK,        /* batches are dropped too */
+    MQTT_BUDGET_LEVEL_ALARMS_ONLY,      /* only high priority messages */
+} mqtt_budget_level_t;
+
+/* Counters of the current day */
+typedef struct
+{
+    uint32_t used_bytes;                /* counted on cellular only */
+    uint32_t other_bytes;               /* of which not publishes */
+    uint32_t throttled;                 /* times a publish had to wait */
+    uint32_t dropped;                   /* messages refused by the level */
+    uint32_t day;                       /* days since power-up */
+} mqtt_budget_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Level as of the last admission or publish. Safe from an ISR. */
+mqtt_budget_level_t mqtt_uplink_budget_level(void);
+
+const char* mqtt_uplink_budget_level_name(mqtt_budget_level_t level);
+
+/* Whether a message may be sent at the current level. 'high' is for
+ * PUBLISHER_PRIORITY_HIGH messages, 'bulk' for the batches of
+ * publisher_publish_batch(). A refused message is counted as dropped.
+ */
+bool mqtt_uplink_budget_admit(bool high, bool bulk);
+
+/* Takes the tokens for a publish of 'len' bytes (topic and payload) and
+ * counts it against the daily budget. Returns 0 when it may be sent now,
+ * else the time in ms to wait before calling again; nothing is taken then.
+ * High priority publishes are never held back and may leave the buckets in
+ * debt, which the following normal publishes pay back.
+ */
+uint32_t mqtt_uplink_budget_acquire(size_t len, bool high);
+
+/* Counts 'bytes' of traffic other than publishes, such as MQTT connections,
+ * DNS queries and link probes, against the buckets and the daily budget
+ * when it goes over the cellular link. It never waits; it can only raise
+ * the level.
+ */
+void mqtt_uplink_budget_charge(size_t bytes, bool cellular);
+
+/* Time in ms until a normal publish may be sent, without taking anything */
+uint32_t mqtt_uplink_budget_wait_ms(void);
+
+void mqtt_uplink_budget_get_stats(mqtt_budget_stats_t *stats);
+
+void mqtt_uplink_budget_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_MQTT_UPLINK_BUDGET_H_ */
+
+/* [] END OF FILE */
@@ -47,12 +47,21 @@
 /******************************************************************************
 * Global Variables
 *******************************************************************************/
-/* MQTT Broker/Server details */
-cy_mqtt_broker_info_t broker_info =
+/* MQTT Broker/Server details, per connection (see mqtt_conn_id_t) */
+cy_mqtt_broker_info_t broker_info[MQTT_CONNECTION_COUNT] =
 {
-    .hostname = MQTT_BROKER_ADDRESS,
-    .hostname_len = sizeof(MQTT_BROKER_ADDRESS) - 1,
-    .port = MQTT_PORT
+    {
+        .hostname = MQTT_BROKER_ADDRESS,
+        .hostname_len = sizeof(MQTT_BROKER_ADDRESS) - 1,
+        .port = MQTT_PORT
+    },
+#if (MQTT_CONNECTION_COUNT > 1)
+    {
+        .hostname = MQTT_BULK_BROKER_ADDRESS,
+        .hostname_len = sizeof(MQTT_BULK_BROKER_ADDRESS) - 1,
+        .port = MQTT_BULK_PORT
+    },
+#endif
 };
 
 #if (MQTT_SECURE_CONNECTION)
@@ -115,7 +124,7 @@ cy_awsport_ssl_credentials_t *security_info = &credentials;
 
 #else
 /* Pointer to the security details of the MQTT connection. */
-struct cy_awsport_ssl_credentials_t *security_info = NULL;
+cy_awsport_ssl_credentials_t *security_info = NULL;
 #endif /* #if (MQTT_SECURE_CONNECTION) */
 
 #if ENABLE_LWT_MESSAGE
@@ -143,7 +152,7 @@ cy_mqtt_connect_info_t g_mqtt_connection_info =
     .username_len = 0,
     .password = NULL,
     .password_len = 0,
-    .clean_session = true,
+    .clean_session = (MQTT_PERSISTENT_SESSION == 0),
     .keep_alive_sec = MQTT_KEEP_ALIVE_SECONDS,
 #if ENABLE_LWT_MESSAGE
     .will_info = &s_will_msg_info
@@ -152,6 +161,10 @@ cy_mqtt_connect_info_t g_mqtt_connection_info =
 #endif /* ENABLE_LWT_MESSAGE */
 };
 
+#if ((MQTT_CONNECTION_COUNT < 1) || (MQTT_CONNECTION_COUNT > 2))
+#error "MQTT_CONNECTION_COUNT must be 1 or 2."
+#endif
+
 /* Check for a valid QoS setting - QoS 0, QoS 1, or QoS 2. */
 #if ((MQTT_MESSAGES_QOS != 0) && (MQTT_MESSAGES_QOS != 1) && (MQTT_MESSAGES_QOS != 2))
 #error "Invalid QoS setting! MQTT_MESSAGES_QOS must be either 0 or 1."
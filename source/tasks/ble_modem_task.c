@@ -101,6 +101,7 @@ static size_t s_dataArrayLen = 0;
 
 #if (FEATURE_PPP == ENABLE_FEATURE)
 #include "cy_pcm.h"
+#include "fake_io.h"
 #include "cy_modem.h"
 
 
@@ -0,0 +1,151 @@
+/******************************************************************************
+* File Name:   bringup_timeline.c
+*
+* Description: This file records how long each stage from a cold start to the
+*              first MQTT publish takes
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "bringup_timeline.h"
+#include "link_events.h"
+#include "common_task.h"
+#include "feature_config.h"
+
+#include "cyhal.h"
+#include "cy_pcm.h"
+#include "fake_io.h"
+#include "cy_debug.h"
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *s_stage_names[BRINGUP_STAGE_COUNT] =
+{
+    "io_start",
+    "modem_ready",
+    "io_up",
+    "mqtt_connect",
+    "mqtt_connected",
+    "subscribed",
+    "first_publish",
+};
+
+/* Time since boot of each stage, 0 until reached */
+static cy_time_t s_times[BRINGUP_STAGE_COUNT];
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void bringup_link_event(const link_event_t *event, void *arg)
+{
+    connectivity_t default_io = WIFI_STA_CONNECTIVITY;
+
+    (void) arg;
+
+#if (FEATURE_PPP == ENABLE_FEATURE)
+    default_io = cy_pcm_get_default_connectivity();
+#endif
+
+    if ((event->type == LINK_EVENT_STATUS) && (event->status == COMMON_STATUS_STARTING)) {
+        bringup_timeline_mark(BRINGUP_STAGE_IO_START);
+
+    } else if ((event->type == LINK_EVENT_IP_UP) && (event->io == default_io)) {
+        bringup_timeline_mark(BRINGUP_STAGE_IO_UP);
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void bringup_timeline_init(void)
+{
+    (void) link_events_subscribe(LINK_EVENT_STATUS | LINK_EVENT_IP_UP,
+                                 bringup_link_event, NULL);
+}
+
+void bringup_timeline_mark(bringup_stage_t stage)
+{
+    cy_time_t now = 0;
+    uint32_t state;
+    bool first;
+
+    if ((stage >= BRINGUP_STAGE_COUNT) || (s_times[stage] != 0)) {
+        return;
+    }
+
+    cy_rtos_get_time(&now);
+    if (now == 0) {
+        now = 1;    /* 0 means not reached */
+    }
+
+    state = cyhal_system_critical_section_enter();
+    first = (s_times[stage] == 0);
+    if (first) {
+        s_times[stage] = now;
+    }
+    cyhal_system_critical_section_exit(state);
+
+    if (first && (stage == BRINGUP_STAGE_FIRST_PUBLISH)) {
+        bringup_timeline_print();
+    }
+}
+
+cy_time_t bringup_timeline_get(bringup_stage_t stage)
+{
+    return (stage < BRINGUP_STAGE_COUNT) ? s_times[stage] : 0;
+}
+
+void bringup_timeline_print(void)
+{
+    cy_time_t previous = 0;
+
+    /* Each stage: time since boot (+ time since the previous stage), ms */
+    PRINT_MSG(("BRINGUP"));
+    for (size_t i = 0; i < BRINGUP_STAGE_COUNT; i++) {
+        if (s_times[i] == 0) {
+            PRINT_MSG((" %s=-", s_stage_names[i]));
+            continue;
+        }
+
+        PRINT_MSG((" %s=%lu(+%lu)", s_stage_names[i],
+                   (unsigned long)s_times[i],
+                   (unsigned long)((s_times[i] >= previous) ? (s_times[i] - previous) : 0)));
+        previous = s_times[i];
+    }
+    PRINT_MSG(("\n"));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,91 @@
+/******************************************************************************
+* File Name:   bringup_timeline.h
+*
+* Description: This file is the public interface of bringup_timeline.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_BRINGUP_TIMELINE_H_
+#define SOURCE_BRINGUP_TIMELINE_H_
+
+#include <stdint.h>
+
+#include "cyabs_rtos.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Stages from a cold start to the first MQTT publish, in order */
+typedef enum
+{
+    BRINGUP_STAGE_IO_START,             /* the I/O task starts its first attempt */
+    BRINGUP_STAGE_MODEM_READY,          /* the modem answers in command mode
+                                           (PPP_PREWARM_MODEM) */
+    BRINGUP_STAGE_IO_UP,                /* the default I/O has its IP address */
+    BRINGUP_STAGE_MQTT_CONNECT,         /* first MQTT connection attempt over it */
+    BRINGUP_STAGE_MQTT_CONNECTED,       /* the command connection is up */
+    BRINGUP_STAGE_SUBSCRIBED,           /* the subscriptions are made */
+    BRINGUP_STAGE_FIRST_PUBLISH,        /* the first message is sent */
+    BRINGUP_STAGE_COUNT,
+} bringup_stage_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Subscribe to the link events; before the I/O tasks are created */
+void bringup_timeline_init(void);
+
+/* Record when 'stage' is first reached since boot; later calls are
+ * ignored. The timeline is printed once the first message is sent.
+ */
+void bringup_timeline_mark(bringup_stage_t stage);
+
+/* Time since boot at which 'stage' was reached, 0 if not yet */
+cy_time_t bringup_timeline_get(bringup_stage_t stage);
+
+void bringup_timeline_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_BRINGUP_TIMELINE_H_ */
+
+/* [] END OF FILE */
@@ -38,6 +38,11 @@
 * so agrees to indemnify Cypress against all liability.
 *******************************************************************************/
 
+#include <stdio.h>
+
+#include <lwip/netif.h>
+#include <lwip/tcpip.h>     /* for LOCK_TCPIP_CORE */
+
 #include "feature_config.h"
 #include "common_task.h"
 #include "cy_debug.h"
@@ -161,3 +166,22 @@ const char* get_common_status_str(int status)
 
     return "Unknown status";
 }
+
+bool get_netif_name(uint32_t ip_v4, char *name, size_t size)
+{
+    struct netif *netif;
+    bool found = false;
+
+    LOCK_TCPIP_CORE();
+    NETIF_FOREACH(netif) {
+        if (ip4_addr_get_u32(netif_ip4_addr(netif)) == ip_v4) {
+            snprintf(name, size, "%c%c%u", netif->name[0], netif->name[1],
+                     (unsigned int)netif->num);
+            found = true;
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    return found;
+}
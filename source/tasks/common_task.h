@@ -42,6 +42,8 @@
 #ifndef SOURCE_COMMON_TASK_H_
 #define SOURCE_COMMON_TASK_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -93,6 +95,11 @@ const char* get_connectivity_type(int type);
 
 const char* get_common_status_str(int status);
 
+/* Name of the netif that has the address 'ip_v4', e.g. "pp1", as
+ * SO_BINDTODEVICE takes it
+ */
+bool get_netif_name(uint32_t ip_v4, char *name, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -60,9 +60,17 @@
 #include "console_task.h"
 #include "wifi_task.h"
 #include "ppp_task.h"
+#include "link_manager_task.h"
+#include "link_quality.h"
+#include "dns_cache_task.h"
+#include "link_events.h"
 #include "mqtt_task.h"
+#include "publisher_queue.h"
+#include "mqtt_uplink_budget.h"
+#include "subscriber_task.h"
 
 #include "cy_pcm.h"
+#include "fake_io.h"
 #include "cy_memtrack.h"
 #include "cy_atmodem.h"
 
@@ -77,6 +85,14 @@
 #include "cy_unit_test_rtos.h"
 #endif
 
+#if (FEATURE_BENCHMARK_PUBLISH == ENABLE_FEATURE)
+#include "publish_bench.h"
+#endif
+
+#if (FEATURE_BENCHMARK_TELEMETRY == ENABLE_FEATURE)
+#include "telemetry_bench.h"
+#endif
+
 
 /*-- Local Definitions -------------------------------------------------*/
 
@@ -131,6 +147,14 @@ static bool is_within(uint8_t key, uint8_t min, uint8_t max)
     return false;
 }
 
+/* Tell the user when a link gets or loses its IP address */
+static void console_link_event(const link_event_t *event, void *arg)
+{
+    (void) arg;
+
+    PRINT_MSG(("\n# %s: %s\n", get_connectivity_type(event->io), link_event_name(event->type)));
+}
+
 static void notify_io_task( connectivity_t chosen_io,
                             uint32_t notification_value)
 {
@@ -168,43 +192,24 @@ static void notify_app_task(apps_t chosen_app,
 static void set_default_io( connectivity_t *default_io,
                             connectivity_t chosen_io)
 {
-    VoidAssert(default_io != NULL);
-
-#if (FEATURE_WIFI == ENABLE_FEATURE)
-    if (chosen_io == WIFI_STA_CONNECTIVITY) {
-        cy_rslt_t result;
-        const ip_addr_t* wifi_dns_addr = get_wifi_dns_address();
-        DEBUG_ASSERT(wifi_dns_addr != NULL);
-
-        result = cy_pcm_set_default_connectivity(chosen_io);
-        dns_setserver(0, wifi_dns_addr);
-
-        PRINT_MSG(("# cy_pcm_set_default_connectivity returned: %lu\n", result));
-    }
-#endif
-
-#if (FEATURE_PPP == ENABLE_FEATURE)
-    if (chosen_io == CELLULAR_CONNECTIVITY) {
-        cy_rslt_t result;
-        const ip_addr_t* ppp_dns_addr = get_ppp_dns_address();
-        const ip_addr_t* ppp_dns_2_addr = get_ppp_dns_2_address();
-        DEBUG_ASSERT(ppp_dns_addr != NULL);
-        DEBUG_ASSERT(ppp_dns_2_addr != NULL);
+    cy_rslt_t result;
 
-        result = cy_pcm_set_default_connectivity(chosen_io);
-        dns_setserver(0, ppp_dns_addr);
-        dns_setserver(1, ppp_dns_2_addr);
+    VoidAssert(default_io != NULL);
 
-        PRINT_MSG(("# cy_pcm_set_default_connectivity returned: %lu\n", result));
-    }
-#endif
+    result = link_manager_set_default_io(chosen_io);
+    PRINT_MSG(("# link_manager_set_default_io returned: %lu\n", result));
 
 #if (FEATURE_PPP == ENABLE_FEATURE)
     *default_io = cy_pcm_get_default_connectivity();
 #endif
 
 #if (FEATURE_APPS == ENABLE_FEATURE)
-    notify_app_task(APPS_MQTT, NOTIF_RESTART_APP);
+    /* A running MQTT app moves its connections to the new link; one that
+     * is not running is restarted on it.
+     */
+    if ((result == CY_RSLT_SUCCESS) && !mqtt_link_changed()) {
+        notify_app_task(APPS_MQTT, NOTIF_RESTART_APP);
+    }
 #endif
 }
 
@@ -232,6 +237,11 @@ static void handle_manage_io_tasks_menu(connectivity_t *default_io,
         ++optionFinal;
 #endif
 
+#if (VARIANT_MODEM == FAKE_VARIANT)
+        uint8_t optionLinkLoss = ++optionFinal;
+        PRINT_MSG(("  %c  Simulate link loss\n", optionLinkLoss));
+#endif
+
         PRINT_MSG(("  X  Exit\n"));
 
         subSelection = tolower(wait_for_key());
@@ -240,6 +250,13 @@ static void handle_manage_io_tasks_menu(connectivity_t *default_io,
         if (!is_within(subSelection, '1', optionFinal))
             break;
 
+#if (VARIANT_MODEM == FAKE_VARIANT)
+        if (subSelection == optionLinkLoss) {
+            fake_io_simulate_link_loss(chosen_io);
+            continue;
+        }
+#endif
+
         switch (subSelection)
         {
         case '1':
@@ -281,6 +298,14 @@ static void handle_manage_io_types_menu(connectivity_t *default_io)
         *default_io = cy_pcm_get_default_connectivity();
 #endif
 
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+        uint8_t optionLinkQuality = ++optionFinal;
+#endif
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+        uint8_t optionDnsCache = ++optionFinal;
+#endif
+
         draw_menu_border();
         PRINT_MSG(("# Manage I/O\n"));
 
@@ -306,6 +331,14 @@ static void handle_manage_io_types_menu(connectivity_t *default_io)
         }
 #endif
 
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+        PRINT_MSG(("  %c  Show link quality\n", optionLinkQuality));
+#endif
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+        PRINT_MSG(("  %c  Show DNS cache\n", optionDnsCache));
+#endif
+
         PRINT_MSG(("  X  Exit\n"));
 
         subSelection = tolower(wait_for_key());
@@ -314,6 +347,21 @@ static void handle_manage_io_types_menu(connectivity_t *default_io)
         if (!is_within(subSelection, '1', optionFinal))
             break;
 
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+        if (subSelection == optionLinkQuality) {
+            link_quality_print_stats();
+            mqtt_link_print_stats();
+            continue;
+        }
+#endif
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+        if (subSelection == optionDnsCache) {
+            dns_cache_print_stats();
+            continue;
+        }
+#endif
+
         connectivity_t chosen_io = *default_io;
 
 #if (FEATURE_WIFI == ENABLE_FEATURE)
@@ -377,7 +425,7 @@ static void handle_manage_apps_tasks_menu(apps_t chosen_app)
 
     do {
         uint8_t subSelection = 0x00;
-        uint8_t optionFinal = '3';
+        uint8_t optionFinal = '6';
 
         draw_menu_border();
 
@@ -388,6 +436,9 @@ static void handle_manage_apps_tasks_menu(apps_t chosen_app)
         PRINT_MSG(("  1  Stop\n"));
         PRINT_MSG(("  2  Start\n"));
         PRINT_MSG(("  3  Restart\n"));
+        PRINT_MSG(("  4  Show publisher queue stats\n"));
+        PRINT_MSG(("  5  Show subscriber stats\n"));
+        PRINT_MSG(("  6  Show uplink budget\n"));
         PRINT_MSG(("  X  Exit\n"));
 
         subSelection = tolower(wait_for_key());
@@ -410,6 +461,18 @@ static void handle_manage_apps_tasks_menu(apps_t chosen_app)
             notify_app_task(chosen_app, NOTIF_RESTART_APP);
             break;
 
+        case '4':
+            publisher_queue_print_stats();
+            break;
+
+        case '5':
+            subscriber_print_stats();
+            break;
+
+        case '6':
+            mqtt_uplink_budget_print_stats();
+            break;
+
         default:
             DEBUG_ASSERT(0);
             break;
@@ -578,6 +641,14 @@ static void console_menu(void)
     uint8_t optionUnitTestRtos = ++optionFinal;
 #endif
 
+#if (FEATURE_BENCHMARK_PUBLISH == ENABLE_FEATURE)
+    uint8_t optionBenchmarkPublish = ++optionFinal;
+#endif
+
+#if (FEATURE_BENCHMARK_TELEMETRY == ENABLE_FEATURE)
+    uint8_t optionBenchmarkTelemetry = ++optionFinal;
+#endif
+
 
     do {
         uint8_t selection = 0x00;
@@ -602,6 +673,14 @@ static void console_menu(void)
         PRINT_MSG(("  %c  Run RTOS unit tests\n", optionUnitTestRtos));
 #endif
 
+#if (FEATURE_BENCHMARK_PUBLISH == ENABLE_FEATURE)
+        PRINT_MSG(("  %c  Run publish benchmark\n", optionBenchmarkPublish));
+#endif
+
+#if (FEATURE_BENCHMARK_TELEMETRY == ENABLE_FEATURE)
+        PRINT_MSG(("  %c  Run telemetry encoding benchmark\n", optionBenchmarkTelemetry));
+#endif
+
         PRINT_MSG(("  X  Exit\n"));
 
         selection = tolower(wait_for_key());
@@ -658,6 +737,20 @@ static void console_menu(void)
             }
 #endif
 
+#if (FEATURE_BENCHMARK_PUBLISH == ENABLE_FEATURE)
+            else if (selection == optionBenchmarkPublish) {
+                if (get_user_confirmation()) {
+                    publish_bench_main();
+                }
+            }
+#endif
+
+#if (FEATURE_BENCHMARK_TELEMETRY == ENABLE_FEATURE)
+            else if (selection == optionBenchmarkTelemetry) {
+                telemetry_bench_main();
+            }
+#endif
+
             else {
                 DEBUG_ASSERT(0);
             }
@@ -672,6 +765,9 @@ static void console_menu(void)
 
 void console_task(cy_thread_arg_t arg)
 {
+    (void) link_events_subscribe(LINK_EVENT_IP_UP | LINK_EVENT_IP_DOWN,
+                                 console_link_event, NULL);
+
     while (true) {
         console_menu();
 
@@ -0,0 +1,670 @@
+/******************************************************************************
+* File Name:   dns_cache_task.c
+*
+* Description: This file implements a cache of the addresses of the MQTT broker
+*              hostnames, per link. The DNS cache task resolves them with its own
+*              queries, to learn their TTL, and again before they expire.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "dns_cache_task.h"
+#include "link_events.h"
+#include "common_task.h"
+#include "wifi_task.h"
+#include "ppp_task.h"
+
+#include "fake_io.h"
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+
+#include <string.h>
+
+#include <lwip/sockets.h>
+
+#include "dns_config.h"
+#include "mqtt_uplink_budget.h"
+#include "cyhal.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define DNS_PORT                    (53u)
+#define DNS_HEADER_SIZE             (12u)
+#define DNS_MESSAGE_MAX_SIZE        (512u)  /* over UDP, without EDNS */
+#define DNS_LABEL_MAX_LEN           (63u)
+#define DNS_UDP_OVERHEAD            (28u)   /* IPv4 and UDP headers */
+
+#define DNS_FLAG_QR                 (0x80u) /* first flags byte: a response */
+#define DNS_FLAG_RD                 (0x01u) /* first flags byte: recursion */
+#define DNS_RCODE_MASK              (0x0Fu) /* second flags byte */
+
+#define DNS_TYPE_A                  (1u)
+#define DNS_CLASS_IN                (1u)
+
+#define DNS_LINK_COUNT              (2u)
+
+/* Address of a hostname over one link */
+typedef struct
+{
+    ip_addr_t addr;
+    cy_time_t resolved;         /* when 'addr' was received; 0 never */
+    uint32_t ttl_ms;
+    cy_time_t retry_at;         /* after a failed query; 0 none */
+} dns_entry_t;
+
+typedef struct
+{
+    char name[DNS_CACHE_HOSTNAME_MAX_LEN + 1];   /* "" unused */
+    dns_entry_t entries[DNS_LINK_COUNT];
+} dns_host_t;
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t stale_hits;        /* expired addresses served meanwhile */
+    uint32_t misses;
+    uint32_t queries;
+    uint32_t failures;
+} dns_cache_stats_t;
+
+
+/*-- Public Data -------------------------------------------------*/
+
+cy_thread_t g_dns_cache_task_handle = NULL;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "dns_cache";
+
+static const connectivity_t s_links[DNS_LINK_COUNT] =
+{
+    WIFI_STA_CONNECTIVITY,
+    CELLULAR_CONNECTIVITY,
+};
+
+static dns_host_t s_hosts[DNS_CACHE_MAX_HOSTS];
+
+static dns_cache_stats_t s_stats;
+
+/* Given to resolve a new hostname, or after new DNS servers, at once */
+static cy_semaphore_t s_wakeup;
+static bool s_task_ready = false;
+
+/* State of the query ID generator, seeded by dns_seed_query_id() */
+static uint32_t s_query_id_state;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static int dns_link_index(connectivity_t io)
+{
+    for (size_t i = 0; i < DNS_LINK_COUNT; i++) {
+        if (s_links[i] == io) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* Seed the query ID generator from the TRNG, with the unique ID of the
+ * device and the time mixed in, so that the IDs cannot be guessed by a host
+ * that spoofs answers
+ */
+static void dns_seed_query_id(void)
+{
+    uint64_t unique_id = Cy_SysLib_GetUniqueId();
+    uint32_t seed = (uint32_t)unique_id ^ (uint32_t)(unique_id >> 32);
+    cy_time_t now = 0;
+#if (CYHAL_DRIVER_AVAILABLE_TRNG)
+    cyhal_trng_t trng;
+
+    if (cyhal_trng_init(&trng) == CY_RSLT_SUCCESS) {
+        seed ^= cyhal_trng_generate(&trng);
+        cyhal_trng_free(&trng);
+    }
+#endif /* CYHAL_DRIVER_AVAILABLE_TRNG */
+
+    (void) cy_rtos_get_time(&now);
+    seed ^= (uint32_t)now;
+    s_query_id_state = (seed != 0) ? seed : 1u;
+}
+
+/* Next query ID (xorshift32) */
+static uint16_t dns_next_query_id(void)
+{
+    uint32_t x = s_query_id_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_query_id_state = x;
+    return (uint16_t)(x >> 16);
+}
+
+static bool dns_link_is_up(connectivity_t io)
+{
+    return (io == WIFI_STA_CONNECTIVITY) ? is_wifi_connected() : is_ppp_connected();
+}
+
+/* DNS servers learned by the link 'io'; returns their number */
+static size_t dns_link_servers(connectivity_t io, ip_addr_t servers[2])
+{
+    size_t count = 0;
+
+    if (io == WIFI_STA_CONNECTIVITY) {
+        servers[count++] = *get_wifi_dns_address();
+    } else {
+        servers[count++] = *get_ppp_dns_address();
+        servers[count++] = *get_ppp_dns_2_address();
+    }
+    return count;
+}
+
+/* Whether an entry should be resolved now: not resolved yet, or most of
+ * its TTL gone; not before the wait after a failure
+ */
+static bool dns_entry_is_due(const dns_entry_t *entry, cy_time_t now)
+{
+    if ((entry->retry_at != 0) && ((int32_t)(now - entry->retry_at) < 0)) {
+        return false;
+    }
+    return (entry->resolved == 0) ||
+           ((uint32_t)(now - entry->resolved) >=
+            ((entry->ttl_ms / 100u) * DNS_CACHE_PREFETCH_PERCENT));
+}
+
+static void dns_link_event(const link_event_t *event, void *arg)
+{
+    int link = dns_link_index(event->io);
+    uint32_t state;
+
+    (void) arg;
+
+    if (link < 0) {
+        return;
+    }
+
+    /* Try the new DNS servers at once, even after a failure */
+    state = cyhal_system_critical_section_enter();
+    for (size_t i = 0; i < DNS_CACHE_MAX_HOSTS; i++) {
+        s_hosts[i].entries[link].retry_at = 0;
+    }
+    cyhal_system_critical_section_exit(state);
+
+    (void) cy_rtos_set_semaphore(&s_wakeup, false);
+}
+
+static void dns_put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+static uint16_t dns_get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t dns_get_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* Query of the A record of 'name'; returns its size, 0 if it does not fit */
+static size_t dns_build_query(uint8_t *buf, size_t size, uint16_t id, const char *name)
+{
+    size_t pos = DNS_HEADER_SIZE;
+
+    if (size < (DNS_HEADER_SIZE + strlen(name) + 2 + 4)) {
+        return 0;
+    }
+
+    memset(buf, 0, DNS_HEADER_SIZE);
+    dns_put_u16(&buf[0], id);
+    buf[2] = DNS_FLAG_RD;
+    dns_put_u16(&buf[4], 1);    /* one question */
+
+    /* "broker.example.com" as 6broker7example3com0 */
+    while (*name != '\0') {
+        const char *dot = strchr(name, '.');
+        size_t len = (dot != NULL) ? (size_t)(dot - name) : strlen(name);
+
+        if ((len == 0) || (len > DNS_LABEL_MAX_LEN)) {
+            return 0;
+        }
+        buf[pos++] = (uint8_t)len;
+        memcpy(&buf[pos], name, len);
+        pos += len;
+        name += len;
+        if (*name == '.') {
+            name++;
+        }
+    }
+    buf[pos++] = 0;
+
+    dns_put_u16(&buf[pos], DNS_TYPE_A);
+    dns_put_u16(&buf[pos + 2], DNS_CLASS_IN);
+    return pos + 4;
+}
+
+/* Offset after the name at 'pos', 0 if malformed */
+static size_t dns_skip_name(const uint8_t *buf, size_t len, size_t pos)
+{
+    while (pos < len) {
+        uint8_t label = buf[pos];
+
+        if (label == 0) {
+            return pos + 1;
+        }
+        if ((label & 0xC0u) == 0xC0u) {
+            /* a compression pointer ends the name */
+            return ((pos + 2) <= len) ? (pos + 2) : 0;
+        }
+        if ((label & 0xC0u) != 0) {
+            return 0;
+        }
+        pos += 1u + label;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: dns_parse_response
+ ******************************************************************************
+ * Summary:
+ *  Function that takes the first A record out of the response to the query
+ *  'id'. Its TTL is the lowest TTL of the answers, as the CNAME records
+ *  that lead to it expire as well.
+ *
+ * Parameters:
+ *  const uint8_t *buf : the response
+ *  size_t len : its size
+ *  uint16_t id : identifier of the query
+ *  ip_addr_t *addr : the address
+ *  uint32_t *ttl_sec : its TTL, in seconds
+ *
+ * Return:
+ *  bool : false if the response is not for the query, is an error or has
+ *         no address
+ *
+ ******************************************************************************/
+static bool dns_parse_response(const uint8_t *buf, size_t len, uint16_t id,
+                               ip_addr_t *addr, uint32_t *ttl_sec)
+{
+    size_t pos = DNS_HEADER_SIZE;
+    uint16_t questions;
+    uint16_t answers;
+    bool found = false;
+
+    if ((len < DNS_HEADER_SIZE) || (dns_get_u16(&buf[0]) != id) ||
+        !(buf[2] & DNS_FLAG_QR) || ((buf[3] & DNS_RCODE_MASK) != 0)) {
+        return false;
+    }
+    questions = dns_get_u16(&buf[4]);
+    answers = dns_get_u16(&buf[6]);
+
+    for (uint16_t i = 0; i < questions; i++) {
+        pos = dns_skip_name(buf, len, pos);
+        if ((pos == 0) || ((pos + 4) > len)) {
+            return false;
+        }
+        pos += 4;
+    }
+
+    *ttl_sec = UINT32_MAX;
+    for (uint16_t i = 0; i < answers; i++) {
+        uint16_t type;
+        uint16_t rclass;
+        uint32_t ttl;
+        uint16_t rdlength;
+
+        pos = dns_skip_name(buf, len, pos);
+        if ((pos == 0) || ((pos + 10) > len)) {
+            return false;
+        }
+        type = dns_get_u16(&buf[pos]);
+        rclass = dns_get_u16(&buf[pos + 2]);
+        ttl = dns_get_u32(&buf[pos + 4]);
+        rdlength = dns_get_u16(&buf[pos + 8]);
+        pos += 10;
+        if ((pos + rdlength) > len) {
+            return false;
+        }
+
+        if (ttl < *ttl_sec) {
+            *ttl_sec = ttl;
+        }
+        if (!found && (type == DNS_TYPE_A) && (rclass == DNS_CLASS_IN) && (rdlength == 4)) {
+            /* the record holds the address in network order, as lwIP does */
+            uint32_t ip_v4;
+
+            memcpy(&ip_v4, &buf[pos], sizeof(ip_v4));
+            ip_addr_set_ip4_u32(addr, ip_v4);
+            found = true;
+        }
+        pos += rdlength;
+    }
+
+    return found;
+}
+
+/******************************************************************************
+ * Function Name: dns_resolve
+ ******************************************************************************
+ * Summary:
+ *  Function that asks the DNS servers of the link 'io', in turn, for the
+ *  address of 'name'. The query goes out over the netif of 'io', whichever
+ *  link is the default I/O.
+ *
+ * Parameters:
+ *  connectivity_t io : the link
+ *  const char *name : the hostname
+ *  ip_addr_t *addr : its address
+ *  uint32_t *ttl_sec : TTL of the address, in seconds
+ *
+ * Return:
+ *  bool : false if no server gave an address
+ *
+ ******************************************************************************/
+static bool dns_resolve(connectivity_t io, const char *name, ip_addr_t *addr, uint32_t *ttl_sec)
+{
+    const cy_wcm_ip_address_t *local = (io == WIFI_STA_CONNECTIVITY) ?
+                                       get_wifi_ip_address() : get_ppp_ip_address();
+    uint8_t buf[DNS_MESSAGE_MAX_SIZE];
+    ip_addr_t servers[2];
+    size_t server_count;
+    struct ifreq ifr;
+    struct sockaddr_in remote;
+    struct timeval timeout;
+    bool found = false;
+    int sock;
+
+    memset(&ifr, 0, sizeof(ifr));
+    if ((local->version != CY_WCM_IP_VER_V4) ||
+        !get_netif_name(local->ip.v4, ifr.ifr_name, sizeof(ifr.ifr_name))) {
+        return false;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return false;
+    }
+
+    timeout.tv_sec = DNS_QUERY_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (DNS_QUERY_TIMEOUT_MS % 1000) * 1000;
+    if ((setsockopt(sock, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr)) != 0) ||
+        (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0)) {
+        closesocket(sock);
+        return false;
+    }
+
+    server_count = dns_link_servers(io, servers);
+    for (size_t i = 0; (i < server_count) && !found; i++) {
+        uint16_t id = dns_next_query_id();
+        size_t len = dns_build_query(buf, sizeof(buf), id, name);
+        int received;
+
+        if ((len == 0) || !IP_IS_V4(&servers[i]) || ip_addr_isany(&servers[i])) {
+            continue;
+        }
+
+        memset(&remote, 0, sizeof(remote));
+        remote.sin_len = sizeof(remote);
+        remote.sin_family = AF_INET;
+        remote.sin_port = htons(DNS_PORT);
+        remote.sin_addr.s_addr = ip4_addr_get_u32(ip_2_ip4(&servers[i]));
+
+        s_stats.queries++;
+        if (sendto(sock, buf, len, 0, (struct sockaddr *)&remote, sizeof(remote)) < 0) {
+            continue;
+        }
+        mqtt_uplink_budget_charge(len + DNS_UDP_OVERHEAD, (io == CELLULAR_CONNECTIVITY));
+
+        /* Answers to an earlier, timed out query are skipped, and so is
+         * anything that does not come from the server queried
+         */
+        while (!found) {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+
+            received = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+            if (received <= 0) {
+                break;
+            }
+            if ((from_len < sizeof(from)) || (from.sin_family != AF_INET) ||
+                (from.sin_port != remote.sin_port) ||
+                (from.sin_addr.s_addr != remote.sin_addr.s_addr)) {
+                continue;
+            }
+            found = dns_parse_response(buf, (size_t)received, id, addr, ttl_sec);
+        }
+    }
+
+    closesocket(sock);
+    return found;
+}
+
+/* Resolve 'host' over 'link' and update its entry */
+static void dns_refresh(dns_host_t *host, size_t link, cy_time_t now)
+{
+    connectivity_t io = s_links[link];
+    dns_entry_t *entry = &host->entries[link];
+    ip_addr_t addr;
+    uint32_t ttl_sec = 0;
+    uint32_t state;
+
+    ip_addr_set_zero(&addr);
+
+    if (dns_resolve(io, host->name, &addr, &ttl_sec)) {
+        if (ttl_sec < DNS_CACHE_TTL_MIN_SEC) {
+            ttl_sec = DNS_CACHE_TTL_MIN_SEC;
+        } else if (ttl_sec > DNS_CACHE_TTL_MAX_SEC) {
+            ttl_sec = DNS_CACHE_TTL_MAX_SEC;
+        }
+
+        state = cyhal_system_critical_section_enter();
+        entry->addr = addr;
+        entry->resolved = (now != 0) ? now : 1;
+        entry->ttl_ms = ttl_sec * 1000u;
+        entry->retry_at = 0;
+        cyhal_system_critical_section_exit(state);
+
+        CY_LOGD(TAG, "%s over %s: %s, TTL %lu s", host->name, get_connectivity_type(io),
+                ipaddr_ntoa(&addr), (unsigned long)ttl_sec);
+    } else {
+        /* The address, if any, is served until DNS_CACHE_STALE_MAX_SEC */
+        state = cyhal_system_critical_section_enter();
+        entry->retry_at = now + DNS_CACHE_RETRY_MS;
+        if (entry->retry_at == 0) {
+            entry->retry_at = 1;
+        }
+        s_stats.failures++;
+        cyhal_system_critical_section_exit(state);
+
+        CY_LOGD(TAG, "%s over %s: no answer, retrying in %lu ms", host->name,
+                get_connectivity_type(io), (unsigned long)DNS_CACHE_RETRY_MS);
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void dns_cache_task(cy_thread_arg_t arg)
+{
+    cy_rslt_t result;
+
+    (void) arg;
+
+    result = cy_rtos_init_semaphore(&s_wakeup, 1, 0);
+    VoidAssert(result == CY_RSLT_SUCCESS);
+    dns_seed_query_id();
+    s_task_ready = true;
+
+    (void) link_events_subscribe(LINK_EVENT_DNS_CHANGED, dns_link_event, NULL);
+
+    while (true) {
+        cy_time_t now = 0;
+
+        (void) cy_rtos_get_semaphore(&s_wakeup, DNS_CACHE_POLL_MS, false);
+
+        for (size_t i = 0; i < DNS_CACHE_MAX_HOSTS; i++) {
+            dns_host_t *host = &s_hosts[i];
+
+            if (host->name[0] == '\0') {
+                continue;
+            }
+
+            for (size_t link = 0; link < DNS_LINK_COUNT; link++) {
+                cy_rtos_get_time(&now);
+                if (dns_link_is_up(s_links[link]) &&
+                    dns_entry_is_due(&host->entries[link], now)) {
+                    dns_refresh(host, link, now);
+                }
+            }
+        }
+    }
+}
+
+bool dns_cache_lookup(connectivity_t io, const char *hostname, ip_addr_t *addr)
+{
+    int link = dns_link_index(io);
+    dns_host_t *host = NULL;
+    dns_entry_t entry;
+    cy_time_t now = 0;
+    uint32_t age;
+    uint32_t state;
+    bool found = false;
+    bool wakeup = false;
+    ip_addr_t literal;
+
+    /* An address needs no lookup, nor a name too long for the cache */
+    if ((link < 0) || (strlen(hostname) > DNS_CACHE_HOSTNAME_MAX_LEN) ||
+        ipaddr_aton(hostname, &literal)) {
+        return false;
+    }
+
+    cy_rtos_get_time(&now);
+    memset(&entry, 0, sizeof(entry));
+
+    state = cyhal_system_critical_section_enter();
+    for (size_t i = 0; i < DNS_CACHE_MAX_HOSTS; i++) {
+        if (strcmp(s_hosts[i].name, hostname) == 0) {
+            host = &s_hosts[i];
+            break;
+        }
+        if ((host == NULL) && (s_hosts[i].name[0] == '\0')) {
+            host = &s_hosts[i];     /* first free one, taken if not found */
+        }
+    }
+    if ((host != NULL) && (host->name[0] == '\0')) {
+        strcpy(host->name, hostname);
+        wakeup = true;
+    }
+    if (host != NULL) {
+        entry = host->entries[link];
+    }
+
+    if (entry.resolved != 0) {
+        age = (uint32_t)(now - entry.resolved);
+        if (age < entry.ttl_ms) {
+            s_stats.hits++;
+            found = true;
+        } else if ((age - entry.ttl_ms) < (DNS_CACHE_STALE_MAX_SEC * 1000u)) {
+            /* stale while it is being resolved again */
+            s_stats.stale_hits++;
+            found = true;
+            wakeup = true;
+        }
+    }
+    if (!found) {
+        s_stats.misses++;
+        wakeup = true;
+    }
+    cyhal_system_critical_section_exit(state);
+
+    if (found) {
+        *addr = entry.addr;
+    }
+    if (wakeup && s_task_ready) {
+        (void) cy_rtos_set_semaphore(&s_wakeup, false);
+    }
+    return found;
+}
+
+void dns_cache_print_stats(void)
+{
+    cy_time_t now = 0;
+
+    cy_rtos_get_time(&now);
+
+    for (size_t i = 0; i < DNS_CACHE_MAX_HOSTS; i++) {
+        const dns_host_t *host = &s_hosts[i];
+
+        if (host->name[0] == '\0') {
+            continue;
+        }
+
+        for (size_t link = 0; link < DNS_LINK_COUNT; link++) {
+            dns_entry_t entry = host->entries[link];
+
+            if (entry.resolved == 0) {
+                PRINT_MSG(("%s over %s: not resolved\n", host->name,
+                           get_connectivity_type(s_links[link])));
+                continue;
+            }
+
+            PRINT_MSG(("%s over %s: %s, age %lu s, TTL %lu s\n", host->name,
+                       get_connectivity_type(s_links[link]),
+                       ipaddr_ntoa(&entry.addr),
+                       (unsigned long)((uint32_t)(now - entry.resolved) / 1000u),
+                       (unsigned long)(entry.ttl_ms / 1000u)));
+        }
+    }
+
+    PRINT_MSG(("hits=%lu stale=%lu misses=%lu queries=%lu failures=%lu\n",
+               (unsigned long)s_stats.hits,
+               (unsigned long)s_stats.stale_hits,
+               (unsigned long)s_stats.misses,
+               (unsigned long)s_stats.queries,
+               (unsigned long)s_stats.failures));
+}
+
+#endif /* FEATURE_DNS_CACHE */
+
+/* [] END OF FILE */
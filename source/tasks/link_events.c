@@ -0,0 +1,150 @@
+/******************************************************************************
+* File Name:   link_events.c
+*
+* Description: This file broadcasts the state changes of the Wi-Fi and cellular
+*              links to the tasks that subscribe to them
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "link_events.h"
+#include "link_config.h"
+
+#include "cyhal.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+typedef struct
+{
+    uint32_t mask;
+    link_event_cb_t cb;
+    void *arg;
+} link_subscriber_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "link_events";
+
+/* Subscribers are only added, so that publishing needs no lock */
+static link_subscriber_t s_subscribers[LINK_EVENTS_MAX_SUBSCRIBERS];
+static volatile uint32_t s_subscriber_count = 0;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+bool link_events_subscribe(uint32_t mask,
+                           link_event_cb_t cb,
+                           void *arg)
+{
+    uint32_t state;
+    bool result = false;
+
+    if (cb == NULL) {
+        return false;
+    }
+
+    state = cyhal_system_critical_section_enter();
+
+    for (uint32_t i = 0; i < s_subscriber_count; i++) {
+        if ((s_subscribers[i].cb == cb) && (s_subscribers[i].arg == arg)) {
+            s_subscribers[i].mask = mask;
+            result = true;
+            break;
+        }
+    }
+
+    if (!result && (s_subscriber_count < LINK_EVENTS_MAX_SUBSCRIBERS)) {
+        s_subscribers[s_subscriber_count].mask = mask;
+        s_subscribers[s_subscriber_count].cb = cb;
+        s_subscribers[s_subscriber_count].arg = arg;
+        s_subscriber_count++;
+        result = true;
+    }
+
+    cyhal_system_critical_section_exit(state);
+
+    if (!result) {
+        CY_LOGE(TAG, "No room for another subscriber");
+    }
+    return result;
+}
+
+void link_events_publish(connectivity_t io,
+                         uint32_t type,
+                         common_status_t status)
+{
+    link_event_t event = {
+        .type = type,
+        .io = io,
+        .status = status,
+    };
+    uint32_t count = s_subscriber_count;
+
+    CY_LOGD(TAG, "%s %s %s", get_connectivity_type(io), link_event_name(type),
+            (type == LINK_EVENT_STATUS) ? get_common_status_str(status) : "");
+
+    for (uint32_t i = 0; i < count; i++) {
+        if ((s_subscribers[i].mask & type) != 0) {
+            s_subscribers[i].cb(&event, s_subscribers[i].arg);
+        }
+    }
+}
+
+const char* link_event_name(uint32_t type)
+{
+    switch (type) {
+    case LINK_EVENT_STATUS:
+        return "status";
+
+    case LINK_EVENT_IP_UP:
+        return "IP up";
+
+    case LINK_EVENT_IP_DOWN:
+        return "IP down";
+
+    case LINK_EVENT_DNS_CHANGED:
+        return "DNS changed";
+
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,99 @@
+/******************************************************************************
+* File Name:   link_events.h
+*
+* Description: This file is the public interface of link_events.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_LINK_EVENTS_H_
+#define SOURCE_LINK_EVENTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cy_pcm.h"
+#include "common_task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Events of the Wi-Fi and cellular links; a subscriber gives a mask */
+#define LINK_EVENT_STATUS           (1u << 0)   /* the I/O task status changed */
+#define LINK_EVENT_IP_UP            (1u << 1)   /* the link has its IP address */
+#define LINK_EVENT_IP_DOWN          (1u << 2)   /* the link lost it, or was stopped */
+#define LINK_EVENT_DNS_CHANGED      (1u << 3)   /* the link has learned its DNS servers */
+#define LINK_EVENT_ALL              (0x0Fu)
+
+typedef struct
+{
+    uint32_t type;                      /* one LINK_EVENT_ */
+    connectivity_t io;
+    common_status_t status;             /* LINK_EVENT_STATUS only */
+} link_event_t;
+
+/* Called in the context of the task that publishes the event, which may
+ * be the connection manager's: post to a queue or notify, do not block.
+ */
+typedef void (*link_event_cb_t)(const link_event_t *event, void *arg);
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Deliver the events of 'mask' to 'cb' from now on. Subscribing the same
+ * cb and arg again replaces the mask; there are LINK_EVENTS_MAX_SUBSCRIBERS.
+ */
+bool link_events_subscribe(uint32_t mask,
+                           link_event_cb_t cb,
+                           void *arg);
+
+/* Deliver an event to its subscribers, from a task */
+void link_events_publish(connectivity_t io,
+                         uint32_t type,
+                         common_status_t status);
+
+const char* link_event_name(uint32_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_LINK_EVENTS_H_ */
+
+/* [] END OF FILE */
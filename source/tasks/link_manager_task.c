@@ -0,0 +1,359 @@
+/******************************************************************************
+* File Name:   link_manager_task.c
+*
+* Description: This file contains the link manager task, which keeps the Wi-Fi and
+*              cellular links up and moves the default I/O to the better one
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "link_manager_task.h"
+#include "link_quality.h"
+#include "link_events.h"
+#include "common_task.h"
+#include "wifi_task.h"
+#include "ppp_task.h"
+#include "mqtt_task.h"
+
+#include "fake_io.h"
+
+#include <lwip/dns.h>     /* for dns_setserver */
+
+#include "link_config.h"
+#include "cy_debug.h"
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE) && \
+    ((FEATURE_WIFI != ENABLE_FEATURE) || (FEATURE_PPP != ENABLE_FEATURE))
+#error "FEATURE_LINK_MANAGER needs FEATURE_WIFI and FEATURE_PPP"
+#endif
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* A link that has to be up, and since when it is not */
+typedef struct
+{
+    connectivity_t io;
+    cy_time_t down_since;
+    bool down;
+} link_state_t;
+
+
+/*-- Public Data -------------------------------------------------*/
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+cy_thread_t g_link_manager_task_handle = NULL;
+#endif
+
+
+/*-- Local Data -------------------------------------------------*/
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+static const char *TAG = "link_manager";
+
+static link_state_t s_links[] =
+{
+    { .io = WIFI_STA_CONNECTIVITY },
+    { .io = CELLULAR_CONNECTIVITY },
+};
+
+/* Link that scores better than the default I/O, and since when */
+static connectivity_t s_candidate = NO_CONNECTIVITY;
+static cy_time_t s_candidate_since = 0;
+
+/* Given by link events between two polls */
+static cy_semaphore_t s_wakeup;
+static volatile bool s_dns_changed = false;
+#endif
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* Use the DNS servers of 'io' */
+static void link_set_dns(connectivity_t io)
+{
+#if (FEATURE_WIFI == ENABLE_FEATURE)
+    if (io == WIFI_STA_CONNECTIVITY) {
+        const ip_addr_t* wifi_dns_addr = get_wifi_dns_address();
+        DEBUG_ASSERT(wifi_dns_addr != NULL);
+
+        dns_setserver(0, wifi_dns_addr);
+    }
+#endif
+
+#if (FEATURE_PPP == ENABLE_FEATURE)
+    if (io == CELLULAR_CONNECTIVITY) {
+        const ip_addr_t* ppp_dns_addr = get_ppp_dns_address();
+        const ip_addr_t* ppp_dns_2_addr = get_ppp_dns_2_address();
+        DEBUG_ASSERT(ppp_dns_addr != NULL);
+        DEBUG_ASSERT(ppp_dns_2_addr != NULL);
+
+        dns_setserver(0, ppp_dns_addr);
+        dns_setserver(1, ppp_dns_2_addr);
+    }
+#endif
+
+    (void) io;
+}
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+/******************************************************************************
+ * Function Name: link_manager_event
+ ******************************************************************************
+ * Summary:
+ *  Link event callback that wakes the link manager task, so that a link
+ *  going down is acted on without waiting for the next poll. A link that
+ *  has learned its DNS servers may have replaced those of the default I/O.
+ *
+ * Parameters:
+ *  const link_event_t *event : the event
+ *  void *arg : unused
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void link_manager_event(const link_event_t *event, void *arg)
+{
+    (void) arg;
+
+    if (event->type == LINK_EVENT_DNS_CHANGED) {
+        s_dns_changed = true;
+    }
+    (void) cy_rtos_set_semaphore(&s_wakeup, false);
+}
+
+/******************************************************************************
+ * Function Name: link_revive
+ ******************************************************************************
+ * Summary:
+ *  Function that restarts a link which has failed to start, or lost its
+ *  connection, for LINK_REVIVE_INTERVAL_MS, so that the standby link is
+ *  ready when the default I/O goes down. A link stopped from the console
+ *  is left alone.
+ *
+ * Parameters:
+ *  link_state_t *link : the link
+ *  cy_time_t now : current time
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void link_revive(link_state_t *link, cy_time_t now)
+{
+    bool down = (link->io == WIFI_STA_CONNECTIVITY) ? is_wifi_down() : is_ppp_down();
+
+    if (!down) {
+        link->down = false;
+        return;
+    }
+
+    if (!link->down) {
+        link->down = true;
+        link->down_since = now;
+        return;
+    }
+
+    if ((LINK_REVIVE_INTERVAL_MS > 0) &&
+        ((uint32_t)(now - link->down_since) >= LINK_REVIVE_INTERVAL_MS)) {
+        CY_LOGD(TAG, "Restarting %s, down for %lu ms",
+                get_connectivity_type(link->io),
+                (unsigned long)(now - link->down_since));
+
+        if (link->io == WIFI_STA_CONNECTIVITY) {
+            notify_wifi(NOTIF_RESTART_IO, false);
+        } else {
+            notify_ppp(NOTIF_RESTART_IO, false);
+        }
+        link->down_since = now;
+    }
+}
+
+/******************************************************************************
+ * Function Name: link_switch
+ ******************************************************************************
+ * Summary:
+ *  Function that makes 'io' the default I/O and moves the MQTT connections
+ *  to it. The new link is up already, and the old one is not stopped: the
+ *  MQTT sessions are closed over it and opened again over the new one.
+ *  While the old link works, the brokers are first resolved and reached
+ *  over the new one; if they cannot be, the default I/O stays.
+ *
+ *  This is still break-before-make: a second session cannot be opened
+ *  before the old one is closed, since the broker drops the older of two
+ *  sessions with the same client identifier, and another identifier would
+ *  lose the persistent session and its subscriptions. What is left of the
+ *  gap, the TLS handshake and the MQTT session, is shown by
+ *  mqtt_link_print_stats().
+ *
+ * Parameters:
+ *  connectivity_t io : the new default I/O
+ *  bool prepare : whether to reach the brokers over 'io' first
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void link_switch(connectivity_t io, bool prepare)
+{
+    cy_rslt_t result;
+
+    CY_LOGD(TAG, "Switching the default I/O from %s (score %u) to %s (score %u)",
+            get_connectivity_type(cy_pcm_get_default_connectivity()),
+            (unsigned int)link_quality_score(cy_pcm_get_default_connectivity()),
+            get_connectivity_type(io),
+            (unsigned int)link_quality_score(io));
+
+    if (prepare && !mqtt_link_prepare(io)) {
+        CY_LOGE(TAG, "Staying on %s", get_connectivity_type(cy_pcm_get_default_connectivity()));
+        return;
+    }
+
+    result = link_manager_set_default_io(io);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGE(TAG, "cy_pcm_set_default_connectivity failed with 0x%0X", (int)result);
+        return;
+    }
+
+    (void) mqtt_link_changed();
+}
+#endif
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+/******************************************************************************
+ * Function Name: link_manager_task
+ ******************************************************************************
+ * Summary:
+ *  Task that keeps both the Wi-Fi and the cellular link up, scores them
+ *  every LINK_MANAGER_POLL_MS, or at once when a link goes down, from the
+ *  moving measures of link_quality.c,
+ *  probing them when needed, and moves the default I/O to the better
+ *  one: at once when the default I/O is down, else once the other link has
+ *  scored LINK_SWITCH_MARGIN more for LINK_SWITCH_HOLD_MS. The MQTT app
+ *  moves its connections without being restarted.
+ *
+ * Parameters:
+ *  void *arg : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void link_manager_task(cy_thread_arg_t arg)
+{
+    cy_rslt_t result;
+
+    (void) arg;
+
+    result = cy_rtos_init_semaphore(&s_wakeup, 1, 0);
+    VoidAssert(result == CY_RSLT_SUCCESS);
+
+    (void) link_events_subscribe(LINK_EVENT_IP_DOWN | LINK_EVENT_DNS_CHANGED,
+                                 link_manager_event, NULL);
+
+    while (true) {
+        connectivity_t current;
+        connectivity_t other;
+        uint8_t current_score;
+        uint8_t other_score;
+        cy_time_t now = 0;
+
+        (void) cy_rtos_get_semaphore(&s_wakeup, LINK_MANAGER_POLL_MS, false);
+        cy_rtos_get_time(&now);
+
+        if (s_dns_changed) {
+            s_dns_changed = false;
+            link_set_dns(cy_pcm_get_default_connectivity());
+        }
+
+        for (size_t i = 0; i < (sizeof(s_links) / sizeof(s_links[0])); i++) {
+            link_revive(&s_links[i], now);
+            link_quality_update(s_links[i].io, now);
+        }
+
+        current = cy_pcm_get_default_connectivity();
+        other = (current == WIFI_STA_CONNECTIVITY) ? CELLULAR_CONNECTIVITY : WIFI_STA_CONNECTIVITY;
+        current_score = link_quality_score(current);
+        other_score = link_quality_score(other);
+
+        if ((other_score == 0) ||
+            ((current_score > 0) && (other_score < (current_score + LINK_SWITCH_MARGIN)))) {
+            s_candidate = NO_CONNECTIVITY;
+            continue;
+        }
+
+        if (current_score == 0) {
+            /* Nothing to lose by switching now */
+            s_candidate = NO_CONNECTIVITY;
+            link_switch(other, false);
+
+        } else if (s_candidate != other) {
+            s_candidate = other;
+            s_candidate_since = now;
+
+        } else if ((uint32_t)(now - s_candidate_since) >= LINK_SWITCH_HOLD_MS) {
+            s_candidate = NO_CONNECTIVITY;
+            link_switch(other, true);
+        }
+    }
+}
+#endif /* FEATURE_LINK_MANAGER */
+
+cy_rslt_t link_manager_set_default_io(connectivity_t io)
+{
+    cy_rslt_t result = CY_RSLT_PCM_FAILED;
+
+#if (FEATURE_WIFI == ENABLE_FEATURE)
+    if (io == WIFI_STA_CONNECTIVITY) {
+        result = cy_pcm_set_default_connectivity(io);
+        link_set_dns(io);
+    }
+#endif
+
+#if (FEATURE_PPP == ENABLE_FEATURE)
+    if (io == CELLULAR_CONNECTIVITY) {
+        result = cy_pcm_set_default_connectivity(io);
+        link_set_dns(io);
+    }
+#endif
+
+    return result;
+}
+
+/* [] END OF FILE */
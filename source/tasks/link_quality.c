@@ -0,0 +1,479 @@
+/******************************************************************************
+* File Name:   link_quality.c
+*
+* Description: This file measures the quality of the Wi-Fi and cellular links:
+*              signal strength, round-trip time and loss, as moving averages
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "link_quality.h"
+#include "dns_cache_task.h"
+#include "common_task.h"
+#include "wifi_task.h"
+#include "ppp_task.h"
+
+#include "fake_io.h"
+
+#if (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <lwip/api.h>       /* for netconn_gethostbyname */
+#include <lwip/sockets.h>
+
+#include "link_config.h"
+#include "mqtt_client_config.h"
+#include "mqtt_uplink_budget.h"
+#include "cyhal.h"
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* Moving averages hold their value scaled by this */
+#define LINK_QUALITY_EWMA_SCALE     (1 << LINK_QUALITY_EWMA_SHIFT)
+
+#define LINK_LOSS_MAX_PERMILLE      (1000)
+
+/* Uplink bytes of a probe: SYN, then ACK and FIN or RST, with IPv4 and TCP
+ * headers and options
+ */
+#define LINK_PROBE_UPLINK_BYTES     (3u * 60u)
+
+typedef enum
+{
+    LINK_PROBE_ANSWERED,        /* SYN-ACK or RST: the path works */
+    LINK_PROBE_LOST,
+    LINK_PROBE_SKIPPED,         /* no address, netif or socket to probe with */
+} link_probe_result_t;
+
+typedef struct
+{
+    connectivity_t io;
+    bool up;
+    bool has_rssi;
+    int32_t rssi_avg;
+    int32_t rtt_avg;
+    int32_t loss_avg;
+    cy_time_t last_sample;      /* last probe; 0 none */
+    ip_addr_t probe_addr;       /* last address of LINK_PROBE_HOST over this
+                                   link, kept for when DNS fails */
+    uint32_t rtt_samples;
+    uint32_t probes;
+    uint32_t lost;
+} link_quality_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "link_quality";
+
+static link_quality_t s_links[] =
+{
+    { .io = WIFI_STA_CONNECTIVITY },
+    { .io = CELLULAR_CONNECTIVITY },
+};
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static link_quality_t* link_find(connectivity_t io)
+{
+    for (size_t i = 0; i < (sizeof(s_links) / sizeof(s_links[0])); i++) {
+        if (s_links[i].io == io) {
+            return &s_links[i];
+        }
+    }
+    return NULL;
+}
+
+static int32_t link_ewma(int32_t avg, int32_t sample, bool first)
+{
+    if (first) {
+        return sample * LINK_QUALITY_EWMA_SCALE;
+    }
+    return avg + sample - (avg / LINK_QUALITY_EWMA_SCALE);
+}
+
+static bool link_is_up(connectivity_t io)
+{
+    return (io == WIFI_STA_CONNECTIVITY) ? is_wifi_connected() : is_ppp_connected();
+}
+
+/* Both rtt and loss are fed by a sample; called in a critical section */
+static void link_add_sample(link_quality_t *link, bool answered, uint32_t rtt_ms)
+{
+    bool first = ((link->rtt_samples + link->lost) == 0);
+    cy_time_t now = 0;
+
+    cy_rtos_get_time(&now);
+    link->last_sample = now;
+
+    link->loss_avg = link_ewma(link->loss_avg,
+                               answered ? 0 : LINK_LOSS_MAX_PERMILLE, first);
+    if (answered) {
+        link->rtt_avg = link_ewma(link->rtt_avg, (int32_t)rtt_ms, link->rtt_samples == 0);
+        link->rtt_samples++;
+    } else {
+        link->lost++;
+    }
+}
+
+/******************************************************************************
+ * Function Name: link_score
+ ******************************************************************************
+ * Summary:
+ *  Function that scores a link from its moving measures: the signal score,
+ *  scaled down by the loss, and by up to half for a slow round trip.
+ *  Called in a critical section.
+ *
+ * Parameters:
+ *  const link_quality_t *link : the link
+ *
+ * Return:
+ *  uint8_t : 0 when the link is down, else 1 to 100
+ *
+ ******************************************************************************/
+static uint8_t link_score(const link_quality_t *link)
+{
+    uint32_t signal = LINK_CELLULAR_SCORE;
+    uint32_t rtt_factor = 100;
+    uint32_t loss = (uint32_t)(link->loss_avg / LINK_QUALITY_EWMA_SCALE);
+    uint32_t score;
+
+    if (!link->up) {
+        return 0;
+    }
+
+    if (link->io == WIFI_STA_CONNECTIVITY) {
+        int32_t rssi = link->rssi_avg / LINK_QUALITY_EWMA_SCALE;
+
+        if (!link->has_rssi || (rssi <= LINK_WIFI_RSSI_MIN_DBM)) {
+            signal = 1;     /* up, however weak */
+        } else if (rssi >= LINK_WIFI_RSSI_MAX_DBM) {
+            signal = 100;
+        } else {
+            signal = 1 + ((rssi - LINK_WIFI_RSSI_MIN_DBM) * 99) /
+                         (LINK_WIFI_RSSI_MAX_DBM - LINK_WIFI_RSSI_MIN_DBM);
+        }
+    }
+
+    if (link->rtt_samples > 0) {
+        uint32_t rtt = (uint32_t)(link->rtt_avg / LINK_QUALITY_EWMA_SCALE);
+
+        if (rtt >= LINK_RTT_BAD_MS) {
+            rtt_factor = 50;
+        } else if (rtt > LINK_RTT_GOOD_MS) {
+            rtt_factor = 100 - ((rtt - LINK_RTT_GOOD_MS) * 50) /
+                               (LINK_RTT_BAD_MS - LINK_RTT_GOOD_MS);
+        }
+    }
+
+    if (loss > LINK_LOSS_MAX_PERMILLE) {
+        loss = LINK_LOSS_MAX_PERMILLE;
+    }
+
+    score = (signal * rtt_factor * (LINK_LOSS_MAX_PERMILLE - loss)) /
+            (100 * LINK_LOSS_MAX_PERMILLE);
+
+    return (score > 0) ? (uint8_t)score : 1;
+}
+
+/******************************************************************************
+ * Function Name: link_connect
+ ******************************************************************************
+ * Summary:
+ *  Function that times a TCP handshake with 'addr':'port' over the netif of
+ *  'io', whichever link is the default I/O, and closes the connection again.
+ *  A refused connection has crossed the link as well. The handshake counts
+ *  against the uplink budget of the link.
+ *
+ * Parameters:
+ *  connectivity_t io : the link
+ *  const ip_addr_t *addr : the IPv4 address to connect to
+ *  uint16_t port : the TCP port to connect to
+ *  uint32_t *rtt_ms : round-trip time of an answered handshake
+ *
+ * Return:
+ *  link_probe_result_t : whether the handshake was answered
+ *
+ ******************************************************************************/
+static link_probe_result_t link_connect(connectivity_t io, const ip_addr_t *addr,
+                                        uint16_t port, uint32_t *rtt_ms)
+{
+    const cy_wcm_ip_address_t *local = (io == WIFI_STA_CONNECTIVITY) ?
+                                       get_wifi_ip_address() : get_ppp_ip_address();
+    link_probe_result_t probe = LINK_PROBE_LOST;
+    struct ifreq ifr;
+    struct sockaddr_in remote;
+    struct timeval timeout;
+    fd_set writable;
+    cy_time_t start = 0;
+    cy_time_t end = 0;
+    int sock;
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+
+    memset(&ifr, 0, sizeof(ifr));
+    if ((local->version != CY_WCM_IP_VER_V4) ||
+        !get_netif_name(local->ip.v4, ifr.ifr_name, sizeof(ifr.ifr_name))) {
+        return LINK_PROBE_SKIPPED;
+    }
+
+    if (!IP_IS_V4(addr) || ip_addr_isany(addr)) {
+        return LINK_PROBE_SKIPPED;
+    }
+
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return LINK_PROBE_SKIPPED;
+    }
+
+    if ((setsockopt(sock, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr)) != 0) ||
+        (fcntl(sock, F_SETFL, O_NONBLOCK) != 0)) {
+        closesocket(sock);
+        return LINK_PROBE_SKIPPED;
+    }
+
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_len = sizeof(remote);
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(port);
+    remote.sin_addr.s_addr = ip4_addr_get_u32(ip_2_ip4(addr));
+
+    cy_rtos_get_time(&start);
+    mqtt_uplink_budget_charge(LINK_PROBE_UPLINK_BYTES, (io == CELLULAR_CONNECTIVITY));
+
+    if ((connect(sock, (struct sockaddr *)&remote, sizeof(remote)) == 0) ||
+        (errno == EINPROGRESS)) {
+        FD_ZERO(&writable);
+        FD_SET(sock, &writable);
+        timeout.tv_sec = LINK_PROBE_TIMEOUT_MS / 1000;
+        timeout.tv_usec = (LINK_PROBE_TIMEOUT_MS % 1000) * 1000;
+
+        if ((select(sock + 1, NULL, &writable, NULL, &timeout) > 0) &&
+            (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &error_len) == 0) &&
+            ((error == 0) || (error == ECONNREFUSED))) {
+            cy_rtos_get_time(&end);
+            *rtt_ms = (uint32_t)(end - start);
+            probe = LINK_PROBE_ANSWERED;
+        }
+    }
+
+    closesocket(sock);
+    return probe;
+}
+
+/******************************************************************************
+ * Function Name: link_probe
+ ******************************************************************************
+ * Summary:
+ *  Function that probes a link with a TCP handshake with LINK_PROBE_HOST.
+ *  A probe over cellular is skipped once the uplink budget drops the
+ *  batches.
+ *
+ * Parameters:
+ *  link_quality_t *link : the link, with the last address of LINK_PROBE_HOST
+ *  uint32_t *rtt_ms : round-trip time of an answered probe
+ *
+ * Return:
+ *  link_probe_result_t : whether the probe was answered
+ *
+ ******************************************************************************/
+static link_probe_result_t link_probe(link_quality_t *link, uint32_t *rtt_ms)
+{
+    connectivity_t io = link->io;
+    ip_addr_t addr;
+
+    if ((io == CELLULAR_CONNECTIVITY) &&
+        (mqtt_uplink_budget_level() >= MQTT_BUDGET_LEVEL_DROP_BULK)) {
+        return LINK_PROBE_SKIPPED;
+    }
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+    /* The address of the broker over this link, without waiting for DNS */
+    if (dns_cache_lookup(io, LINK_PROBE_HOST, &addr) ||
+        ipaddr_aton(LINK_PROBE_HOST, &addr)) {
+        link->probe_addr = addr;
+    }
+#else
+    if (netconn_gethostbyname(LINK_PROBE_HOST, &addr) == ERR_OK) {
+        link->probe_addr = addr;
+    }
+#endif
+
+    return link_connect(io, &link->probe_addr, LINK_PROBE_PORT, rtt_ms);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+void link_quality_update(connectivity_t io, cy_time_t now)
+{
+    link_quality_t *link = link_find(io);
+    link_probe_result_t probe;
+    uint32_t interval;
+    uint32_t rtt_ms = 0;
+    uint32_t state;
+
+    if (link == NULL) {
+        return;
+    }
+
+    if (!link_is_up(io)) {
+        if (link->up) {
+            ip_addr_t probe_addr = link->probe_addr;
+
+            state = cyhal_system_critical_section_enter();
+            memset(link, 0, sizeof(*link));
+            link->io = io;
+            link->probe_addr = probe_addr;
+            cyhal_system_critical_section_exit(state);
+        }
+        return;
+    }
+    link->up = true;
+
+#if (FEATURE_WIFI == ENABLE_FEATURE)
+    if (io == WIFI_STA_CONNECTIVITY) {
+        cy_wcm_associated_ap_info_t ap_info;
+
+        if (cy_wcm_get_associated_ap_info(&ap_info) == CY_RSLT_SUCCESS) {
+            state = cyhal_system_critical_section_enter();
+            link->rssi_avg = link_ewma(link->rssi_avg, ap_info.signal_strength, !link->has_rssi);
+            link->has_rssi = true;
+            cyhal_system_critical_section_exit(state);
+        }
+    }
+#endif
+
+    interval = (io == WIFI_STA_CONNECTIVITY) ?
+               LINK_PROBE_INTERVAL_WIFI_MS : LINK_PROBE_INTERVAL_CELLULAR_MS;
+    /* A link that has just come up is probed at once */
+    if ((interval == 0) ||
+        ((link->last_sample != 0) && ((uint32_t)(now - link->last_sample) < interval))) {
+        return;
+    }
+
+    probe = link_probe(link, &rtt_ms);
+    if (probe == LINK_PROBE_SKIPPED) {
+        link->last_sample = now;    /* retry after the interval */
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    link->probes++;
+    link_add_sample(link, (probe == LINK_PROBE_ANSWERED), rtt_ms);
+    cyhal_system_critical_section_exit(state);
+
+    CY_LOGD(TAG, "Probe over %s: %s, %lu ms", get_connectivity_type(io),
+            (probe == LINK_PROBE_ANSWERED) ? "answered" : "lost",
+            (unsigned long)rtt_ms);
+}
+
+uint8_t link_quality_score(connectivity_t io)
+{
+    link_quality_t *link = link_find(io);
+    uint8_t score;
+    uint32_t state;
+
+    if (link == NULL) {
+        return 0;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    score = link_score(link);
+    cyhal_system_critical_section_exit(state);
+
+    return score;
+}
+
+void link_quality_get_stats(connectivity_t io, link_quality_stats_t *stats)
+{
+    link_quality_t *link = link_find(io);
+    uint32_t state;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (link == NULL) {
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    stats->rssi_dbm = (int16_t)(link->rssi_avg / LINK_QUALITY_EWMA_SCALE);
+    stats->rtt_ms = (uint32_t)(link->rtt_avg / LINK_QUALITY_EWMA_SCALE);
+    stats->loss_permille = (uint16_t)(link->loss_avg / LINK_QUALITY_EWMA_SCALE);
+    stats->rtt_samples = link->rtt_samples;
+    stats->probes = link->probes;
+    stats->lost = link->lost;
+    stats->score = link_score(link);
+    cyhal_system_critical_section_exit(state);
+}
+
+bool link_quality_connect(connectivity_t io, const ip_addr_t *addr,
+                          uint16_t port, uint32_t *rtt_ms)
+{
+    return (link_connect(io, addr, port, rtt_ms) == LINK_PROBE_ANSWERED);
+}
+
+void link_quality_print_stats(void)
+{
+    for (size_t i = 0; i < (sizeof(s_links) / sizeof(s_links[0])); i++) {
+        link_quality_stats_t stats;
+
+        link_quality_get_stats(s_links[i].io, &stats);
+
+        PRINT_MSG(("%s: score=%u rssi=%d dBm rtt=%lu ms loss=%u/1000 "
+                   "samples=%lu probes=%lu lost=%lu\n",
+                   get_connectivity_type(s_links[i].io),
+                   (unsigned int)stats.score,
+                   (int)stats.rssi_dbm,
+                   (unsigned long)stats.rtt_ms,
+                   (unsigned int)stats.loss_permille,
+                   (unsigned long)stats.rtt_samples,
+                   (unsigned long)stats.probes,
+                   (unsigned long)stats.lost));
+    }
+}
+
+#endif /* FEATURE_LINK_MANAGER */
+
+/* [] END OF FILE */
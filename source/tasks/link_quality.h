@@ -0,0 +1,101 @@
+/******************************************************************************
+* File Name:   link_quality.h
+*
+* Description: This file is the public interface of link_quality.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_LINK_QUALITY_H_
+#define SOURCE_LINK_QUALITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cyabs_rtos.h"
+#include "cy_pcm.h"
+#include "lwip/ip_addr.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Moving measures of a link since it last came up */
+typedef struct
+{
+    int16_t rssi_dbm;                   /* Wi-Fi only */
+    uint32_t rtt_ms;                    /* 0 until the first sample */
+    uint16_t loss_permille;
+    uint32_t rtt_samples;
+    uint32_t probes;
+    uint32_t lost;
+    uint8_t score;
+} link_quality_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Sample the signal of 'io', and probe it every LINK_PROBE_INTERVAL_*_MS,
+ * the only source of its round-trip and loss samples. The measures are cleared while
+ * the link is down. Called periodically by one task; a probe blocks for up
+ * to LINK_PROBE_TIMEOUT_MS.
+ */
+void link_quality_update(connectivity_t io, cy_time_t now);
+
+/* Quality of a link, from 0 (down) to 100; see link_config.h */
+uint8_t link_quality_score(connectivity_t io);
+
+/* Open a TCP connection to 'addr':'port' over the netif of 'io', whichever
+ * link is the default I/O, and close it again: whether the link reaches a
+ * server before anything is moved to it. Blocks for up to
+ * LINK_PROBE_TIMEOUT_MS.
+ */
+bool link_quality_connect(connectivity_t io, const ip_addr_t *addr,
+                          uint16_t port, uint32_t *rtt_ms);
+
+void link_quality_get_stats(connectivity_t io, link_quality_stats_t *stats);
+
+void link_quality_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_LINK_QUALITY_H_ */
+
+/* [] END OF FILE */
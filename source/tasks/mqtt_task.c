@@ -52,12 +52,21 @@
 #include "common_task.h"
 #include "subscriber_task.h"
 #include "publisher_task.h"
+#include "publisher_queue.h"
+#include "mqtt_publish_window.h"
+#include "mqtt_credentials.h"
 #include "ppp_task.h"
 #include "wifi_task.h"
+#include "link_events.h"
+#include "link_quality.h"
+#include "bringup_timeline.h"
+#include "dns_cache_task.h"
+#include "mqtt_uplink_budget.h"
 
 /* Configuration file for Wi-Fi and MQTT client */
 #include "wifi_config.h"
 #include "mqtt_client_config.h"
+#include "link_config.h"
 
 /* Middleware libraries */
 #include "cy_retarget_io.h"
@@ -69,8 +78,12 @@
 
 /* LwIP header files */
 #include "lwip/netif.h"
+#include "lwip/dns.h"
+#include "lwip/api.h"         /* for netconn_gethostbyname */
+#include "lwip/tcpip.h"
 
 #include "cy_pcm.h"
+#include "fake_io.h"
 #include "cy_notification.h"
 #include "cy_console_ui.h"
 #include "cy_debug.h"
@@ -80,29 +93,36 @@
 /* Queue length of a message queue that is used to communicate the status of
  * various operations.
  */
-#define MQTT_TASK_QUEUE_LENGTH           (3u)
+#define MQTT_TASK_QUEUE_LENGTH           (3u * MQTT_CONNECTION_COUNT)
 
-/* Time in milliseconds to wait before creating the publisher task. */
+/* Maximum time in milliseconds to wait for the subscriptions before
+ * creating the publisher task.
+ */
 #define TASK_CREATION_DELAY_MS           (2000u)
 
-/* Flag Masks for tracking which cleanup functions must be called. */
+/* Step of the wait of mqtt_link_prepare() for the DNS cache */
+#define MQTT_LINK_PREPARE_POLL_MS        (100u)
+
+/* Flag Masks for tracking which cleanup functions must be called. The first
+ * one is kept in s_status_flag, the others per connection.
+ */
 #define LIBS_INITIALIZED                 (1lu << 2)
-#define BUFFER_INITIALIZED               (1lu << 3)
 #define MQTT_INSTANCE_CREATED            (1lu << 4)
 #define MQTT_CONNECTION_SUCCESS          (1lu << 5)
 #define MQTT_MSG_RECEIVED                (1lu << 6)
+#define MQTT_CONNECTION_LOST             (1lu << 7)
 
 /* Macro to check if the result of an operation was successful and set the
- * corresponding bit in the s_status_flag based on 'init_mask' parameter. When
+ * corresponding bit in 'status_flag' based on 'init_mask' parameter. When
  * it has failed, print the error message and return the result to the
  * calling function.
  */
-#define CHECK_RESULT(result, init_mask, error_message...)      \
+#define CHECK_RESULT(result, status_flag, init_mask, error_message...) \
                      do                                        \
                      {                                         \
                          if ((int)result == CY_RSLT_SUCCESS)   \
                          {                                     \
-                             s_status_flag |= init_mask;         \
+                             (status_flag) |= init_mask;       \
                          }                                     \
                          else                                  \
                          {                                     \
@@ -111,11 +131,36 @@
                          }                                     \
                      } while(0)
 
+/* State of one MQTT connection */
+typedef struct
+{
+    mqtt_conn_id_t id;
+    const char *name;
+
+    /* Flag to denote initialization status of the connection */
+    uint32_t status_flag;
+
+    /* Commands about the connection, for the task that manages it */
+    cy_queue_t *queue;
+
+    /* Moves to a new default I/O, and how long the connection was down */
+    uint32_t moves;
+    uint32_t move_gap_ms;
+    uint32_t move_gap_max_ms;
+
+} mqtt_conn_ctx_t;
+
+
+/*-- Local Function Prototypes -------------------------------------------------*/
+#if (MQTT_CONNECTION_COUNT > 1)
+static void mqtt_bulk_task(cy_thread_arg_t arg);
+#endif
+
 
 /*-- Public Data -------------------------------------------------*/
 
-/* MQTT connection handle. */
-cy_mqtt_t g_mqtt_connection = NULL;
+/* MQTT connection handles, indexed by mqtt_conn_id_t. */
+cy_mqtt_t g_mqtt_connection[MQTT_CONNECTION_COUNT] = {NULL};
 
 cy_thread_t g_mqtt_task_handle = NULL;
 
@@ -130,46 +175,60 @@ cy_queue_t g_mqtt_task_q = NULL;
 
 static const char *TAG = "mqtt_task";
 
-/* Flag to denote initialization status of various operations. */
+/* Flag to denote initialization status of the MQTT library. */
 static uint32_t s_status_flag = 0;
 
-/* Pointer to the network buffer needed by the MQTT library for MQTT send and
- * receive operations.
+#if (MQTT_CONNECTION_COUNT > 1)
+/* The bulk connection is connected, and reconnected, by a task of its own:
+ * its attempts never hold up the command connection.
  */
-static uint8_t *s_mqtt_network_buffer = NULL;
+static cy_queue_t s_bulk_q = NULL;
+static cy_thread_t s_bulk_task_handle = NULL;
+#endif
+
+static mqtt_conn_ctx_t s_conn[MQTT_CONNECTION_COUNT] =
+{
+    { .id = MQTT_CONN_COMMAND, .name = "command", .queue = &g_mqtt_task_q },
+#if (MQTT_CONNECTION_COUNT > 1)
+    { .id = MQTT_CONN_BULK, .name = "bulk", .queue = &s_bulk_q },
+#endif
+};
+
+/* Network buffers needed by the MQTT library for MQTT send and receive
+ * operations, one per connection. They are reserved statically, and the
+ * MQTT instances that use them are kept across restarts of the app, so that
+ * they do not go through the heap again.
+ */
+static uint8_t s_mqtt_network_buffer[MQTT_CONNECTION_COUNT][MQTT_NETWORK_BUFFER_SIZE];
 
 static cy_notification_t s_notification = {0};
 
 static bool s_mqtt_started = false;
+
+/* Given by the subscriber task once its first subscriptions are made */
+static cy_semaphore_t s_subscribed;
 static common_status_t s_mqtt_status = COMMON_STATUS_STOPPED;
 
+/* State of the pseudo-random generator used to jitter the reconnections */
+static uint32_t s_backoff_random = 0;
+
 
 /*-- Local Functions -------------------------------------------------*/
 
-static void handle_mqtt_disconnect_event(void)
+static void handle_mqtt_disconnect_event(mqtt_conn_ctx_t *ctx)
 {
-    mqtt_task_cmd_t mqtt_task_cmd;
-
-    /* Clear the status flag bit to indicate MQTT disconnection. */
-    s_status_flag &= ~(MQTT_CONNECTION_SUCCESS);
-
-    /* MQTT connection with the MQTT broker is broken as the client
-     * is unable to communicate with the broker. Set the appropriate
-     * command to be sent to the MQTT task.
+    /* Clear the status flag bit to indicate MQTT disconnection. The lost
+     * connection still has to be cleaned up by cy_mqtt_disconnect().
      */
-    CY_LOGD(TAG, "Unexpectedly disconnected from MQTT broker!");
-    mqtt_task_cmd = HANDLE_DISCONNECTION;
+    ctx->status_flag &= ~(MQTT_CONNECTION_SUCCESS);
+    ctx->status_flag |= MQTT_CONNECTION_LOST;
 
-    /* Send the message to the MQTT client task to handle the
-     * disconnection.
+    /* MQTT connection with the MQTT broker is broken as the client
+     * is unable to communicate with the broker. Send the message to the
+     * MQTT client task to handle the disconnection.
      */
-    if (CY_RSLT_SUCCESS != cy_rtos_put_queue(   &g_mqtt_task_q,
-            (void *)&mqtt_task_cmd,
-            CY_RTOS_NEVER_TIMEOUT,
-            false
-                                            )) {
-        CY_LOGD(TAG, "cy_rtos_put_queue(g_mqtt_task_q) failed!");
-    }
+    CY_LOGD(TAG, "Unexpectedly disconnected from MQTT broker (%s connection)!", ctx->name);
+    (void) mqtt_task_post(HANDLE_DISCONNECTION, ctx->id);
 }
 
 
@@ -188,7 +247,8 @@ static void handle_mqtt_disconnect_event(void)
  * Parameters:
  *  cy_mqtt_t mqtt_handle : MQTT handle corresponding to the MQTT event (unused)
  *  cy_mqtt_event_t event : MQTT event information
- *  void *user_data : User data pointer passed during cy_mqtt_create() (unused)
+ *  void *user_data : User data pointer passed during cy_mqtt_create(): the
+ *                    mqtt_conn_ctx_t of the connection
  *
  * Return:
  *  void
@@ -196,25 +256,26 @@ static void handle_mqtt_disconnect_event(void)
  ******************************************************************************/
 static void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *user_data)
 {
+    mqtt_conn_ctx_t *ctx = (mqtt_conn_ctx_t *)user_data;
     cy_mqtt_publish_info_t *received_msg;
 
     (void) mqtt_handle;
-    (void) user_data;
 
     switch(event.type) {
         case CY_MQTT_EVENT_TYPE_DISCONNECT: {
-            handle_mqtt_disconnect_event();
+            handle_mqtt_disconnect_event(ctx);
             break;
         }
 
         case CY_MQTT_EVENT_TYPE_SUBSCRIPTION_MESSAGE_RECEIVE: {
-            s_status_flag |= MQTT_MSG_RECEIVED;
+            ctx->status_flag |= MQTT_MSG_RECEIVED;
 
-            /* Incoming MQTT message has been received. Send this message to
-             * the subscriber callback function to handle it.
+            /* Incoming MQTT message has been received. Hand a copy to the
+             * subscriber task, which routes it to the handlers of the
+             * matching topic filters.
              */
             received_msg = &(event.data.pub_msg.received_message);
-            mqtt_subscription_callback(received_msg);
+            subscriber_post_message(received_msg);
             break;
         }
 
@@ -226,14 +287,102 @@ static void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, vo
     }
 }
 
+/******************************************************************************
+ * Function Name: mqtt_link_event
+ ******************************************************************************
+ * Summary:
+ *  Link event callback: when the default I/O gets its IP address, a
+ *  waiting MQTT connection attempt proceeds at once. The event goes through
+ *  the queue of the MQTT client task, so it cannot overwrite a pending
+ *  notification of the app.
+ *
+ * Parameters:
+ *  const link_event_t *event : the LINK_EVENT_IP_UP event
+ *  void *arg : unused
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_link_event(const link_event_t *event, void *arg)
+{
+    connectivity_t default_io = WIFI_STA_CONNECTIVITY;
+
+    (void) arg;
+
+#if (FEATURE_PPP == ENABLE_FEATURE)
+    default_io = cy_pcm_get_default_connectivity();
+#endif
+
+    if ((event->io == default_io) && (s_mqtt_status == COMMON_STATUS_STARTING || s_mqtt_started)) {
+        for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+            mqtt_task_data_t mqtt_task_data;
+
+            mqtt_task_data.cmd = HANDLE_IO_UP;
+            mqtt_task_data.conn = s_conn[i].id;
+
+            /* When the queue is full, the attempt goes on at the end of
+             * its backoff instead.
+             */
+            (void) cy_rtos_put_queue(s_conn[i].queue, (void *)&mqtt_task_data, 0, false);
+        }
+    }
+}
+
+
+/******************************************************************************
+ * Function Name: mqtt_update_broker
+ ******************************************************************************
+ * Summary:
+ *  Function that has the MQTT instance of a connection connect to the cached
+ *  address of its broker over 'io', so that connecting does not wait for
+ *  DNS. The address is put in the local host list of lwIP, which its
+ *  resolver looks at first; while nothing is cached, the hostname is
+ *  resolved as usual. The instance, and so the hostname sent as SNI, stay
+ *  the same: publishers may be using it.
+ *
+ * Parameters:
+ *  mqtt_conn_ctx_t *ctx : the connection, which is not connected
+ *  connectivity_t io : the link to connect over
+ *  bool use_cache : false to have the hostname resolved as usual, e.g.
+ *                   after a failed attempt on the cached address
+ *
+ * Return:
+ *  bool : whether the connection goes to a cached address
+ *
+ ******************************************************************************/
+static bool mqtt_update_broker(mqtt_conn_ctx_t *ctx, connectivity_t io, bool use_cache)
+{
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+    const char *hostname = broker_info[ctx->id].hostname;
+    ip_addr_t addr;
+    bool cached = use_cache && dns_cache_lookup(io, hostname, &addr);
+
+    LOCK_TCPIP_CORE();
+    (void) dns_local_removehost(hostname, NULL);
+    if (cached && (dns_local_addhost(hostname, &addr) != ERR_OK)) {
+        cached = false;
+    }
+    UNLOCK_TCPIP_CORE();
+
+    CY_LOGD(TAG, "MQTT %s connection to %s\n", ctx->name,
+            cached ? ipaddr_ntoa(&addr) : hostname);
+    return cached;
+#else
+    (void) ctx;
+    (void) io;
+    (void) use_cache;
+    return false;
+#endif /* FEATURE_DNS_CACHE */
+}
 
 /******************************************************************************
  * Function Name: mqtt_init
  ******************************************************************************
  * Summary:
- *  Function that initializes the MQTT library and creates an instance for the
- *  MQTT client. The network buffer needed by the MQTT library for MQTT send
- *  send and receive operations is also allocated by this function.
+ *  Function that initializes the MQTT library and creates an instance for
+ *  each MQTT connection, on its static network buffer. When the app
+ *  restarts, the instances created by the first start are reused.
  *
  * Parameters:
  *  void
@@ -249,22 +398,37 @@ static cy_rslt_t mqtt_init(void)
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
     /* Initialize the MQTT library. */
-    result = cy_mqtt_init();
-    CHECK_RESULT(result, LIBS_INITIALIZED, "MQTT library initialization failed!\n");
-
-    /* Allocate buffer for MQTT send and receive operations. */
-    s_mqtt_network_buffer = (uint8_t *) malloc(sizeof(uint8_t) * MQTT_NETWORK_BUFFER_SIZE);
-    if(s_mqtt_network_buffer == NULL) {
-        result = ~CY_RSLT_SUCCESS;
-    }
-    CHECK_RESULT(result, BUFFER_INITIALIZED, "Network Buffer allocation failed!\n");
-
-    /* Create the MQTT client instance. */
-    result = cy_mqtt_create(s_mqtt_network_buffer, MQTT_NETWORK_BUFFER_SIZE,
-                            security_info, &broker_info,
-                            (cy_mqtt_callback_t)mqtt_event_callback, NULL,
-                            &g_mqtt_connection);
-    CHECK_RESULT(result, MQTT_INSTANCE_CREATED, "MQTT instance creation failed!\n");
+    if (!(s_status_flag & LIBS_INITIALIZED)) {
+        result = cy_mqtt_init();
+        CHECK_RESULT(result, s_status_flag, LIBS_INITIALIZED, "MQTT library initialization failed!\n");
+    }
+
+    /* The receive queue and pool, before any connection feeds them. */
+    result = subscriber_init();
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+#if (MQTT_SECURE_CONNECTION)
+    /* Decode the PEM credentials to DER, on the first start only. */
+    mqtt_credentials_init(security_info);
+#endif /* MQTT_SECURE_CONNECTION */
+
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        mqtt_conn_ctx_t *ctx = &s_conn[i];
+
+        if (ctx->status_flag & MQTT_INSTANCE_CREATED) {
+            CY_LOGD(TAG, "Reusing the MQTT instance of the %s connection.\n", ctx->name);
+            continue;
+        }
+
+        /* Create the MQTT client instance. */
+        result = cy_mqtt_create(s_mqtt_network_buffer[i], MQTT_NETWORK_BUFFER_SIZE,
+                                security_info, &broker_info[i],
+                                (cy_mqtt_callback_t)mqtt_event_callback, ctx,
+                                &g_mqtt_connection[i]);
+        CHECK_RESULT(result, ctx->status_flag, MQTT_INSTANCE_CREATED, "MQTT instance creation failed!\n");
+    }
     CY_LOGD(TAG, "MQTT library initialization successful.\n");
 
     return result;
@@ -275,8 +439,9 @@ static cy_rslt_t mqtt_init(void)
  * Function Name: mqtt_cleanup
  ******************************************************************************
  * Summary:
- *  Function that invokes the deinit and cleanup functions for various
- *  operations based on the s_status_flag.
+ *  Function that disconnects the MQTT connections that were established, or
+ *  cleans up the lost ones that were not handled yet, so that the MQTT
+ *  instances can be kept for the next start of the app.
  *
  * Parameters:
  *  void
@@ -287,24 +452,53 @@ static cy_rslt_t mqtt_init(void)
  ******************************************************************************/
 static void mqtt_cleanup(void)
 {
-    /* Disconnect the MQTT connection if it was established. */
-    if (s_status_flag & MQTT_CONNECTION_SUCCESS) {
-        CY_LOGD(TAG, "Disconnecting from the MQTT Broker...");
-        cy_mqtt_disconnect(g_mqtt_connection);
-    }
-    /* Delete the MQTT instance if it was created. */
-    if (s_status_flag & MQTT_INSTANCE_CREATED) {
-        cy_mqtt_delete(g_mqtt_connection);
-        g_mqtt_connection = NULL;
+    /* No publish of the ring may be in flight on a deleted connection. */
+    (void) mqtt_publish_window_stop(MQTT_PUBLISH_WINDOW_STOP_TIMEOUT_MS);
+
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        mqtt_conn_ctx_t *ctx = &s_conn[i];
+
+        /* Disconnect the MQTT connection if it was established. */
+        if (ctx->status_flag & (MQTT_CONNECTION_SUCCESS | MQTT_CONNECTION_LOST)) {
+            CY_LOGD(TAG, "Disconnecting the %s connection from the MQTT Broker...", ctx->name);
+            cy_mqtt_disconnect(g_mqtt_connection[i]);
+            ctx->status_flag &= ~(MQTT_CONNECTION_SUCCESS | MQTT_CONNECTION_LOST);
+        }
     }
-    /* Deallocate the network buffer. */
-    if (s_status_flag & BUFFER_INITIALIZED) {
-        free((void *) s_mqtt_network_buffer);
+}
+
+
+/******************************************************************************
+ * Function Name: mqtt_release
+ ******************************************************************************
+ * Summary:
+ *  Function that deletes the MQTT instances and deinitializes the MQTT
+ *  library, when the MQTT task ends.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_release(void)
+{
+    mqtt_cleanup();
+
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        /* Delete the MQTT instance if it was created. */
+        if (s_conn[i].status_flag & MQTT_INSTANCE_CREATED) {
+            cy_mqtt_delete(g_mqtt_connection[i]);
+            g_mqtt_connection[i] = NULL;
+        }
+        s_conn[i].status_flag = 0;
     }
     /* Deinit the MQTT library. */
     if (s_status_flag & LIBS_INITIALIZED) {
         cy_mqtt_deinit();
     }
+    s_status_flag = 0;
 }
 
 
@@ -314,7 +508,10 @@ static void mqtt_cleanup(void)
  ******************************************************************************
  * Summary:
  *  Function that generates unique client identifier for the MQTT client by
- *  appending a timestamp to a common prefix 'MQTT_CLIENT_IDENTIFIER'.
+ *  appending a timestamp to a common prefix 'MQTT_CLIENT_IDENTIFIER'. A
+ *  persistent session is bound to the client identifier, so with
+ *  MQTT_PERSISTENT_SESSION the silicon unique ID is appended instead. The
+ *  result is truncated to the buffer size.
  *
  * Parameters:
  *  char *mqtt_client_identifier : Pointer to the string that stores the
@@ -330,6 +527,17 @@ static cy_rslt_t mqtt_get_unique_client_identifier( char *mqtt_client_identifier
 {
     cy_rslt_t status = CY_RSLT_SUCCESS;
 
+#if MQTT_PERSISTENT_SESSION
+    uint64_t unique_id = Cy_SysLib_GetUniqueId();
+
+    /* Check for errors from snprintf. */
+    if (0 > snprintf(mqtt_client_identifier,
+                     buf_size,
+                     MQTT_CLIENT_IDENTIFIER "%08lx",
+                     (long unsigned int)((uint32_t)unique_id ^ (uint32_t)(unique_id >> 32)))) {
+        status = ~CY_RSLT_SUCCESS;
+    }
+#else
     /* Check for errors from snprintf. */
     if (0 > snprintf(mqtt_client_identifier,
                      buf_size,
@@ -337,6 +545,7 @@ static cy_rslt_t mqtt_get_unique_client_identifier( char *mqtt_client_identifier
                      (long unsigned int)Clock_GetTimeMs())) {
         status = ~CY_RSLT_SUCCESS;
     }
+#endif /* MQTT_PERSISTENT_SESSION */
 
     return status;
 }
@@ -344,26 +553,153 @@ static cy_rslt_t mqtt_get_unique_client_identifier( char *mqtt_client_identifier
 
 
 /******************************************************************************
- * Function Name: mqtt_connect
+ * Function Name: mqtt_backoff_random
  ******************************************************************************
  * Summary:
- *  Function that initiates MQTT connect operation. The connection is retried
- *  a maximum of 'MAX_MQTT_CONN_RETRIES' times with interval of
- *  'MQTT_CONN_RETRY_INTERVAL_MS' milliseconds.
+ *  Function that returns a pseudo-random number (xorshift32). The generator
+ *  is seeded from the unique ID of the device, so that devices that lost
+ *  the link at the same time do not retry in lockstep.
  *
  * Parameters:
  *  void
  *
  * Return:
+ *  uint32_t : pseudo-random number
+ *
+ ******************************************************************************/
+static uint32_t mqtt_backoff_random(void)
+{
+    uint32_t x = s_backoff_random;
+
+    if (x == 0) {
+        uint64_t unique_id = Cy_SysLib_GetUniqueId();
+
+        x = (uint32_t)unique_id ^ (uint32_t)(unique_id >> 32) ^ Clock_GetTimeMs();
+        if (x == 0) {
+            x = 0x2545F491u;
+        }
+    }
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_backoff_random = x;
+
+    return x;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_backoff_delay_ms
+ ******************************************************************************
+ * Summary:
+ *  Function that returns the delay before the next connection attempt:
+ *  capped exponential backoff with full jitter, i.e. uniformly random in
+ *  [0, min(MQTT_CONN_BACKOFF_MAX_MS, MQTT_CONN_BACKOFF_BASE_MS * 2^(failures - 1))].
+ *
+ * Parameters:
+ *  uint32_t failures : consecutive failed attempts (>= 1)
+ *
+ * Return:
+ *  uint32_t : delay in milliseconds
+ *
+ ******************************************************************************/
+static uint32_t mqtt_backoff_delay_ms(uint32_t failures)
+{
+    uint32_t ceiling = MQTT_CONN_BACKOFF_BASE_MS;
+
+    for (uint32_t i = 1; (i < failures) && (ceiling < MQTT_CONN_BACKOFF_MAX_MS); i++) {
+        ceiling *= 2;
+    }
+    if (ceiling > MQTT_CONN_BACKOFF_MAX_MS) {
+        ceiling = MQTT_CONN_BACKOFF_MAX_MS;
+    }
+
+    return mqtt_backoff_random() % (ceiling + 1);
+}
+
+/******************************************************************************
+ * Function Name: mqtt_connect_wait
+ ******************************************************************************
+ * Summary:
+ *  Function that waits between two connection attempts, on the queue of the
+ *  task that manages the connection: a HANDLE_IO_UP ends the wait early, a
+ *  HANDLE_EXIT_LOOP ends the attempts. A disconnection or a link change
+ *  needs nothing more, as the next attempt goes over the current default
+ *  I/O.
+ *
+ * Parameters:
+ *  mqtt_conn_ctx_t *ctx : the connection being established
+ *  uint32_t wait_ms : the longest wait
+ *  bool *io_up : set when the default I/O came up during the wait
+ *
+ * Return:
+ *  bool : false if the app is being stopped
+ *
+ ******************************************************************************/
+static bool mqtt_connect_wait(mqtt_conn_ctx_t *ctx,
+                              uint32_t wait_ms,
+                              bool *io_up)
+{
+    uint32_t start_ms = Clock_GetTimeMs();
+    uint32_t elapsed_ms = 0;
+
+    *io_up = false;
+
+    while (elapsed_ms < wait_ms) {
+        mqtt_task_data_t mqtt_status;
+
+        if (CY_RSLT_SUCCESS != cy_rtos_get_queue(ctx->queue,
+                                                 (void *)&mqtt_status,
+                                                 wait_ms - elapsed_ms,
+                                                 false)) {
+            break;
+        }
+
+        if (mqtt_status.cmd == HANDLE_IO_UP) {
+            *io_up = true;
+            return true;
+        }
+
+        if (mqtt_status.cmd == HANDLE_EXIT_LOOP) {
+            return false;
+        }
+
+        elapsed_ms = Clock_GetTimeMs() - start_ms;
+    }
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_connect
+ ******************************************************************************
+ * Summary:
+ *  Function that initiates MQTT connect operation. The command connection
+ *  is retried a maximum of 'MAX_MQTT_CONN_RETRIES' times, the bulk one until
+ *  it is up or the app is stopped. After a failed attempt, the
+ *  next one waits for mqtt_backoff_delay_ms(). While the I/O is down, it
+ *  waits for the HANDLE_IO_UP of its LINK_EVENT_IP_UP (at most
+ *  MQTT_CONN_BACKOFF_MAX_MS), and reconnects within
+ *  MQTT_CONN_IO_UP_JITTER_MS of it. A HANDLE_EXIT_LOOP, posted when the
+ *  app is stopped, ends the attempts.
+ *
+ * Parameters:
+ *  mqtt_conn_ctx_t *ctx : the connection to establish
+ *
+ * Return:
  *  cy_rslt_t : CY_RSLT_SUCCESS upon a successful MQTT connection, else an
  *              error code indicating the failure.
  *
  ******************************************************************************/
-static cy_rslt_t mqtt_connect(void)
+static cy_rslt_t mqtt_connect(mqtt_conn_ctx_t *ctx)
 {
     /* Variable to indicate status of various operations. */
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
+    /* Connection parameters; the Will message is sent on the command
+     * connection only.
+     */
+    cy_mqtt_connect_info_t connect_info;
+
     /* MQTT client identifier string. */
     char mqtt_client_identifier[(MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1)] = MQTT_CLIENT_IDENTIFIER;
 
@@ -380,45 +716,77 @@ static cy_rslt_t mqtt_connect(void)
      */
 #if GENERATE_UNIQUE_CLIENT_ID
     result = mqtt_get_unique_client_identifier(mqtt_client_identifier, sizeof(mqtt_client_identifier));
-    CHECK_RESULT(result, 0, "Failed to generate unique client identifier for the MQTT client!\n");
+    CHECK_RESULT(result, ctx->status_flag, 0, "Failed to generate unique client identifier for the MQTT client!\n");
 #endif /* GENERATE_UNIQUE_CLIENT_ID */
 
+    /* The connections of the device need distinct client identifiers. The
+     * suffix is kept when the identifier is at its maximum length.
+     */
+    if (ctx->id != MQTT_CONN_COMMAND) {
+        size_t len = strlen(mqtt_client_identifier);
+
+        if (len > (MQTT_CLIENT_IDENTIFIER_MAX_LEN - 2)) {
+            len = MQTT_CLIENT_IDENTIFIER_MAX_LEN - 2;
+        }
+        mqtt_client_identifier[len] = '-';
+        mqtt_client_identifier[len + 1] = (char)('0' + ctx->id);
+        mqtt_client_identifier[len + 2] = '\0';
+    }
+
     /* Set the client identifier buffer and length. */
-    g_mqtt_connection_info.client_id = mqtt_client_identifier;
-    g_mqtt_connection_info.client_id_len = strlen(mqtt_client_identifier);
+    connect_info = g_mqtt_connection_info;
+    connect_info.client_id = mqtt_client_identifier;
+    connect_info.client_id_len = strlen(mqtt_client_identifier);
+    if (ctx->id != MQTT_CONN_COMMAND) {
+        connect_info.will_info = NULL;
+    }
 
     CY_LOGD(TAG, "MQTT client '%.*s' connecting to MQTT broker '%.*s'...\n",
-           g_mqtt_connection_info.client_id_len,
-           g_mqtt_connection_info.client_id,
-           broker_info.hostname_len,
-           broker_info.hostname);
+           connect_info.client_id_len,
+           connect_info.client_id,
+           broker_info[ctx->id].hostname_len,
+           broker_info[ctx->id].hostname);
 
     result = CY_RSLT_MODULE_MQTT_ERROR;
 
-    for (uint32_t retry_count = 0; retry_count < MAX_MQTT_CONN_RETRIES; retry_count++) {
+    /* Consecutive failed attempts, and the wait before the next one */
+    uint32_t failures = 0;
+    uint32_t wait_ms = 0;
+
+    /* Set after a failed attempt on a cached address, which may be out of
+     * date: the next attempt resolves the hostname instead.
+     */
+    bool skip_cache = false;
+
+    /* The app does without the bulk connection, so it never gives up. */
+    uint32_t max_retries = (ctx->id == MQTT_CONN_COMMAND) ? MAX_MQTT_CONN_RETRIES : UINT32_MAX;
+
+    for (uint32_t retry_count = 0; retry_count < max_retries; retry_count++) {
         bool is_io_ready = false;
         connectivity_t default_io = NO_CONNECTIVITY;
 
         if (retry_count > 0) {
-            // Ask the user whether to connect to MQTT
-            // (This is useful if the eSIM profile is a test or terminated profile,
-            //  which will always fail to connect)
-            PRINT_MSG(("\n# Waiting %d sec for user intervention\n", MQTT_CONN_RETRY_INTERVAL_MS/1000));
-            PRINT_MSG(("  If you do not wish to start MQTT, press a key to enter the Console Menu,\n"));
-            PRINT_MSG(("  select Manage Apps -> MQTT -> Stop\n"));
-
-            uint32_t ulNotifiedValue = 0;
-            result = cy_notification_wait(&s_notification,
-                                          0x00,              /* Don't clear any notification bits on entry. */
-                                          UINT32_MAX,        /* Reset the notification value to 0 on exit. */
-                                          &ulNotifiedValue,  /* Notified value pass out in */
-                                          MQTT_CONN_RETRY_INTERVAL_MS);
-            if (ulNotifiedValue != 0) {
-                print_notified_value(ulNotifiedValue);
+            bool io_up;
 
-                if (ulNotifiedValue == NOTIF_STOP_APP) {
-                    CY_LOGD(TAG, "User does not want to start MQTT\n");
-                    return CY_RSLT_MODULE_MQTT_ERROR;
+            /* The app can be stopped meanwhile from the console, e.g. when
+             * the eSIM profile is a test or terminated one that always
+             * fails to connect: Manage Apps -> MQTT -> Stop.
+             */
+            CY_LOGD(TAG, "Waiting %lu ms before the next MQTT connection attempt", (unsigned long)wait_ms);
+
+            if (!mqtt_connect_wait(ctx, wait_ms, &io_up)) {
+                CY_LOGD(TAG, "User does not want to start MQTT\n");
+                return CY_RSLT_MODULE_MQTT_ERROR;
+            }
+
+            if (io_up) {
+                /* Fresh link: reconnect now, only spread over a short
+                 * window so that a fleet regaining coverage together
+                 * does not connect in lockstep.
+                 */
+                failures = 0;
+                if (MQTT_CONN_IO_UP_JITTER_MS > 0) {
+                    cy_rtos_delay_milliseconds(mqtt_backoff_random() % MQTT_CONN_IO_UP_JITTER_MS);
                 }
             }
         }
@@ -444,27 +812,50 @@ static cy_rslt_t mqtt_connect(void)
         if (is_io_ready) {
             // wait until PPP is available, otherwise wait until WIFI is avail
 
-            /* Establish the MQTT connection. */
-            result = cy_mqtt_connect(g_mqtt_connection, &g_mqtt_connection_info);
+            if (ctx->id == MQTT_CONN_COMMAND) {
+                bringup_timeline_mark(BRINGUP_STAGE_MQTT_CONNECT);
+            }
+
+            /* Establish the MQTT connection, to the cached address of
+             * the broker over the default I/O if there is one.
+             */
+            bool cached = mqtt_update_broker(ctx, default_io, !skip_cache);
+
+            /* Every attempt costs a TLS handshake on the link. */
+            mqtt_uplink_budget_charge(MQTT_UPLINK_CONNECT_OVERHEAD,
+                                      (default_io == CELLULAR_CONNECTIVITY));
+            result = cy_mqtt_connect(g_mqtt_connection[ctx->id], &connect_info);
 
             if (result == CY_RSLT_SUCCESS) {
-                CY_LOGD(TAG, "MQTT connection successful on %s.\n",
-                        get_connectivity_type(default_io));
+                if (ctx->id == MQTT_CONN_COMMAND) {
+                    bringup_timeline_mark(BRINGUP_STAGE_MQTT_CONNECTED);
+                }
+
+                CY_LOGD(TAG, "MQTT %s connection successful on %s.\n",
+                        ctx->name, get_connectivity_type(default_io));
 
-                /* Set the appropriate bit in the s_status_flag to denote successful
+                /* Set the appropriate bit in the status flag to denote successful
                  * MQTT connection, and return the result to the calling function.
                  */
-                s_status_flag |= MQTT_CONNECTION_SUCCESS;
+                ctx->status_flag |= MQTT_CONNECTION_SUCCESS;
                 return result;
             }
 
-            CY_LOGD(TAG, "MQTT connection failed with error code 0x%0X. Retrying in %d ms. Retries left: %d",
-                   (int)result, MQTT_CONN_RETRY_INTERVAL_MS, (int)(MAX_MQTT_CONN_RETRIES - retry_count - 1));
+            failures++;
+            wait_ms = mqtt_backoff_delay_ms(failures);
+            skip_cache = cached;
+
+            CY_LOGD(TAG, "MQTT %s connection failed with error code 0x%0X. Retrying in %lu ms (attempt %lu)",
+                   ctx->name, (int)result, (unsigned long)wait_ms, (unsigned long)(retry_count + 1));
         } else {
-            CY_LOGD(TAG, "MQTT connection waiting for %s. Retrying in %d ms. Retries left: %d",
+            /* Nothing to back off from; HANDLE_IO_UP ends the wait early. */
+            wait_ms = MQTT_CONN_BACKOFF_MAX_MS;
+
+            CY_LOGD(TAG, "MQTT %s connection waiting for %s. Retrying in %lu ms (attempt %lu)",
+                   ctx->name,
                    get_connectivity_type(default_io),
-                   MQTT_CONN_RETRY_INTERVAL_MS,
-                   (int)(MAX_MQTT_CONN_RETRIES - retry_count - 1));
+                   (unsigned long)wait_ms,
+                   (unsigned long)(retry_count + 1));
         }
     }
 
@@ -472,9 +863,39 @@ static cy_rslt_t mqtt_connect(void)
     return result;
 }
 
-static cy_rslt_t mqtt_create_subtasks(void)
+/******************************************************************************
+ * Function Name: mqtt_start
+ ******************************************************************************
+ * Summary:
+ *  Function that connects the command connection and starts its subscriber
+ *  and publisher tasks, then starts the task of the bulk connection, which
+ *  connects it in the background: the app runs on the command connection
+ *  meanwhile. The command publisher is created as soon as the subscriptions
+ *  are made, or after TASK_CREATION_DELAY_MS at most.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS when all connections and tasks are up, else
+ *              the error of the first step that failed.
+ *
+ ******************************************************************************/
+static cy_rslt_t mqtt_start(void)
 {
     cy_rslt_t result;
+#if (MQTT_CONNECTION_COUNT > 1)
+    mqtt_task_data_t stale;
+#endif
+
+    result = mqtt_connect(&s_conn[MQTT_CONN_COMMAND]);
+    if (result != CY_RSLT_SUCCESS) {
+        return result;
+    }
+
+    /* Drop a give left over from a previous start. */
+    while (CY_RSLT_SUCCESS == cy_rtos_get_semaphore(&s_subscribed, 0, false)) {
+    }
 
     /* Create the subscriber task and cleanup if the operation fails. */
     result = cy_rtos_create_thread( &g_subscriber_task_handle,
@@ -485,32 +906,72 @@ static cy_rslt_t mqtt_create_subtasks(void)
                                     SUBSCRIBER_TASK_PRIORITY,
                                     (cy_thread_arg_t) NULL);
 
-    if (result == CY_RSLT_SUCCESS) {
-        /* Wait for the subscribe operation to complete. */
-        cy_rtos_delay_milliseconds(TASK_CREATION_DELAY_MS);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGD(TAG, "Failed to create the Subscriber task!");
+        return result;
+    }
 
-        /* Create the publisher task and cleanup if the operation fails. */
-        result = cy_rtos_create_thread( &g_publisher_task_handle,
-                                        publisher_task,
-                                        PUBLISHER_TASK_NAME,
-                                        NULL,
-                                        PUBLISHER_TASK_STACK_SIZE,
-                                        PUBLISHER_TASK_PRIORITY,
-                                        (cy_thread_arg_t) NULL);
+    /* Wait for the subscribe operation to complete. */
+    if (CY_RSLT_SUCCESS != cy_rtos_get_semaphore(&s_subscribed, TASK_CREATION_DELAY_MS, false)) {
+        CY_LOGD(TAG, "Subscriptions not made in %u ms, starting the Publisher task",
+                (unsigned int)TASK_CREATION_DELAY_MS);
+    }
 
-        if (result != CY_RSLT_SUCCESS) {
-            CY_LOGD(TAG, "Failed to create the Publisher task!");
-        }
+    /* Create the publisher task and cleanup if the operation fails. */
+    result = cy_rtos_create_thread( &g_publisher_task_handle[MQTT_CONN_COMMAND],
+                                    publisher_task,
+                                    PUBLISHER_TASK_NAME,
+                                    NULL,
+                                    PUBLISHER_TASK_STACK_SIZE,
+                                    PUBLISHER_TASK_PRIORITY,
+                                    (cy_thread_arg_t) MQTT_CONN_COMMAND);
 
-    } else {
-        CY_LOGD(TAG, "Failed to create the Subscriber task!");
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGD(TAG, "Failed to create the Publisher task!");
+        return result;
+    }
+
+#if (MQTT_CONNECTION_COUNT > 1)
+    /* Drop the commands left over from the previous run. */
+    while (CY_RSLT_SUCCESS == cy_rtos_get_queue(&s_bulk_q, (void *)&stale, 0, false)) {
+    }
+
+    result = cy_rtos_create_thread( &s_bulk_task_handle,
+                                    mqtt_bulk_task,
+                                    MQTT_BULK_TASK_NAME,
+                                    NULL,
+                                    MQTT_BULK_TASK_STACK_SIZE,
+                                    MQTT_BULK_TASK_PRIORITY,
+                                    (cy_thread_arg_t) NULL);
+
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGD(TAG, "Failed to create the MQTT bulk task!");
     }
+#endif
 
     return result;
 }
 
 static void mqtt_delete_subtasks(void)
 {
+#if (MQTT_CONNECTION_COUNT > 1)
+    /* Stop the bulk task first, so that it does not create its publisher
+     * meanwhile. It ends its connection attempt at the HANDLE_EXIT_LOOP.
+     */
+    if (s_bulk_task_handle != NULL) {
+        CY_LOGD(TAG, "Stopping the MQTT bulk task...");
+        (void) mqtt_task_post(HANDLE_EXIT_LOOP, MQTT_CONN_BULK);
+
+        if (CY_RSLT_SUCCESS != cy_rtos_join_thread(&s_bulk_task_handle)) {
+            CY_LOGD(TAG, "Failed to join the MQTT bulk thread!");
+        }
+        s_bulk_task_handle = NULL;
+    }
+#endif
+
+    /* Let the publishes of the ring return before their publisher goes. */
+    (void) mqtt_publish_window_stop(MQTT_PUBLISH_WINDOW_STOP_TIMEOUT_MS);
+
     CY_LOGD(TAG, "Terminating Publisher and Subscriber tasks...");
 
     if (g_subscriber_task_handle != NULL) {
@@ -524,23 +985,125 @@ static void mqtt_delete_subtasks(void)
         g_subscriber_task_handle = NULL;
     }
 
-    if (g_publisher_task_handle != NULL) {
-        if (CY_RSLT_SUCCESS != cy_rtos_terminate_thread(&g_publisher_task_handle)) {
-            CY_LOGD(TAG, "Failed to delete the Publisher thread!");
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        if (g_publisher_task_handle[i] != NULL) {
+            publisher_queue_detach((mqtt_conn_id_t)i);
+            if (CY_RSLT_SUCCESS != cy_rtos_terminate_thread(&g_publisher_task_handle[i])) {
+                CY_LOGD(TAG, "Failed to delete the Publisher thread!");
+            }
+
+            if (CY_RSLT_SUCCESS != cy_rtos_join_thread(&g_publisher_task_handle[i])) {
+                CY_LOGD(TAG, "Failed to join the Publisher thread!");
+            }
+            g_publisher_task_handle[i] = NULL;
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: mqtt_reconnect
+ ******************************************************************************
+ * Summary:
+ *  Function that re-establishes one MQTT connection, over the current
+ *  default I/O, without restarting the app: the publisher of the connection
+ *  is paused meanwhile, and keeps its queued messages. The subscriptions
+ *  are made again. On a move to a new default I/O, the time without a
+ *  session is kept for mqtt_link_print_stats().
+ *
+ * Parameters:
+ *  mqtt_conn_ctx_t *ctx : the connection to re-establish
+ *  bool move : whether the connection moves to a new default I/O
+ *
+ * Return:
+ *  bool : false if the connection or the publisher could not be restored
+ *
+ ******************************************************************************/
+static bool mqtt_reconnect(mqtt_conn_ctx_t *ctx, bool move)
+{
+    publisher_data_t publisher_q_data;
+    cy_time_t down_at = 0;
+    cy_time_t up_at = 0;
+    bool ok = true;
+
+    /* Deinit the publisher before initiating reconnections. */
+    publisher_q_data.cmd = PUBLISHER_DEINIT;
+    publisher_q_data.conn = ctx->id;
+
+    CY_LOGD(TAG, "publisher_queue_put: PUBLISHER_DEINIT");
+    if (CY_RSLT_SUCCESS != publisher_queue_put(&publisher_q_data, false)) {
+        CY_LOGD(TAG, "publisher_queue_put failed!");
+    }
+
+    /* Wait for the publishes of the ring in flight on this connection;
+     * PUBLISHER_INIT opens the window again.
+     */
+    if (ctx->id == MQTT_CONN_ROUTE(MQTT_CONN_BULK)) {
+        (void) mqtt_publish_window_stop(MQTT_PUBLISH_WINDOW_STOP_TIMEOUT_MS);
+    }
+
+    /* Even when the connection with the MQTT Broker is lost,
+     * call the MQTT disconnect API for cleanup of threads and
+     * other resources before reconnection.
+     */
+    cy_rtos_get_time(&down_at);
+    cy_mqtt_disconnect(g_mqtt_connection[ctx->id]);
+    ctx->status_flag &= ~(MQTT_CONNECTION_SUCCESS | MQTT_CONNECTION_LOST);
+
+    CY_LOGD(TAG, "Initiating MQTT Reconnection of the %s connection...", ctx->name);
+    if (CY_RSLT_SUCCESS == mqtt_connect(ctx)) {
+        subscriber_data_t subscriber_q_data;
+
+        cy_rtos_get_time(&up_at);
+        CY_LOGD(TAG, "The %s connection was down for %lu ms", ctx->name,
+                (unsigned long)(up_at - down_at));
+        if (move) {
+            ctx->moves++;
+            ctx->move_gap_ms = (uint32_t)(up_at - down_at);
+            if (ctx->move_gap_ms > ctx->move_gap_max_ms) {
+                ctx->move_gap_max_ms = ctx->move_gap_ms;
+            }
+        }
+
+        /* The subscriptions are on the command connection. They are made
+         * again even with a persistent session: the MQTT library does not
+         * report the session-present flag of CONNACK, so whether the broker
+         * kept them is unknown.
+         */
+        if (ctx->id == MQTT_CONN_COMMAND) {
+            /* Initiate MQTT subscribe post the reconnection. */
+            subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
+
+            CY_LOGD(TAG, "cy_rtos_put_queue: SUBSCRIBE_TO_TOPIC");
+            if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_subscriber_task_q,
+                                                    (void *)&subscriber_q_data,
+                                                    CY_RTOS_NEVER_TIMEOUT,
+                                                    false)) {
+                CY_LOGD(TAG, "cy_rtos_put_queue(g_subscriber_task_q) failed!");
+                ok = false;
+            }
         }
 
-        if (CY_RSLT_SUCCESS != cy_rtos_join_thread(&g_publisher_task_handle)) {
-            CY_LOGD(TAG, "Failed to join the Publisher thread!");
+        /* Initialize Publisher post the reconnection. */
+        publisher_q_data.cmd = PUBLISHER_INIT;
+        publisher_q_data.conn = ctx->id;
+
+        CY_LOGD(TAG, "publisher_queue_put: PUBLISHER_INIT");
+        if (CY_RSLT_SUCCESS != publisher_queue_put(&publisher_q_data, false)) {
+            CY_LOGD(TAG, "publisher_queue_put failed!");
+            ok = false;
         }
-        g_publisher_task_handle = NULL;
+
+    } else {
+        ok = false;
     }
+    return ok;
 }
 
 static void handle_mqtt_operations(void)
 {
     while (true) {
         bool abort = false;
-        mqtt_task_cmd_t mqtt_status;
+        mqtt_task_data_t mqtt_status;
 
         /* Wait for results of MQTT operations from other tasks and callbacks. */
         if (CY_RSLT_SUCCESS == cy_rtos_get_queue(   &g_mqtt_task_q,
@@ -548,6 +1111,8 @@ static void handle_mqtt_operations(void)
                                                     CY_RTOS_NEVER_TIMEOUT,
                                                     false))
         {
+            mqtt_conn_ctx_t *ctx = &s_conn[MQTT_CONN_ROUTE(mqtt_status.conn)];
+
             /* In this code example, the disconnection from the MQTT Broker or
              * the Wi-Fi network is handled by the case 'HANDLE_DISCONNECTION'.
              *
@@ -555,8 +1120,10 @@ static void handle_mqtt_operations(void)
              * and `HANDLE_MQTT_SUBSCRIBE_FAILURE`) does not initiate
              * reconnection in this example, but they can be handled as per the
              * application requirement in the following switch cases.
+             * This queue is about the command connection; the bulk one is
+             * re-established by mqtt_bulk_task().
              */
-            switch(mqtt_status) {
+            switch(mqtt_status.cmd) {
                 case HANDLE_MQTT_PUBLISH_FAILURE: {
                     /* Handle Publish Failure here. */
                     break;
@@ -568,57 +1135,31 @@ static void handle_mqtt_operations(void)
                 }
 
                 case HANDLE_DISCONNECTION: {
-                    publisher_data_t publisher_q_data;
+                    /* Already re-established, e.g. by a link change */
+                    if (!(ctx->status_flag & MQTT_CONNECTION_LOST)) {
+                        break;
+                    }
 
-                    /* Deinit the publisher before initiating reconnections. */
-                    publisher_q_data.cmd = PUBLISHER_DEINIT;
+                    abort = !mqtt_reconnect(ctx, false);
+                    break;
+                }
 
-                    CY_LOGD(TAG, "cy_rtos_put_queue: PUBLISHER_DEINIT");
-                    if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_publisher_task_q,
-                                                             (void *)&publisher_q_data,
-                                                             CY_RTOS_NEVER_TIMEOUT,
-                                                             false)) {
-                        CY_LOGD(TAG, "cy_rtos_put_queue(g_publisher_task_q) failed!");
-                    }
+                case HANDLE_LINK_CHANGE: {
+                    /* The default I/O has changed: move the connection to
+                     * it. The old link stays up until then, so the session
+                     * is closed cleanly. The link manager has reached the
+                     * broker over the new one already, unless the old one
+                     * was down (see mqtt_link_prepare()).
+                     */
+                    CY_LOGD(TAG, "Moving the %s connection to the new link...", ctx->name);
+                    abort = !mqtt_reconnect(ctx, true);
+                    break;
+                }
 
-                    /* Although the connection with the MQTT Broker is lost,
-                     * call the MQTT disconnect API for cleanup of threads and
-                     * other resources before reconnection.
+                case HANDLE_IO_UP: {
+                    /* The connections are up, or re-established on their
+                     * HANDLE_DISCONNECTION.
                      */
-                    cy_mqtt_disconnect(g_mqtt_connection);
-
-
-                    CY_LOGD(TAG, "Initiating MQTT Reconnection...");
-                    if (CY_RSLT_SUCCESS == mqtt_connect()) {
-                        subscriber_data_t subscriber_q_data;
-
-                        /* Initiate MQTT subscribe post the reconnection. */
-                        subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
-
-                        CY_LOGD(TAG, "cy_rtos_put_queue: SUBSCRIBE_TO_TOPIC");
-                        if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_subscriber_task_q,
-                                                                (void *)&subscriber_q_data,
-                                                                CY_RTOS_NEVER_TIMEOUT,
-                                                                false)) {
-                            CY_LOGD(TAG, "cy_rtos_put_queue(g_subscriber_task_q) failed!");
-                            abort = true;
-                        }
-
-                        /* Initialize Publisher post the reconnection. */
-                        publisher_q_data.cmd = PUBLISHER_INIT;
-
-                        CY_LOGD(TAG, "cy_rtos_put_queue: PUBLISHER_INIT");
-                        if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_publisher_task_q,
-                                                                (void *)&publisher_q_data,
-                                                                CY_RTOS_NEVER_TIMEOUT,
-                                                                false)) {
-                            CY_LOGD(TAG, "cy_rtos_put_queue(g_publisher_task_q) failed!");
-                            abort = true;
-                        }
-
-                    } else {
-                        abort = true;
-                    }
                     break;
                 }
 
@@ -627,7 +1168,7 @@ static void handle_mqtt_operations(void)
                     break;
 
                 default:
-                    CY_LOGD(TAG, "Unknown mqtt_task_cmd_t: %d", mqtt_status);
+                    CY_LOGD(TAG, "Unknown mqtt_task_cmd_t: %d", mqtt_status.cmd);
                     break;
             }
         }
@@ -638,6 +1179,91 @@ static void handle_mqtt_operations(void)
     }
 }
 
+#if (MQTT_CONNECTION_COUNT > 1)
+/******************************************************************************
+ * Function Name: mqtt_bulk_task
+ ******************************************************************************
+ * Summary:
+ *  Task that connects the bulk connection in the background, starts its
+ *  publisher task, and re-establishes it on a disconnection or a link
+ *  change. It keeps trying while the app runs: a failure of the bulk
+ *  connection never stops the command one. It ends at the
+ *  HANDLE_EXIT_LOOP posted by mqtt_delete_subtasks().
+ *
+ * Parameters:
+ *  cy_thread_arg_t arg : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_bulk_task(cy_thread_arg_t arg)
+{
+    mqtt_conn_ctx_t *ctx = &s_conn[MQTT_CONN_BULK];
+    bool stop = false;
+
+    (void) arg;
+
+    if (CY_RSLT_SUCCESS != mqtt_connect(ctx)) {
+        /* Only the stop of the app ends the attempts. */
+        stop = true;
+
+    } else if (CY_RSLT_SUCCESS != cy_rtos_create_thread(&g_publisher_task_handle[MQTT_CONN_BULK],
+                                                        publisher_task,
+                                                        PUBLISHER_BULK_TASK_NAME,
+                                                        NULL,
+                                                        PUBLISHER_TASK_STACK_SIZE,
+                                                        PUBLISHER_BULK_TASK_PRIORITY,
+                                                        (cy_thread_arg_t) MQTT_CONN_BULK)) {
+        /* The bulk publisher has its own task, below the priority of the
+         * command one. Without it, the batches wait in the bulk ring.
+         */
+        CY_LOGD(TAG, "Failed to create the bulk Publisher task!");
+    }
+
+    while (!stop) {
+        mqtt_task_data_t mqtt_status;
+
+        if (CY_RSLT_SUCCESS != cy_rtos_get_queue(&s_bulk_q,
+                                                 (void *)&mqtt_status,
+                                                 CY_RTOS_NEVER_TIMEOUT,
+                                                 false)) {
+            continue;
+        }
+
+        switch (mqtt_status.cmd) {
+            case HANDLE_DISCONNECTION:
+            case HANDLE_LINK_CHANGE: {
+                /* Already re-established, e.g. by a link change */
+                if ((mqtt_status.cmd == HANDLE_DISCONNECTION) &&
+                    !(ctx->status_flag & MQTT_CONNECTION_LOST)) {
+                    break;
+                }
+
+                CY_LOGD(TAG, "Re-establishing the %s connection...", ctx->name);
+                (void) mqtt_reconnect(ctx, (mqtt_status.cmd == HANDLE_LINK_CHANGE));
+
+                /* The attempts of mqtt_connect() only end without a
+                 * connection when the app is stopped.
+                 */
+                stop = !(ctx->status_flag & MQTT_CONNECTION_SUCCESS);
+                break;
+            }
+
+            case HANDLE_EXIT_LOOP:
+                stop = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    CY_LOGD(TAG, "MQTT bulk task done");
+    (void) cy_rtos_exit_thread();
+}
+#endif /* MQTT_CONNECTION_COUNT > 1 */
+
 
 /*-- Public Functions -------------------------------------------------*/
 
@@ -673,25 +1299,45 @@ void mqtt_client_task(cy_thread_arg_t pvParameters)
     /* Create a message queue to communicate with other tasks and callbacks. */
     if (CY_RSLT_SUCCESS !=  cy_rtos_init_queue( &g_mqtt_task_q,
                                                 MQTT_TASK_QUEUE_LENGTH,
-                                                sizeof(mqtt_task_cmd_t))) {
+                                                sizeof(mqtt_task_data_t))) {
         CY_LOGD(TAG, "cy_rtos_init_queue(g_mqtt_task_q) failed!");
         DEBUG_ASSERT(0);
     }
 
+#if (MQTT_CONNECTION_COUNT > 1)
+    if (CY_RSLT_SUCCESS !=  cy_rtos_init_queue( &s_bulk_q,
+                                                MQTT_TASK_QUEUE_LENGTH,
+                                                sizeof(mqtt_task_data_t))) {
+        CY_LOGD(TAG, "cy_rtos_init_queue(s_bulk_q) failed!");
+        DEBUG_ASSERT(0);
+    }
+#endif
+
+    result = cy_rtos_init_semaphore(&s_subscribed, 1, 0);
+    VoidAssert(result == CY_RSLT_SUCCESS);
+
+    (void) link_events_subscribe(LINK_EVENT_IP_UP, mqtt_link_event, NULL);
+
     while (true) {
         bool repeat;
+        mqtt_task_data_t stale;
 
         /* Notification values received from other tasks */
         uint32_t ulNotifiedValue = 0;
 
+        /* Drop the commands left over from the previous run, e.g. a
+         * HANDLE_EXIT_LOOP posted while it was failing to start.
+         */
+        while (CY_RSLT_SUCCESS == cy_rtos_get_queue(&g_mqtt_task_q, (void *)&stale, 0, false)) {
+        }
+
         s_mqtt_status = COMMON_STATUS_STARTING;
 
         /* Set-up the MQTT client and connect to the MQTT broker. Jump to the
          * cleanup block if any of the operations fail.
          */
         if ((CY_RSLT_SUCCESS == mqtt_init()) &&
-            (CY_RSLT_SUCCESS == mqtt_connect()) &&
-            (CY_RSLT_SUCCESS == mqtt_create_subtasks())) {
+            (CY_RSLT_SUCCESS == mqtt_start())) {
 
             s_mqtt_started = true;
             s_mqtt_status = COMMON_STATUS_STARTED;
@@ -704,8 +1350,8 @@ void mqtt_client_task(cy_thread_arg_t pvParameters)
             s_mqtt_status = COMMON_STATUS_FAILED_TO_START;
         }
 
-        /* Cleanup section: Delete subscriber and publisher tasks and perform
-         * cleanup for various operations based on the s_status_flag.
+        /* Cleanup section: Delete subscriber and publisher tasks and
+         * disconnect. The MQTT instance is kept for the next start.
          */
 
         mqtt_delete_subtasks();
@@ -748,6 +1394,8 @@ void mqtt_client_task(cy_thread_arg_t pvParameters)
         }
     }
 
+    mqtt_release();
+
     CY_LOGD(TAG, "Terminating the MQTT task...\n");
     if (CY_RSLT_SUCCESS != cy_rtos_terminate_thread(&g_mqtt_task_handle)) {
         CY_LOGD(TAG, "Failed to terminate the MQTT thread!");
@@ -777,18 +1425,10 @@ bool notify_mqtt(uint32_t new_notification_value,
                (new_notification_value == NOTIF_RESTART_APP) ||
                (new_notification_value == NOTIF_SHUTDOWN_APP)) {
 
-        if (s_mqtt_started) {
-            // MQTT is executing handle_mqtt_operations(),
-            // send a message to its queue to make it exit
-            mqtt_task_cmd_t mqtt_task_cmd = HANDLE_EXIT_LOOP;
-
-            if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_mqtt_task_q,
-                                                     (void *)&mqtt_task_cmd,
-                                                     CY_RTOS_NEVER_TIMEOUT,
-                                                     false
-                                                    )) {
-                CY_LOGD(TAG, "cy_rtos_put_queue(g_mqtt_task_q) failed!");
-            }
+        if (s_mqtt_started || (s_mqtt_status == COMMON_STATUS_STARTING)) {
+            // MQTT is executing handle_mqtt_operations() or waiting to
+            // connect, send a message to its queue to make it exit
+            (void) mqtt_task_post(HANDLE_EXIT_LOOP, MQTT_CONN_COMMAND);
         }
     }
 
@@ -800,6 +1440,152 @@ bool notify_mqtt(uint32_t new_notification_value,
 #endif
 }
 
+/******************************************************************************
+ * Function Name: mqtt_task_post
+ ******************************************************************************
+ * Summary:
+ *  Function that sends a command about one MQTT connection to the task
+ *  that manages it: the MQTT client task, or the bulk task.
+ *
+ * Parameters:
+ *  mqtt_task_cmd_t cmd : the command
+ *  mqtt_conn_id_t conn : the connection it is about
+ *
+ * Return:
+ *  cy_rslt_t : result of cy_rtos_put_queue()
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_task_post(mqtt_task_cmd_t cmd,
+                         mqtt_conn_id_t conn)
+{
+    cy_rslt_t result;
+    mqtt_task_data_t mqtt_task_data;
+
+    mqtt_task_data.cmd = cmd;
+    mqtt_task_data.conn = conn;
+
+    result = cy_rtos_put_queue(s_conn[MQTT_CONN_ROUTE(conn)].queue,
+                               (void *)&mqtt_task_data,
+                               CY_RTOS_NEVER_TIMEOUT,
+                               false);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGD(TAG, "cy_rtos_put_queue(%s) failed!", s_conn[MQTT_CONN_ROUTE(conn)].name);
+    }
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_link_changed
+ ******************************************************************************
+ * Summary:
+ *  Function that tells the MQTT client task that the default I/O has
+ *  changed. The running MQTT connections move to the new link without a
+ *  restart of the app; the subtasks and their queued messages are kept.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : false if the MQTT app is not running, so nothing has to move
+ *
+ ******************************************************************************/
+bool mqtt_link_changed(void)
+{
+#if (FEATURE_MQTT == ENABLE_FEATURE)
+    bool posted = true;
+
+    if (!s_mqtt_started) {
+        return false;
+    }
+
+    /* Each connection moves on its own task. */
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        posted &= (mqtt_task_post(HANDLE_LINK_CHANGE, s_conn[i].id) == CY_RSLT_SUCCESS);
+    }
+    return posted;
+#else
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: mqtt_link_prepare
+ ******************************************************************************
+ * Summary:
+ *  Function that readies the move of the MQTT connections to 'io', while
+ *  they still run over the default I/O: the address of each broker is
+ *  resolved over 'io', by the DNS cache, so that the reconnection does not
+ *  wait for DNS, and a TCP connection to the broker is opened over the
+ *  netif of 'io' and closed again. The socket cannot be handed to the MQTT
+ *  library, which opens its own, so the TLS handshake and the MQTT session
+ *  are still made after the old session is closed.
+ *
+ * Parameters:
+ *  connectivity_t io : the link the connections are about to move to
+ *
+ * Return:
+ *  bool : false if a broker could not be reached over 'io'
+ *
+ ******************************************************************************/
+bool mqtt_link_prepare(connectivity_t io)
+{
+#if (FEATURE_MQTT == ENABLE_FEATURE) && (FEATURE_LINK_MANAGER == ENABLE_FEATURE)
+    if (!s_mqtt_started) {
+        return true;
+    }
+
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        const char *hostname = broker_info[i].hostname;
+        ip_addr_t addr;
+        uint32_t rtt_ms = 0;
+        bool resolved = ipaddr_aton(hostname, &addr);
+
+#if (FEATURE_DNS_CACHE == ENABLE_FEATURE)
+        /* A hostname new to the cache is resolved by the DNS cache task */
+        for (uint32_t waited = 0; !resolved && (waited < LINK_SWITCH_PREPARE_MS);
+             waited += MQTT_LINK_PREPARE_POLL_MS) {
+            resolved = dns_cache_lookup(io, hostname, &addr);
+            if (!resolved) {
+                (void) cy_rtos_delay_milliseconds(MQTT_LINK_PREPARE_POLL_MS);
+            }
+        }
+#else
+        if (!resolved) {
+            resolved = (netconn_gethostbyname(hostname, &addr) == ERR_OK);
+        }
+#endif
+
+        if (!resolved || !link_quality_connect(io, &addr, broker_info[i].port, &rtt_ms)) {
+            CY_LOGE(TAG, "The %s broker cannot be reached over %s", s_conn[i].name,
+                    get_connectivity_type(io));
+            return false;
+        }
+        CY_LOGD(TAG, "The %s broker answers over %s in %lu ms", s_conn[i].name,
+                get_connectivity_type(io), (unsigned long)rtt_ms);
+    }
+    return true;
+#else
+    (void) io;
+    return true;
+#endif
+}
+
+void mqtt_subscribed(void)
+{
+    (void) cy_rtos_set_semaphore(&s_subscribed, false);
+}
+
+void mqtt_link_print_stats(void)
+{
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        PRINT_MSG(("MQTT %s: moves=%lu gap=%lu ms max=%lu ms\n",
+                   s_conn[i].name,
+                   (unsigned long)s_conn[i].moves,
+                   (unsigned long)s_conn[i].move_gap_ms,
+                   (unsigned long)s_conn[i].move_gap_max_ms));
+    }
+}
+
 const char* get_mqtt_status(void)
 {
     return get_common_status_str((int)s_mqtt_status);
@@ -47,6 +47,8 @@
 
 #include "cyabs_rtos.h"
 #include "cy_mqtt_api.h"
+#include "cy_pcm.h"
+#include "mqtt_client_config.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -61,22 +63,51 @@ extern "C"
 #define MQTT_CLIENT_TASK_PRIORITY       CY_RTOS_PRIORITY_BELOWNORMAL
 #define MQTT_CLIENT_TASK_STACK_SIZE     (1024 * 4)
 
+/* Task parameters for the task that connects and reconnects the bulk
+ * connection, apart from the command one.
+ */
+#define MQTT_BULK_TASK_NAME             "MQTT bulk task"
+#define MQTT_BULK_TASK_PRIORITY         CY_RTOS_PRIORITY_LOW
+#define MQTT_BULK_TASK_STACK_SIZE       (1024 * 4)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
+/* MQTT connections managed by the MQTT Client Task. */
+typedef enum
+{
+    MQTT_CONN_COMMAND = 0,      /* subscriptions and the publisher task queue */
+    MQTT_CONN_BULK = 1,         /* batches of publisher_publish_batch() */
+} mqtt_conn_id_t;
+
+/* Connection that carries the traffic of 'conn': with a single connection,
+ * everything goes over MQTT_CONN_COMMAND.
+ */
+#define MQTT_CONN_ROUTE(conn)  \
+    (((uint32_t)(conn) < MQTT_CONNECTION_COUNT) ? (conn) : MQTT_CONN_COMMAND)
+
 /* Commands for the MQTT Client Task. */
 typedef enum
 {
     HANDLE_MQTT_SUBSCRIBE_FAILURE,
     HANDLE_MQTT_PUBLISH_FAILURE,
     HANDLE_DISCONNECTION,
+    HANDLE_LINK_CHANGE,         /* the default I/O has changed */
+    HANDLE_IO_UP,               /* the default I/O has its IP address */
     HANDLE_EXIT_LOOP,
 } mqtt_task_cmd_t;
 
+/* Struct to be passed via the MQTT Client Task queue. */
+typedef struct
+{
+    mqtt_task_cmd_t cmd;
+    mqtt_conn_id_t conn;        /* connection the command is about */
+} mqtt_task_data_t;
+
 /*******************************************************************************
  * Extern variables
  ******************************************************************************/
-extern cy_mqtt_t g_mqtt_connection;
+extern cy_mqtt_t g_mqtt_connection[MQTT_CONNECTION_COUNT];
 extern cy_thread_t g_mqtt_task_handle;
 extern cy_queue_t g_mqtt_task_q;
 
@@ -89,6 +120,24 @@ void mqtt_client_task(cy_thread_arg_t pvParameters);
 bool notify_mqtt(uint32_t new_notification_value,
                  bool in_isr);
 
+cy_rslt_t mqtt_task_post(mqtt_task_cmd_t cmd,
+                         mqtt_conn_id_t conn);
+
+/* Reach the brokers over 'io' before the default I/O moves to it; see
+ * link_manager_task.c.
+ */
+bool mqtt_link_prepare(connectivity_t io);
+
+bool mqtt_link_changed(void);
+
+/* Moves of each connection to a new default I/O, and the time it was down */
+void mqtt_link_print_stats(void);
+
+/* Called by the subscriber task once its first subscriptions are made,
+ * successful or not: the publisher task is started then.
+ */
+void mqtt_subscribed(void);
+
 const char* get_mqtt_status(void);
 
 #ifdef __cplusplus
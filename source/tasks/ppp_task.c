@@ -52,6 +52,7 @@
 
 /* PPP connection manager header files. */
 #include "cy_pcm.h"
+#include "fake_io.h"
 #include "netif/ppp/pppapi.h"
 
 /* Wi-Fi connection manager header files. */
@@ -71,6 +72,8 @@
 
 #include "common_task.h"
 #include "wifi_task.h"
+#include "link_events.h"
+#include "bringup_timeline.h"
 
 #include "cy_modem.h"
 #include "strings.h"
@@ -86,7 +89,6 @@
 /*-- Local Definitions -------------------------------------------------*/
 
 #define WIFI_INTERFACE_TYPE                      CY_WCM_INTERFACE_TYPE_STA
-#define PROMPT_USER_TO_START_IO                  1
 
 
 /*-- Public Data -------------------------------------------------*/
@@ -112,6 +114,12 @@ static common_status_t s_ppp_status = COMMON_STATUS_STOPPED;
 /*-- Local Functions -------------------------------------------------*/
 
 #if (FEATURE_PPP == ENABLE_FEATURE)
+static void ppp_set_status(common_status_t status)
+{
+    s_ppp_status = status;
+    link_events_publish(CELLULAR_CONNECTIVITY, LINK_EVENT_STATUS, status);
+}
+
 static void user_ip_lost(void)
 {
     cy_time_t now = 0;
@@ -119,14 +127,41 @@ static void user_ip_lost(void)
     cy_rtos_get_time(&now);
     CY_LOGI(TAG, "{%ld} User IP lost!", now);
 
+    link_events_publish(CELLULAR_CONNECTIVITY, LINK_EVENT_IP_DOWN, s_ppp_status);
+
     bool result = notify_ppp(NOTIF_RESTART_IO, false);
     DEBUG_PRINT(("notify_ppp returned: %d\n", result));
 }
 
+#if PPP_PREWARM_MODEM
+/* Connects the modem in command mode, which powers it up and checks the
+ * SIM; returns false if the modem is in use or does not answer.
+ */
+static bool prewarm_modem(void)
+{
+    cy_pcm_connect_params_t cmd_conn_param;
+    cy_rslt_t result;
+
+    memset(&cmd_conn_param, 0, sizeof(cmd_conn_param));
+    cmd_conn_param.connect_ppp = false;
+
+    result = cy_pcm_connect_modem(&cmd_conn_param, NULL, PCM_CONNECT_MODEM_TIMEOUT_MSEC);
+    if (result != CY_RSLT_SUCCESS) {
+        CY_LOGD(TAG, "Modem not pre-warmed, error code %d", (int)result);
+        return false;
+    }
+
+    bringup_timeline_mark(BRINGUP_STAGE_MODEM_READY);
+    return true;
+}
+#endif
+
 /* PPP Username and Password defined in ppp_config.h */
 static cy_rslt_t connect_to_ppp(void)
 {
     cy_rslt_t result;
+    bool prewarmed = false;
+    uint32_t prewarm_ms = 0;
 
     /* Variables used by PPP connection manager.*/
     cy_pcm_connect_params_t ppp_conn_param;
@@ -141,32 +176,68 @@ static cy_rslt_t connect_to_ppp(void)
     ppp_conn_param.user_ip_lost_fn = user_ip_lost;
     ppp_conn_param.connect_ppp = true;
 
+#if PPP_PREWARM_MODEM
+    {
+        cy_time_t start = 0;
+        cy_time_t end = 0;
+
+        /* The time it takes counts against the start prompt. */
+        cy_rtos_get_time(&start);
+        prewarmed = prewarm_modem();
+        cy_rtos_get_time(&end);
+        prewarm_ms = (uint32_t)(end - start);
+    }
+#endif
+
     /* Join the network. */
     for (uint32_t conn_retries = 0; conn_retries < MAX_PPP_CONN_RETRIES; conn_retries++ ) {
+        uint32_t wait_ms = PPP_CONN_RETRY_INTERVAL_MSEC;
+        uint32_t ulNotifiedValue = 0;
 
-#if PROMPT_USER_TO_START_IO
-        // Ask the user whether to connect to PPP
-        // (This is useful if the eSIM profile is a test or terminated profile,
-        //  which will always fail to connect)
-        PRINT_MSG(("\n# Waiting %d sec for user intervention\n", PPP_CONN_RETRY_INTERVAL_MSEC/1000));
-        PRINT_MSG(("  If you do not wish to start PPP, press a key to enter the Console Menu,\n"));
-        PRINT_MSG(("  select Manage I/O -> Cellular PPP -> Stop\n"));
+        if (conn_retries == 0) {
+            wait_ms = PPP_START_PROMPT_MSEC;
+            wait_ms = (wait_ms > prewarm_ms) ? (wait_ms - prewarm_ms) : 0;
+
+            if (wait_ms > 0) {
+                // Ask the user whether to connect to PPP
+                // (This is useful if the eSIM profile is a test or terminated profile,
+                //  which will always fail to connect)
+                PRINT_MSG(("\n# Waiting %d sec for user intervention\n", (int)(wait_ms/1000)));
+                PRINT_MSG(("  If you do not wish to start PPP, press a key to enter the Console Menu,\n"));
+                PRINT_MSG(("  select Manage I/O -> Cellular PPP -> Stop\n"));
+            }
+        }
 
-        uint32_t ulNotifiedValue = 0;
+        /* Without a prompt, the first attempt starts at once; a Stop from
+         * the console still ends the attempts before the next one.
+         */
         result = cy_notification_wait(&s_notification,
                                       0x00,              /* Don't clear any notification bits on entry. */
                                       UINT32_MAX,        /* Reset the notification value to 0 on exit. */
                                       &ulNotifiedValue,  /* Notified value pass out in */
-                                      PPP_CONN_RETRY_INTERVAL_MSEC);
+                                      wait_ms);
         if (ulNotifiedValue != 0) {
             print_notified_value(ulNotifiedValue);
 
             if (ulNotifiedValue == NOTIF_STOP_IO) {
                 CY_LOGD(TAG, "User does not want to start PPP\n");
+                if (prewarmed) {
+                    (void) cy_pcm_disconnect_modem(CY_RTOS_NEVER_TIMEOUT, true);
+                }
                 return CY_RSLT_PCM_FAILED;
             }
         }
-#endif
+
+        if (prewarmed) {
+            /* Close the command session; the modem stays powered, so that
+             * the PPP connection starts with the registration.
+             */
+            prewarmed = false;
+            result = cy_pcm_disconnect_modem(CY_RTOS_NEVER_TIMEOUT, false);
+            if (result != CY_RSLT_SUCCESS) {
+                CY_LOGD(TAG, "cy_pcm_disconnect_modem failed!");
+            }
+        }
 
         result = cy_pcm_connect_modem(&ppp_conn_param,
                                       &ip_address,
@@ -225,7 +296,7 @@ static cy_rslt_t connect_to_ppp(void)
 
             } else {
                 CY_LOGE(TAG, "IP address is not valid!");
-                s_ppp_status = COMMON_STATUS_STOPPING;
+                ppp_set_status(COMMON_STATUS_STOPPING);
 
                 result = cy_pcm_disconnect_modem(CY_RTOS_NEVER_TIMEOUT, true);
                 if (result != CY_RSLT_SUCCESS) {
@@ -285,15 +356,19 @@ void ppp_task(cy_thread_arg_t arg)
         /* Notification values received from other tasks */
         uint32_t ulNotifiedValue = 0;
 
-        s_ppp_status = COMMON_STATUS_STARTING;
+        ppp_set_status(COMMON_STATUS_STARTING);
 
         if (connect_to_ppp() != CY_RSLT_SUCCESS ) {
             s_ppp_connected = false;
-            s_ppp_status = COMMON_STATUS_FAILED_TO_START;
+            ppp_set_status(COMMON_STATUS_FAILED_TO_START);
 
         } else {
             s_ppp_connected = true;
-            s_ppp_status = COMMON_STATUS_STARTED;
+            ppp_set_status(COMMON_STATUS_STARTED);
+
+            /* e.g. lets a waiting MQTT reconnection proceed at once */
+            link_events_publish(CELLULAR_CONNECTIVITY, LINK_EVENT_IP_UP, s_ppp_status);
+            link_events_publish(CELLULAR_CONNECTIVITY, LINK_EVENT_DNS_CHANGED, s_ppp_status);
         }
 
         do {
@@ -323,7 +398,7 @@ void ppp_task(cy_thread_arg_t arg)
                        (NOTIF_SHUTDOWN_IO == ulNotifiedValue)) {
 
                 if (s_ppp_connected) {
-                    s_ppp_status = COMMON_STATUS_STOPPING;
+                    ppp_set_status(COMMON_STATUS_STOPPING);
 
                     result = cy_pcm_disconnect_modem(CY_RTOS_NEVER_TIMEOUT, true);
                     if (result != CY_RSLT_SUCCESS) {
@@ -337,7 +412,8 @@ void ppp_task(cy_thread_arg_t arg)
                     memset(&s_ppp_ip_addr, 0, sizeof(s_ppp_ip_addr));
                     memset(s_ppp_dns_addr, 0, sizeof(s_ppp_dns_addr));
 
-                    s_ppp_status = COMMON_STATUS_STOPPED;
+                    link_events_publish(CELLULAR_CONNECTIVITY, LINK_EVENT_IP_DOWN, s_ppp_status);
+                    ppp_set_status(COMMON_STATUS_STOPPED);
 
                 } else {
                     CY_LOGD(TAG, "PPP already stopped");
@@ -379,6 +455,12 @@ bool is_ppp_connected(void)
     return s_ppp_connected && cy_pcm_is_ppp_connected();
 }
 
+bool is_ppp_down(void)
+{
+    return (s_ppp_status == COMMON_STATUS_FAILED_TO_START) ||
+           ((s_ppp_status == COMMON_STATUS_STARTED) && !is_ppp_connected());
+}
+
 const ip_addr_t* get_ppp_dns_address(void)
 {
     return &s_ppp_dns_addr[0];
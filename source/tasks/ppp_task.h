@@ -74,6 +74,9 @@ void ppp_task(cy_thread_arg_t arg);
 
 bool is_ppp_connected(void);
 
+/* Failed to start, or lost the connection; false once stopped on purpose */
+bool is_ppp_down(void);
+
 const ip_addr_t* get_ppp_dns_address(void);
 
 const ip_addr_t* get_ppp_dns_2_address(void);
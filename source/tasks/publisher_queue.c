@@ -0,0 +1,722 @@
+/******************************************************************************
+* File Name:   publisher_queue.c
+*
+* Description: Bounded command queue of the publisher task with selectable
+*              overflow policies (drop oldest/newest, coalesce by topic,
+*              block with timeout) and drop/peak-depth counters.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cyhal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "publisher_queue.h"
+#include "mqtt_client_config.h"
+#include "mqtt_uplink_budget.h"
+#include "spsc_ring.h"
+
+#include "cy_debug.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* PUBLISH_MQTT_MSG commands may use PUBLISHER_QUEUE_DEPTH slots; the
+ * reserved slots on top keep room for the control commands.
+ */
+#define PUBLISHER_QUEUE_SLOTS   (PUBLISHER_QUEUE_DEPTH + PUBLISHER_QUEUE_RESERVED_SLOTS)
+
+typedef struct
+{
+    publisher_data_t items[PUBLISHER_QUEUE_SLOTS];
+    size_t head;
+    size_t count;
+    size_t msg_count;
+    size_t waiters;
+
+    /* Publisher task draining the queue, woken by a task notification;
+     * the lanes are checked again on each wakeup. NULL while none is
+     * attached.
+     */
+    TaskHandle_t consumer;
+
+    /* Given by the publisher task to wake producers blocked on a full queue */
+    cy_semaphore_t space_semaphore;
+
+    /* Items put from ISRs, moved into the queue by the publisher task */
+    spsc_ring_t isr_ring;
+    publisher_data_t isr_items[PUBLISHER_QUEUE_ISR_RING_SIZE];
+    uint32_t isr_dropped;               /* isr_ring.dropped already counted */
+
+    /* Pacing of the normal lane */
+    uint32_t normal_tokens;
+    cy_time_t normal_refill_time;
+
+    bool initialized;
+    publisher_queue_stats_t stats;
+} publisher_queue_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const char *TAG = "publisher_queue";
+
+/* One queue per MQTT connection, each drained by its publisher task */
+static publisher_queue_t s_queues[MQTT_CONNECTION_COUNT];
+
+static volatile publisher_queue_policy_t s_policy = PUBLISHER_QUEUE_POLICY;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static publisher_data_t* queue_at(publisher_queue_t *q, size_t i)
+{
+    return &q->items[(q->head + i) % PUBLISHER_QUEUE_SLOTS];
+}
+
+static bool queue_is_msg(const publisher_data_t *item)
+{
+    return (item->cmd == PUBLISH_MQTT_MSG);
+}
+
+/* Control commands and PUBLISHER_PRIORITY_HIGH messages */
+static bool queue_is_high(const publisher_data_t *item)
+{
+    return !queue_is_msg(item) || (item->priority == PUBLISHER_PRIORITY_HIGH);
+}
+
+static bool queue_same_topic(const char *a, const char *b)
+{
+    if ((a == NULL) || (b == NULL)) {
+        return (a == b);
+    }
+    return (strcmp(a, b) == 0);
+}
+
+/* Wakes the publisher task from a task; it does not wake itself */
+static void queue_wake_consumer(publisher_queue_t *q)
+{
+    TaskHandle_t consumer = q->consumer;
+
+    if ((consumer != NULL) && (consumer != xTaskGetCurrentTaskHandle())) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+/* Must be called inside the critical section */
+static void queue_remove_at(publisher_queue_t *q, size_t i)
+{
+    if (queue_is_msg(queue_at(q, i))) {
+        q->msg_count--;
+    }
+
+    if (i == 0) {
+        q->head = (q->head + 1) % PUBLISHER_QUEUE_SLOTS;
+    } else {
+        for (; (i + 1) < q->count; i++) {
+            *queue_at(q, i) = *queue_at(q, i + 1);
+        }
+    }
+    q->count--;
+    q->stats.depth = (uint16_t)q->count;
+}
+
+/* Must be called inside the critical section */
+static void queue_append(publisher_queue_t *q, const publisher_data_t *item)
+{
+    *queue_at(q, q->count) = *item;
+    q->count++;
+
+    if (queue_is_msg(item)) {
+        q->msg_count++;
+
+        if (queue_is_high(item)) {
+            q->stats.high_enqueued++;
+        }
+    }
+
+    q->stats.enqueued++;
+    q->stats.depth = (uint16_t)q->count;
+    if (q->stats.depth > q->stats.peak_depth) {
+        q->stats.peak_depth = q->stats.depth;
+    }
+}
+
+/* Must be called inside the critical section. Returns the index of the
+ * oldest message of the lane 'high' that may be evicted, or -1.
+ */
+static int queue_find_victim(publisher_queue_t *q,
+                             const char *topic,
+                             bool by_topic,
+                             bool high)
+{
+    for (size_t i = 0; i < q->count; i++) {
+        const publisher_data_t *item = queue_at(q, i);
+
+        if (queue_is_msg(item) &&
+            (queue_is_high(item) == high) &&
+            (!by_topic || queue_same_topic(item->topic, topic))) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* Must be called inside the critical section. Returns the index of the
+ * oldest message to evict for 'item': a normal one first, a high one only
+ * for a high 'item' and if 'any_lane'.
+ */
+static int queue_find_oldest_victim(publisher_queue_t *q,
+                                    const publisher_data_t *item,
+                                    bool any_lane)
+{
+    int index = queue_find_victim(q, NULL, false, false);
+
+    if ((index < 0) && any_lane && queue_is_high(item)) {
+        index = queue_find_victim(q, NULL, false, true);
+    }
+    return index;
+}
+
+/* Must be called inside the critical section. Takes a token of the normal
+ * lane, or sets 'wait_ms' to the time until the next one.
+ */
+static bool queue_take_normal_token(publisher_queue_t *q,
+                                    cy_time_t now,
+                                    cy_time_t *wait_ms)
+{
+#if (PUBLISHER_NORMAL_LANE_INTERVAL_MS > 0)
+    uint32_t elapsed = (uint32_t)(now - q->normal_refill_time);
+
+    if (elapsed >= PUBLISHER_NORMAL_LANE_INTERVAL_MS) {
+        uint32_t refills = elapsed / PUBLISHER_NORMAL_LANE_INTERVAL_MS;
+
+        q->normal_refill_time += refills * PUBLISHER_NORMAL_LANE_INTERVAL_MS;
+        if ((q->normal_tokens + refills) >= PUBLISHER_NORMAL_LANE_BURST) {
+            q->normal_tokens = PUBLISHER_NORMAL_LANE_BURST;
+            q->normal_refill_time = now;
+        } else {
+            q->normal_tokens += refills;
+        }
+    }
+
+    if (q->normal_tokens == 0) {
+        *wait_ms = PUBLISHER_NORMAL_LANE_INTERVAL_MS -
+                   (uint32_t)(now - q->normal_refill_time);
+        return false;
+    }
+    q->normal_tokens--;
+#else
+    (void) q;
+    (void) now;
+    (void) wait_ms;
+#endif
+    return true;
+}
+
+/* Must be called inside the critical section. Returns the index of the
+ * next item to take, or -1 and how long to wait for it in 'wait_ms'.
+ */
+static int queue_next(publisher_queue_t *q, cy_time_t now, cy_time_t *wait_ms)
+{
+    *wait_ms = CY_RTOS_NEVER_TIMEOUT;
+
+    for (size_t i = 0; i < q->count; i++) {
+        if (queue_is_high(queue_at(q, i))) {
+            return (int)i;
+        }
+    }
+
+    /* Only normal messages are queued; the oldest is at the head. It also
+     * waits for the uplink budget here, where high messages can pass it.
+     */
+    if (q->count > 0) {
+        uint32_t budget_wait_ms = mqtt_uplink_budget_wait_ms();
+
+        if (budget_wait_ms > 0) {
+            *wait_ms = budget_wait_ms;
+        } else if (queue_take_normal_token(q, now, wait_ms)) {
+            return 0;
+        }
+        q->stats.paced++;
+    }
+    return -1;
+}
+
+/* Called outside the critical section for a message that is not published */
+static void queue_discard(const publisher_data_t *item)
+{
+    mqtt_payload_release(item->payload);
+
+    if (item->complete_cb != NULL) {
+        item->complete_cb(CY_RSLT_MODULE_MQTT_ERROR,
+                          item->enqueue_time,
+                          item->complete_arg);
+    }
+}
+
+/******************************************************************************
+ * Function Name: queue_try_put
+ ******************************************************************************
+ * Summary:
+ *  Applies the overflow policy (minus blocking) to one put attempt.
+ *  Called by tasks only; items put from ISRs come through the ISR ring.
+ *
+ * Parameters:
+ *  publisher_queue_t *q : queue of the connection
+ *  const publisher_data_t *item : command to queue
+ *  publisher_data_t *victim : set to the message evicted to make room
+ *  bool *evicted : set to true if 'victim' is valid
+ *  bool *wait : set to true if the caller was registered as a waiter
+ *
+ * Return:
+ *  bool : true if 'item' was queued (possibly by replacing 'victim')
+ *
+ ******************************************************************************/
+static bool queue_try_put(publisher_queue_t *q,
+                          const publisher_data_t *item,
+                          publisher_data_t *victim,
+                          bool *evicted,
+                          bool *wait)
+{
+    bool queued = false;
+    bool signal = false;
+    bool evict_policy;
+    publisher_queue_policy_t policy = s_policy;
+    int index;
+    uint32_t state;
+
+    *evicted = false;
+    *wait = false;
+
+    /* Messages coalesce once the data budget runs low */
+    if (mqtt_uplink_budget_level() >= MQTT_BUDGET_LEVEL_COALESCE) {
+        policy = PUBLISHER_QUEUE_COALESCE_BY_TOPIC;
+    }
+
+    state = cyhal_system_critical_section_enter();
+
+    evict_policy = ((policy == PUBLISHER_QUEUE_DROP_OLDEST) ||
+                    (policy == PUBLISHER_QUEUE_COALESCE_BY_TOPIC));
+
+    if (!queue_is_msg(item)) {
+        /* Control commands may use every slot */
+        if (q->count < PUBLISHER_QUEUE_SLOTS) {
+            queue_append(q, item);
+            queued = true;
+            signal = true;
+        }
+
+    } else if ((policy == PUBLISHER_QUEUE_COALESCE_BY_TOPIC) &&
+               ((index = queue_find_victim(q, item->topic, true,
+                                           queue_is_high(item))) >= 0)) {
+        /* Latest value wins, in the place of the queued one of its lane */
+        *victim = *queue_at(q, (size_t)index);
+        *queue_at(q, (size_t)index) = *item;
+        *evicted = true;
+        queued = true;
+        q->stats.coalesced++;
+
+    } else if ((q->msg_count < PUBLISHER_QUEUE_DEPTH) &&
+               (q->count < PUBLISHER_QUEUE_SLOTS)) {
+        queue_append(q, item);
+        queued = true;
+        signal = true;
+
+    } else if ((evict_policy || queue_is_high(item)) &&
+               ((index = queue_find_oldest_victim(q, item, evict_policy)) >= 0)) {
+        /* A high message evicts a normal one whatever the policy */
+        *victim = *queue_at(q, (size_t)index);
+        queue_remove_at(q, (size_t)index);
+        queue_append(q, item);
+        *evicted = true;
+        queued = true;
+        signal = true;
+        q->stats.dropped_oldest++;
+
+    } else if (policy == PUBLISHER_QUEUE_BLOCK) {
+        /* The caller waits for space */
+        q->waiters++;
+        *wait = true;
+
+    } else {
+        q->stats.dropped_newest++;
+    }
+
+    cyhal_system_critical_section_exit(state);
+
+    if (signal) {
+        queue_wake_consumer(q);
+    }
+    return queued;
+}
+
+/* Moves the items put from ISRs into the queue, in the publisher task.
+ * The overflow policy applies to them here, except that they are dropped
+ * rather than blocking the task that would make room.
+ */
+static void queue_drain_isr_ring(publisher_queue_t *q)
+{
+    publisher_data_t item;
+    publisher_data_t victim;
+    bool evicted;
+    bool wait;
+    uint32_t dropped;
+    uint32_t state;
+
+    while (spsc_ring_pop(&q->isr_ring, &item)) {
+        bool queued = queue_try_put(q, &item, &victim, &evicted, &wait);
+
+        if (wait) {
+            state = cyhal_system_critical_section_enter();
+            q->waiters--;
+            q->stats.dropped_newest++;
+            cyhal_system_critical_section_exit(state);
+        }
+
+        if (evicted) {
+            queue_discard(&victim);
+        }
+        if (!queued) {
+            queue_discard(&item);
+        }
+    }
+
+    /* Puts to a full ring */
+    dropped = q->isr_ring.dropped;
+    if (dropped != q->isr_dropped) {
+        state = cyhal_system_critical_section_enter();
+        q->stats.dropped_newest += dropped - q->isr_dropped;
+        cyhal_system_critical_section_exit(state);
+        q->isr_dropped = dropped;
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t publisher_queue_init(mqtt_conn_id_t conn)
+{
+    publisher_queue_t *q = &s_queues[MQTT_CONN_ROUTE(conn)];
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (q->initialized) {
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = cy_rtos_init_semaphore(&q->space_semaphore, PUBLISHER_QUEUE_SLOTS, 0);
+
+    if ((result == CY_RSLT_SUCCESS) &&
+        !spsc_ring_init(&q->isr_ring, q->isr_items, sizeof(q->isr_items[0]),
+                        PUBLISHER_QUEUE_ISR_RING_SIZE)) {
+        CY_LOGE(TAG, "PUBLISHER_QUEUE_ISR_RING_SIZE must be a power of two!");
+        cy_rtos_deinit_semaphore(&q->space_semaphore);
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (result == CY_RSLT_SUCCESS) {
+        q->isr_dropped = 0;
+        q->head = 0;
+        q->count = 0;
+        q->msg_count = 0;
+        q->waiters = 0;
+        q->consumer = NULL;
+        q->normal_tokens = PUBLISHER_NORMAL_LANE_BURST;
+        cy_rtos_get_time(&q->normal_refill_time);
+        memset(&q->stats, 0, sizeof(q->stats));
+        q->initialized = true;
+    } else {
+        CY_LOGE(TAG, "cy_rtos_init_semaphore failed!");
+    }
+    return result;
+}
+
+cy_rslt_t publisher_queue_put(const publisher_data_t *item, bool in_isr)
+{
+    publisher_queue_t *q;
+    publisher_data_t victim;
+    bool evicted = false;
+    bool wait = false;
+    bool queued;
+    bool waited = false;
+    cy_time_t start_time = 0;
+    cy_time_t now = 0;
+
+    if (item == NULL) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    q = &s_queues[MQTT_CONN_ROUTE(item->conn)];
+    if (!q->initialized) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (in_isr) {
+        /* No critical section or queue copy in the ISR: one copy into the
+         * lock-free ring, and a task notification when the ring was empty.
+         * The publisher task empties the ring before it waits again, so a
+         * push to a ring that still holds items needs no wakeup.
+         */
+        if (!spsc_ring_push(&q->isr_ring, item)) {
+            return CY_RSLT_MODULE_MQTT_ERROR;
+        }
+        if ((spsc_ring_count(&q->isr_ring) == 1u) && (q->consumer != NULL)) {
+            BaseType_t woken = pdFALSE;
+
+            vTaskNotifyGiveFromISR(q->consumer, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+        return CY_RSLT_SUCCESS;
+    }
+
+    queued = queue_try_put(q, item, &victim, &evicted, &wait);
+
+    if (wait) {
+        cy_rtos_get_time(&start_time);
+
+        while (wait) {
+            uint32_t elapsed;
+            cy_rslt_t result;
+            uint32_t state;
+
+            cy_rtos_get_time(&now);
+            elapsed = (uint32_t)(now - start_time);
+
+            result = CY_RSLT_MODULE_MQTT_ERROR;
+            if (elapsed < PUBLISHER_QUEUE_BLOCK_TIMEOUT_MS) {
+                result = cy_rtos_get_semaphore(&q->space_semaphore,
+                                               PUBLISHER_QUEUE_BLOCK_TIMEOUT_MS - elapsed,
+                                               false);
+            }
+
+            state = cyhal_system_critical_section_enter();
+            q->waiters--;
+            if (!waited) {
+                q->stats.blocked++;
+                waited = true;
+            }
+            if (result != CY_RSLT_SUCCESS) {
+                q->stats.block_timeouts++;
+                q->stats.dropped_newest++;
+            }
+            cyhal_system_critical_section_exit(state);
+
+            if (result != CY_RSLT_SUCCESS) {
+                break;
+            }
+
+            /* Re-registers as a waiter if the slot was taken meanwhile */
+            queued = queue_try_put(q, item, &victim, &evicted, &wait);
+        }
+    }
+
+    if (evicted) {
+        queue_discard(&victim);
+    }
+
+    if (!queued) {
+        CY_LOGD(TAG, "queue full, command %d dropped", (int)item->cmd);
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t publisher_queue_get(mqtt_conn_id_t conn,
+                              publisher_data_t *item,
+                              cy_time_t timeout_ms)
+{
+    publisher_queue_t *q = &s_queues[MQTT_CONN_ROUTE(conn)];
+    bool wake_producer = false;
+    cy_time_t start_time = 0;
+    cy_time_t now = 0;
+    cy_time_t wait_ms;
+    uint32_t state;
+    int index;
+
+    if (!q->initialized || (item == NULL)) {
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    cy_rtos_get_time(&start_time);
+
+    while (true) {
+        queue_drain_isr_ring(q);
+
+        cy_rtos_get_time(&now);
+
+        state = cyhal_system_critical_section_enter();
+
+        index = queue_next(q, now, &wait_ms);
+        if (index >= 0) {
+            *item = *queue_at(q, (size_t)index);
+            queue_remove_at(q, (size_t)index);
+
+            if (q->waiters > 0) {
+                wake_producer = true;
+            }
+        }
+
+        cyhal_system_critical_section_exit(state);
+
+        if (index >= 0) {
+            break;
+        }
+
+        if (timeout_ms != CY_RTOS_NEVER_TIMEOUT) {
+            uint32_t elapsed = (uint32_t)(now - start_time);
+
+            if (elapsed >= timeout_ms) {
+                return CY_RTOS_TIMEOUT;
+            }
+            if (wait_ms > (timeout_ms - elapsed)) {
+                wait_ms = timeout_ms - elapsed;
+            }
+        }
+
+        /* Woken by a put, or when the normal lane may go on */
+        (void) ulTaskNotifyTake(pdTRUE, (wait_ms == CY_RTOS_NEVER_TIMEOUT) ?
+                                        portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+    }
+
+    if (wake_producer) {
+        cy_rtos_set_semaphore(&q->space_semaphore, false);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+void publisher_queue_attach(mqtt_conn_id_t conn)
+{
+    publisher_queue_t *q = &s_queues[MQTT_CONN_ROUTE(conn)];
+
+    /* Notifications given to an earlier task are not counted */
+    (void) ulTaskNotifyTake(pdTRUE, 0);
+    q->consumer = xTaskGetCurrentTaskHandle();
+}
+
+void publisher_queue_detach(mqtt_conn_id_t conn)
+{
+    publisher_queue_t *q = &s_queues[MQTT_CONN_ROUTE(conn)];
+    uint32_t state;
+
+    /* Not while an ISR is about to notify the task */
+    state = cyhal_system_critical_section_enter();
+    q->consumer = NULL;
+    cyhal_system_critical_section_exit(state);
+}
+
+void publisher_queue_set_policy(publisher_queue_policy_t policy)
+{
+    s_policy = policy;
+}
+
+publisher_queue_policy_t publisher_queue_get_policy(void)
+{
+    return s_policy;
+}
+
+const char* publisher_queue_policy_name(publisher_queue_policy_t policy)
+{
+    switch (policy) {
+        case PUBLISHER_QUEUE_DROP_OLDEST:       return "drop-oldest";
+        case PUBLISHER_QUEUE_DROP_NEWEST:       return "drop-newest";
+        case PUBLISHER_QUEUE_COALESCE_BY_TOPIC: return "coalesce";
+        case PUBLISHER_QUEUE_BLOCK:             return "block";
+        default:                                return "unknown";
+    }
+}
+
+void publisher_queue_get_stats(mqtt_conn_id_t conn,
+                               publisher_queue_stats_t *stats)
+{
+    publisher_queue_t *q = &s_queues[MQTT_CONN_ROUTE(conn)];
+    uint32_t state;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    state = cyhal_system_critical_section_enter();
+    *stats = q->stats;
+    cyhal_system_critical_section_exit(state);
+}
+
+void publisher_queue_reset_stats(void)
+{
+    uint32_t state;
+
+    state = cyhal_system_critical_section_enter();
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        publisher_queue_t *q = &s_queues[i];
+
+        memset(&q->stats, 0, sizeof(q->stats));
+        q->stats.depth = (uint16_t)q->count;
+        q->stats.peak_depth = q->stats.depth;
+    }
+    cyhal_system_critical_section_exit(state);
+}
+
+void publisher_queue_print_stats(void)
+{
+    publisher_queue_stats_t stats;
+
+    PRINT_MSG(("publisher queue: policy=%s\n",
+               publisher_queue_policy_name(s_policy)));
+
+    for (size_t i = 0; i < MQTT_CONNECTION_COUNT; i++) {
+        publisher_queue_get_stats((mqtt_conn_id_t)i, &stats);
+
+        PRINT_MSG(("  [%u] depth=%u/%u peak=%u enqueued=%lu "
+                   "dropped_oldest=%lu dropped_newest=%lu coalesced=%lu "
+                   "blocked=%lu block_timeouts=%lu high=%lu paced=%lu\n",
+                   (unsigned int)i,
+                   (unsigned int)stats.depth,
+                   (unsigned int)PUBLISHER_QUEUE_DEPTH,
+                   (unsigned int)stats.peak_depth,
+                   (unsigned long)stats.enqueued,
+                   (unsigned long)stats.dropped_oldest,
+                   (unsigned long)stats.dropped_newest,
+                   (unsigned long)stats.coalesced,
+                   (unsigned long)stats.blocked,
+                   (unsigned long)stats.block_timeouts,
+                   (unsigned long)stats.high_enqueued,
+                   (unsigned long)stats.paced));
+    }
+}
+
+/* [] END OF FILE */
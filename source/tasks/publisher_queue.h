@@ -0,0 +1,144 @@
+/******************************************************************************
+* File Name:   publisher_queue.h
+*
+* Description: This file is the public interface of publisher_queue.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_PUBLISHER_QUEUE_H_
+#define SOURCE_PUBLISHER_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cyabs_rtos.h"
+#include "publisher_task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* What publisher_queue_put() does with a PUBLISH_MQTT_MSG when the queue
+ * already holds PUBLISHER_QUEUE_DEPTH messages.
+ */
+typedef enum
+{
+    PUBLISHER_QUEUE_DROP_OLDEST,        /* evict the oldest queued message */
+    PUBLISHER_QUEUE_DROP_NEWEST,        /* reject the new message */
+    PUBLISHER_QUEUE_COALESCE_BY_TOPIC,  /* replace a queued message on the same
+                                           topic, else evict the oldest */
+    PUBLISHER_QUEUE_BLOCK,              /* wait up to PUBLISHER_QUEUE_BLOCK_TIMEOUT_MS */
+} publisher_queue_policy_t;
+
+/* Counters since boot or the last publisher_queue_reset_stats() */
+typedef struct
+{
+    uint32_t enqueued;
+    uint32_t dropped_oldest;
+    uint32_t dropped_newest;            /* includes block timeouts */
+    uint32_t coalesced;
+    uint32_t blocked;                   /* puts that had to wait for space */
+    uint32_t block_timeouts;
+    uint32_t high_enqueued;             /* PUBLISHER_PRIORITY_HIGH messages */
+    uint32_t paced;                     /* waits of the normal lane for its pace */
+    uint16_t depth;
+    uint16_t peak_depth;
+} publisher_queue_stats_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* Each MQTT connection has its own queue, drained by its publisher task;
+ * the overflow policy is shared.
+ */
+cy_rslt_t publisher_queue_init(mqtt_conn_id_t conn);
+
+/* Add a command for the publisher task. Safe from an ISR: there the item
+ * only goes to a lock-free ring (see spsc_ring.h), and fails if that is
+ * full; the publisher task then moves it into the queue, where the block
+ * policy degrades to drop-newest. ISRs that put to the same connection
+ * must share one interrupt priority.
+ * If the put fails, the caller keeps its payload reference. A queued
+ * message that is evicted later has its payload released and its
+ * complete_cb called with an error. Control commands are never evicted;
+ * they also use slots reserved for them. The item goes to the queue of
+ * MQTT_CONN_ROUTE(item->conn), in the lane of item->priority; a high
+ * message evicts the oldest normal one from a full queue whatever the
+ * policy, and is never evicted for a normal one.
+ */
+cy_rslt_t publisher_queue_put(const publisher_data_t *item, bool in_isr);
+
+/* Make the calling task the one woken by the puts to the queue of 'conn',
+ * with a task notification; the task uses no other notifications. Called
+ * by the publisher task before its first get.
+ */
+void publisher_queue_attach(mqtt_conn_id_t conn);
+
+/* Stop waking the task of 'conn', before it is deleted */
+void publisher_queue_detach(mqtt_conn_id_t conn);
+
+/* Take the oldest command of the high lane of 'conn', else the oldest
+ * message of its normal lane once the pacing allows it, waiting up to
+ * 'timeout_ms'.
+ */
+cy_rslt_t publisher_queue_get(mqtt_conn_id_t conn,
+                              publisher_data_t *item,
+                              cy_time_t timeout_ms);
+
+void publisher_queue_set_policy(publisher_queue_policy_t policy);
+
+publisher_queue_policy_t publisher_queue_get_policy(void);
+
+const char* publisher_queue_policy_name(publisher_queue_policy_t policy);
+
+void publisher_queue_get_stats(mqtt_conn_id_t conn,
+                               publisher_queue_stats_t *stats);
+
+/* Resets the counters of every connection */
+void publisher_queue_reset_stats(void);
+
+void publisher_queue_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_PUBLISHER_QUEUE_H_ */
+
+/* [] END OF FILE */
@@ -58,6 +58,14 @@
 #include "cy_mqtt_api.h"
 #include "cy_retarget_io.h"
 
+#include "mqtt_publish_ring.h"
+#include "mqtt_aggregator.h"
+#include "mqtt_publish_window.h"
+#include "publisher_queue.h"
+#include "mqtt_offline_store.h"
+#include "mqtt_uplink_budget.h"
+#include "bringup_timeline.h"
+
 /*-- Local Definitions -------------------------------------------------*/
 
 /* Interrupt priority for User Button Input. */
@@ -71,11 +79,6 @@
  */
 #define PUBLISH_RETRY_MS                (1000)
 
-/* Queue length of a message queue that is used to communicate with the 
- * publisher task.
- */
-#define PUBLISHER_TASK_QUEUE_LENGTH     (3u)
-
 
 /*-- Local Function Prototypes -------------------------------------------------*/
 static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event);
@@ -83,25 +86,47 @@ static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event);
 
 /*-- Public Data -------------------------------------------------*/
 
-cy_thread_t g_publisher_task_handle = NULL;
-
-/* Handle of the queue holding the commands for the publisher task */
-cy_queue_t g_publisher_task_q = NULL;
+cy_thread_t g_publisher_task_handle[MQTT_CONNECTION_COUNT];
 
 
 /*-- Local Data -------------------------------------------------*/
 
 static const char *TAG = "publisher_task";
 
-/* Structure to store publish message information. */
-static cy_mqtt_publish_info_t s_publish_info =
+/* State of the publisher task of one MQTT connection */
+typedef struct
 {
-    .qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
-    .topic = MQTT_PUB_TOPIC,
-    .topic_len = (sizeof(MQTT_PUB_TOPIC) - 1),
-    .retain = false,
-    .dup = false
-};
+    mqtt_conn_id_t conn;
+
+    /* Cleared between PUBLISHER_DEINIT and PUBLISHER_INIT, i.e. while the
+     * MQTT connection is being re-established. Publishes of the command
+     * connection then go to the offline store.
+     */
+    bool online;
+
+    /* Set once a replay of the offline store fails, so that the MQTT
+     * client task hears of it once rather than for every burst.
+     */
+    bool replay_failed;
+
+    /* Structure to store publish message information. */
+    cy_mqtt_publish_info_t publish_info;
+} publisher_ctx_t;
+
+static publisher_ctx_t s_ctx[MQTT_CONNECTION_COUNT];
+
+/* Set while a PUBLISH_MQTT_BATCH command is waiting in the queue */
+static volatile bool s_batch_pending = false;
+
+/* Set when a record of the publish window fails; stops the ring drain */
+static volatile bool s_window_failed = false;
+
+/* When the next burst of stored messages may be replayed */
+static cy_time_t s_next_replay_time = 0;
+
+/* Payloads published by the user button */
+static mqtt_payload_t s_device_on_payload = MQTT_PAYLOAD_STATIC_INIT(MQTT_DEVICE_ON_MESSAGE);
+static mqtt_payload_t s_device_off_payload = MQTT_PAYLOAD_STATIC_INIT(MQTT_DEVICE_OFF_MESSAGE);
 
 /* Structure that stores the callback data for the GPIO interrupt event. */
 static cyhal_gpio_callback_data_t s_cb_data =
@@ -139,25 +164,28 @@ static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event)
 
     /* Assign the publish command to be sent to the publisher task. */
     publisher_q_data.cmd = PUBLISH_MQTT_MSG;
+    publisher_q_data.topic = NULL;
+    publisher_q_data.qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS;
+    publisher_q_data.priority = PUBLISHER_PRIORITY_HIGH;
+    publisher_q_data.enqueue_time = 0;
+    publisher_q_data.complete_cb = NULL;
+    publisher_q_data.complete_arg = NULL;
+    publisher_q_data.conn = MQTT_CONN_COMMAND;
 
     /* Assign the publish message payload so that the device state toggles. */
     if (g_current_device_state == DEVICE_ON_STATE)
     {
-        publisher_q_data.data = (char *)MQTT_DEVICE_OFF_MESSAGE;
+        publisher_q_data.payload = &s_device_off_payload;
     }
     else
     {
-        publisher_q_data.data = (char *)MQTT_DEVICE_ON_MESSAGE;
+        publisher_q_data.payload = &s_device_on_payload;
     }
 
-    /* Send the command and data to publisher task over the queue */
-    if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_publisher_task_q,
-                                             (void *)&publisher_q_data,
-                                             CY_RTOS_NEVER_TIMEOUT,
-                                             true
-                                            )) {
-        CY_LOGD(TAG, "cy_rtos_put_queue(g_publisher_task_q) failed!");
-    }
+    /* Send the command and data to publisher task over the queue. A full
+     * queue is handled by its overflow policy and counted in its stats.
+     */
+    (void) publisher_queue_put(&publisher_q_data, true);
 }
 
 
@@ -188,7 +216,7 @@ static void publisher_init(void)
                             USER_BTN_INTR_PRIORITY, true);
     
     CY_LOGD(TAG, "Press the user button (SW2) to publish \"%s\"/\"%s\" on the topic '%s'...\n",
-           MQTT_DEVICE_ON_MESSAGE, MQTT_DEVICE_OFF_MESSAGE, s_publish_info.topic);
+           MQTT_DEVICE_ON_MESSAGE, MQTT_DEVICE_OFF_MESSAGE, MQTT_PUB_TOPIC);
 }
 
 /******************************************************************************
@@ -218,6 +246,401 @@ static void publisher_deinit(void)
     cyhal_gpio_free(CYBSP_USER_BTN);
 }
 
+/******************************************************************************
+ * Function Name: publisher_wait_budget
+ ******************************************************************************
+ * Summary:
+ *  Function that waits until the uplink budget lets a message of 'len'
+ *  bytes go out, and takes its tokens.
+ *
+ * Parameters:
+ *  size_t len : length of the topic and payload in bytes
+ *  bool high : true for a PUBLISHER_PRIORITY_HIGH message
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publisher_wait_budget(size_t len, bool high)
+{
+    uint32_t wait_ms;
+
+    while ((wait_ms = mqtt_uplink_budget_acquire(len, high)) > 0)
+    {
+        cy_rtos_delay_milliseconds(wait_ms);
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_send
+ ******************************************************************************
+ * Summary:
+ *  Function that publishes one message and, if 'report' is set, informs
+ *  the MQTT client task when the publish fails. On a metered link, a
+ *  normal priority message first waits for the tokens of the uplink
+ *  budget.
+ *
+ * Parameters:
+ *  publisher_ctx_t *ctx : publisher of the connection
+ *  const char *topic : topic to publish on (need not be NUL-terminated)
+ *  size_t topic_len : length of the topic
+ *  const uint8_t *data : message payload
+ *  size_t len : length of the payload in bytes
+ *  cy_mqtt_qos_t qos : QoS of the message
+ *  bool high : true for a PUBLISHER_PRIORITY_HIGH message
+ *  bool report : true to post HANDLE_MQTT_PUBLISH_FAILURE on failure
+ *
+ * Return:
+ *  cy_rslt_t : result of cy_mqtt_publish()
+ *
+ ******************************************************************************/
+static cy_rslt_t publisher_send(publisher_ctx_t *ctx,
+                                const char *topic,
+                                size_t topic_len,
+                                const uint8_t *data,
+                                size_t len,
+                                cy_mqtt_qos_t qos,
+                                bool high,
+                                bool report)
+{
+    cy_rslt_t result;
+    cy_mqtt_publish_info_t *publish_info = &ctx->publish_info;
+    publisher_wait_budget(topic_len + len, high);
+
+    publish_info->topic = topic;
+    publish_info->topic_len = topic_len;
+    publish_info->qos = qos;
+    publish_info->payload = (const char *)data;
+    publish_info->payload_len = len;
+
+    CY_LOGD(TAG, "Publisher: Publishing %u bytes on the topic '%.*s'\n",
+           (unsigned int) publish_info->payload_len,
+           (int) publish_info->topic_len, publish_info->topic);
+
+    result = cy_mqtt_publish(g_mqtt_connection[ctx->conn], publish_info);
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        bringup_timeline_mark(BRINGUP_STAGE_FIRST_PUBLISH);
+    }
+    else
+    {
+        CY_LOGD(TAG, "Publisher: MQTT Publish failed with error 0x%0X.\n", (int)result);
+
+        /* Communicate the publish failure with the the MQTT
+         * client task.
+         */
+        if (report)
+        {
+            (void) mqtt_task_post(HANDLE_MQTT_PUBLISH_FAILURE, ctx->conn);
+        }
+    }
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: publisher_publish
+ ******************************************************************************
+ * Summary:
+ *  Function that publishes one message. On the command connection, the
+ *  message is copied to the offline store when the MQTT connection is down
+ *  or the publish fails, and a normal priority message waits behind the
+ *  stored backlog, so that the broker gets the messages in order; high
+ *  priority messages overtake the backlog. A message refused by the level
+ *  of the data budget is dropped.
+ *
+ * Parameters:
+ *  publisher_ctx_t *ctx : publisher of the connection
+ *  const char *topic : topic to publish on (NULL = MQTT_PUB_TOPIC)
+ *  const mqtt_payload_t *payload : message payload
+ *  cy_mqtt_qos_t qos : QoS of the message
+ *  bool high : true for a PUBLISHER_PRIORITY_HIGH message
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if the message was published or stored
+ *
+ ******************************************************************************/
+static cy_rslt_t publisher_publish(publisher_ctx_t *ctx,
+                                   const char *topic,
+                                   const mqtt_payload_t *payload,
+                                   cy_mqtt_qos_t qos,
+                                   bool high)
+{
+    cy_rslt_t result = CY_RSLT_MODULE_MQTT_ERROR;
+
+    if (topic == NULL)
+    {
+        topic = MQTT_PUB_TOPIC;
+    }
+
+    if (!mqtt_uplink_budget_admit(high, false))
+    {
+        CY_LOGD(TAG, "Publisher: message on '%s' dropped by the data budget\n", topic);
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    if (ctx->online)
+    {
+        /* Replayed in order with the stored messages */
+        if ((ctx->conn == MQTT_CONN_COMMAND) && !high &&
+            (mqtt_offline_store_count() > 0) &&
+            (mqtt_offline_store_append(topic, payload, qos) == CY_RSLT_SUCCESS))
+        {
+            return CY_RSLT_SUCCESS;
+        }
+
+        result = publisher_send(ctx, topic, strlen(topic), payload->data, payload->len, qos, high, true);
+    }
+
+    if ((result != CY_RSLT_SUCCESS) && (ctx->conn == MQTT_CONN_COMMAND))
+    {
+        result = mqtt_offline_store_append(topic, payload, qos);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            CY_LOGE(TAG, "Publisher: message on '%s' lost\n", topic);
+        }
+    }
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: publisher_replay_offline
+ ******************************************************************************
+ * Summary:
+ *  Function that publishes the next burst of messages from the offline
+ *  store. Bursts are at most MQTT_OFFLINE_REPLAY_BURST messages and
+ *  MQTT_OFFLINE_REPLAY_INTERVAL_MS apart, so that the backlog does not
+ *  starve high priority messages or flood the link after a reconnection;
+ *  normal messages published meanwhile join the backlog. A failed burst
+ *  is reported to the MQTT client task once, until a replay succeeds
+ *  again. The offline store belongs to the command connection.
+ *
+ * Parameters:
+ *  publisher_ctx_t *ctx : publisher of the connection
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publisher_replay_offline(publisher_ctx_t *ctx)
+{
+    mqtt_offline_record_t record;
+    cy_time_t now = 0;
+
+    if ((ctx->conn != MQTT_CONN_COMMAND) || !ctx->online ||
+        (mqtt_offline_store_count() == 0))
+    {
+        return;
+    }
+
+    cy_rtos_get_time(&now);
+    if ((int32_t)(s_next_replay_time - now) > 0)
+    {
+        return;
+    }
+    s_next_replay_time = now + MQTT_OFFLINE_REPLAY_INTERVAL_MS;
+
+    /* Stored messages wait for the next day once only alarms may be sent. */
+    if (mqtt_uplink_budget_level() >= MQTT_BUDGET_LEVEL_ALARMS_ONLY)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < MQTT_OFFLINE_REPLAY_BURST; i++)
+    {
+        /* Do not hold up new messages for the tokens of the uplink budget */
+        if ((mqtt_uplink_budget_wait_ms() > 0) ||
+            !mqtt_offline_store_peek(&record))
+        {
+            break;
+        }
+
+        /* Left in the store on failure; retried with the next burst */
+        if (publisher_send(ctx,
+                           record.topic,
+                           record.topic_len,
+                           record.payload,
+                           record.payload_len,
+                           record.qos,
+                           false,
+                           !ctx->replay_failed) != CY_RSLT_SUCCESS)
+        {
+            ctx->replay_failed = true;
+            break;
+        }
+        ctx->replay_failed = false;
+        mqtt_offline_store_drop();
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_idle_wait_ms
+ ******************************************************************************
+ * Summary:
+ *  Function that returns how long the publisher task may wait for a
+ *  command before the next replay burst, or the flush of the partly
+ *  filled block of the offline store, is due. A flush that is already
+ *  due is done here, so that stored messages reach flash without waiting
+ *  for the next one.
+ *
+ * Parameters:
+ *  publisher_ctx_t *ctx : publisher of the connection
+ *
+ * Return:
+ *  cy_time_t : timeout for publisher_queue_get()
+ *
+ ******************************************************************************/
+static cy_time_t publisher_idle_wait_ms(publisher_ctx_t *ctx)
+{
+    cy_time_t now = 0;
+    cy_time_t flush_ms;
+    cy_time_t replay_ms;
+
+    if (ctx->conn != MQTT_CONN_COMMAND)
+    {
+        return CY_RTOS_NEVER_TIMEOUT;
+    }
+
+    flush_ms = mqtt_offline_store_poll();
+
+    if (!ctx->online || (mqtt_offline_store_count() == 0))
+    {
+        return flush_ms;
+    }
+
+    cy_rtos_get_time(&now);
+    if ((int32_t)(s_next_replay_time - now) <= 0)
+    {
+        return 0;
+    }
+    replay_ms = s_next_replay_time - now;
+    return (replay_ms < flush_ms) ? replay_ms : flush_ms;
+}
+
+/******************************************************************************
+ * Function Name: publisher_drain_ring
+ ******************************************************************************
+ * Summary:
+ *  Function that publishes the records in the outbound ring back-to-back,
+ *  without returning to the message queue in between. Up to
+ *  MQTT_PUBLISH_WINDOW_SIZE records are in flight at once; the drain only
+ *  waits when the window is full. On the command connection, the records
+ *  move to the offline store while the MQTT connection is down. A record
+ *  that cannot be published or stored stays in the ring (a failed record
+ *  of the window goes back in its place) and is retried after the next
+ *  PUBLISHER_INIT, i.e. after the MQTT reconnection. Records are dropped
+ *  while the level of the data budget refuses batches.
+ *
+ * Parameters:
+ *  publisher_ctx_t *ctx : publisher of the connection
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publisher_drain_ring(publisher_ctx_t *ctx)
+{
+    mqtt_publish_record_t record;
+
+    /* Only the publisher of the bulk route owns the ring. */
+    if (ctx->conn != MQTT_CONN_ROUTE(MQTT_CONN_BULK))
+    {
+        return;
+    }
+
+    /* Producers that push from now on post another PUBLISH_MQTT_BATCH. */
+    s_batch_pending = false;
+    s_window_failed = false;
+
+    while (!s_window_failed && mqtt_publish_ring_peek(&record))
+    {
+        /* Batches are the first traffic to go when the data budget runs low */
+        if (!mqtt_uplink_budget_admit(false, true))
+        {
+            /* Dropped */
+        }
+        else if (ctx->online)
+        {
+            const char *topic = (record.topic != NULL) ? record.topic : MQTT_PUB_TOPIC;
+
+            publisher_wait_budget(strlen(topic) + record.payload->len, false);
+
+            /* Out of the ring before it is submitted: a slot that fails
+             * meanwhile puts its record back at the head, which a later
+             * drop would remove instead.
+             */
+            mqtt_publish_ring_drop();
+
+            /* Waits for a free slot; the window owns the record from here. */
+            if (mqtt_publish_window_submit(g_mqtt_connection[ctx->conn],
+                                           &record,
+                                           CY_RTOS_NEVER_TIMEOUT) != CY_RSLT_SUCCESS)
+            {
+                if (mqtt_publish_ring_requeue(&record) != CY_RSLT_SUCCESS)
+                {
+                    CY_LOGE(TAG, "Publisher: message on '%s' lost\n", topic);
+                    mqtt_payload_release(record.payload);
+                }
+                break;
+            }
+            continue;
+        }
+        else if (publisher_publish(ctx,
+                                   record.topic,
+                                   record.payload,
+                                   record.qos,
+                                   false) != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+        mqtt_publish_ring_drop();
+        mqtt_payload_release(record.payload);
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_window_complete
+ ******************************************************************************
+ * Summary:
+ *  Callback of the publish window, called by its slot task once a record
+ *  of the ring has been acknowledged or has failed. A failed record goes
+ *  back to the ring and stops the drain until the next PUBLISHER_INIT or
+ *  PUBLISH_MQTT_BATCH.
+ *
+ * Parameters:
+ *  cy_rslt_t result : result of cy_mqtt_publish()
+ *  const mqtt_publish_record_t *record : the record, with its payload reference
+ *  void *arg : publisher_ctx_t of the bulk route
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publisher_window_complete(cy_rslt_t result,
+                                      const mqtt_publish_record_t *record,
+                                      void *arg)
+{
+    publisher_ctx_t *ctx = (publisher_ctx_t *)arg;
+
+    if (result == CY_RSLT_SUCCESS)
+    {
+        mqtt_payload_release(record->payload);
+        return;
+    }
+
+    CY_LOGD(TAG, "Publisher: MQTT Publish failed with error 0x%0X.\n", (int)result);
+    s_window_failed = true;
+    (void) mqtt_task_post(HANDLE_MQTT_PUBLISH_FAILURE, ctx->conn);
+
+    /* Back in its place, ahead of the records pushed after it */
+    if (mqtt_publish_ring_requeue(record) != CY_RSLT_SUCCESS)
+    {
+        CY_LOGE(TAG, "Publisher: message on '%s' lost\n",
+                (record->topic != NULL) ? record->topic : MQTT_PUB_TOPIC);
+        mqtt_payload_release(record->payload);
+    }
+}
+
 
 /*-- Public Functions -------------------------------------------------*/
 
@@ -228,10 +651,12 @@ static void publisher_deinit(void)
  *  Task that sets up the user button GPIO for the publisher and publishes
  *  MQTT messages to the broker. The user button init and deinit operations,
  *  and the MQTT publish operation is performed based on commands sent by other
- *  tasks and callbacks over a message queue.
+ *  tasks and callbacks over a message queue. One instance runs per MQTT
+ *  connection; the user button and the offline store belong to the command
+ *  connection, the outbound ring to the bulk one.
  *
  * Parameters:
- *  void *pvParameters : Task parameter defined during task creation (unused)
+ *  void *pvParameters : mqtt_conn_id_t of the connection
  *
  * Return:
  *  void
@@ -244,81 +669,191 @@ void publisher_task(cy_thread_arg_t pvParameters)
 
     publisher_data_t publisher_q_data;
 
-    /* Command to the MQTT client task */
-    mqtt_task_cmd_t mqtt_task_cmd;
+    mqtt_conn_id_t conn = MQTT_CONN_ROUTE((mqtt_conn_id_t)(uintptr_t)pvParameters);
+    publisher_ctx_t *ctx = &s_ctx[conn];
 
-    /* To avoid compiler warnings */
-    (void) pvParameters;
+    ctx->conn = conn;
+    ctx->online = true;
+    ctx->publish_info.qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS;
+    ctx->publish_info.retain = false;
+    ctx->publish_info.dup = false;
+
+    if (ctx->conn == MQTT_CONN_COMMAND) {
+        /* Initialize and set-up the user button GPIO. */
+        publisher_init();
+
+        /* Open the offline store; messages stored before a reset are replayed. */
+        if (CY_RSLT_SUCCESS != mqtt_offline_store_init()) {
+            CY_LOGD(TAG, "mqtt_offline_store_init failed!");
+            DEBUG_ASSERT(0);
+        }
+    }
+
+    if (ctx->conn == MQTT_CONN_ROUTE(MQTT_CONN_BULK)) {
+        /* Create the ring holding the records of publisher_publish_batch(). */
+        if (CY_RSLT_SUCCESS != mqtt_publish_ring_init()) {
+            CY_LOGD(TAG, "mqtt_publish_ring_init failed!");
+            DEBUG_ASSERT(0);
+        }
 
-    /* Initialize and set-up the user button GPIO. */
-    publisher_init();
+        /* Create the tasks that keep the records of the ring in flight, or
+         * open the window again after a restart of the app.
+         */
+        if (CY_RSLT_SUCCESS != mqtt_publish_window_init(publisher_window_complete, ctx)) {
+            CY_LOGD(TAG, "mqtt_publish_window_init failed!");
+            DEBUG_ASSERT(0);
+        }
+    }
 
-    /* Create a message queue to communicate with other tasks and callbacks. */
-    if (CY_RSLT_SUCCESS !=  cy_rtos_init_queue( &g_publisher_task_q,
-                                                PUBLISHER_TASK_QUEUE_LENGTH,
-                                                sizeof(publisher_data_t)
-                                              )) {
-        CY_LOGD(TAG, "cy_rtos_init_queue(g_publisher_task_q) failed!");
+    /* Create the queue used to communicate with other tasks and callbacks,
+     * and be the task it wakes.
+     */
+    if (CY_RSLT_SUCCESS != publisher_queue_init(ctx->conn)) {
+        CY_LOGD(TAG, "publisher_queue_init failed!");
         DEBUG_ASSERT(0);
     }
+    publisher_queue_attach(ctx->conn);
 
     while (true)
     {
         /* Wait for commands from other tasks and callbacks. */
-        if (CY_RSLT_SUCCESS == cy_rtos_get_queue(  &g_publisher_task_q,
-                                                   (void *)&publisher_q_data,
-                                                   CY_RTOS_NEVER_TIMEOUT,
-                                                   false))
+        /* Wake up for the next replay burst or offline store flush if no
+         * command comes first.
+         */
+        if (CY_RSLT_SUCCESS == publisher_queue_get(ctx->conn,
+                                                   &publisher_q_data,
+                                                   publisher_idle_wait_ms(ctx)))
         {
             switch(publisher_q_data.cmd)
             {
                 case PUBLISHER_INIT:
                 {
                     /* Initialize and set-up the user button GPIO. */
-                    publisher_init();
+                    if (ctx->conn == MQTT_CONN_COMMAND) {
+                        publisher_init();
+                    }
+                    ctx->online = true;
+                    ctx->replay_failed = false;
+
+                    /* The MQTT task stopped the window before reconnecting. */
+                    if (ctx->conn == MQTT_CONN_ROUTE(MQTT_CONN_BULK)) {
+                        mqtt_publish_window_start();
+                    }
+
+                    /* Flush the records left over from before the reconnection. */
+                    publisher_drain_ring(ctx);
                     break;
                 }
 
                 case PUBLISHER_DEINIT:
                 {
                     /* Deinit the user button GPIO and corresponding interrupt. */
-                    publisher_deinit();
+                    if (ctx->conn == MQTT_CONN_COMMAND) {
+                        publisher_deinit();
+                    }
+
+                    /* Store the messages until the reconnection. */
+                    ctx->online = false;
                     break;
                 }
 
                 case PUBLISH_MQTT_MSG:
                 {
                     /* Publish the data received over the message queue. */
-                    s_publish_info.payload = publisher_q_data.data;
-                    s_publish_info.payload_len = strlen(s_publish_info.payload);
-
-                    CY_LOGD(TAG, "Publisher: Publishing '%s' on the topic '%s'\n",
-                           (char *) s_publish_info.payload, s_publish_info.topic);
+                    result = publisher_publish(ctx,
+                                               publisher_q_data.topic,
+                                               publisher_q_data.payload,
+                                               publisher_q_data.qos,
+                                               (publisher_q_data.priority == PUBLISHER_PRIORITY_HIGH));
 
-                    result = cy_mqtt_publish(g_mqtt_connection, &s_publish_info);
+                    /* The payload is no longer needed by the MQTT library. */
+                    mqtt_payload_release(publisher_q_data.payload);
 
-                    if (result != CY_RSLT_SUCCESS)
+                    if (publisher_q_data.complete_cb != NULL)
                     {
-                        CY_LOGD(TAG, "Publisher: MQTT Publish failed with error 0x%0X.\n", (int)result);
-
-                        /* Communicate the publish failure with the the MQTT
-                         * client task.
-                         */
-                        mqtt_task_cmd = HANDLE_MQTT_PUBLISH_FAILURE;
-
-                        if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_mqtt_task_q,
-                                                                 (void *)&mqtt_task_cmd,
-                                                                 CY_RTOS_NEVER_TIMEOUT,
-                                                                 false
-                                                                )) {
-                            CY_LOGD(TAG, "cy_rtos_put_queue(g_mqtt_task_q) failed!");
-                        }
+                        publisher_q_data.complete_cb(result,
+                                                     publisher_q_data.enqueue_time,
+                                                     publisher_q_data.complete_arg);
                     }
                     break;
                 }
+
+                case PUBLISH_MQTT_BATCH:
+                {
+                    /* Publish the records queued by publisher_publish_batch(). */
+                    publisher_drain_ring(ctx);
+                    break;
+                }
+
+                case PUBLISH_MQTT_AGGREGATE:
+                {
+                    /* Publish the aggregation windows that have ended. */
+                    mqtt_aggregator_service();
+                    break;
+                }
             }
         }
+
+        /* Publish the next burst of stored messages, once it is due. */
+        publisher_replay_offline(ctx);
+    }
+}
+
+
+/******************************************************************************
+ * Function Name: publisher_publish_batch
+ ******************************************************************************
+ * Summary:
+ *  Function that queues a batch of messages in the outbound ring and asks
+ *  the publisher task of the bulk connection to publish them back-to-back.
+ *  Either the whole batch is accepted or none of it. Once accepted, the
+ *  ring owns the records: should the publisher queue be full, they are
+ *  published with the next batch or after the next reconnection.
+ *
+ * Parameters:
+ *  const mqtt_publish_record_t *records : messages to publish
+ *  size_t count : number of records
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if the batch was queued, else an error code
+ *              (e.g. when the ring lacks space for the whole batch).
+ *
+ ******************************************************************************/
+cy_rslt_t publisher_publish_batch(const mqtt_publish_record_t *records,
+                                  size_t count)
+{
+    cy_rslt_t result;
+    publisher_data_t publisher_q_data;
+    uint32_t state;
+    bool post;
+
+    result = mqtt_publish_ring_push(records, count);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        return result;
+    }
+
+    /* Producers on several tasks: only one posts the drain command. */
+    state = cyhal_system_critical_section_enter();
+    post = !s_batch_pending;
+    s_batch_pending = true;
+    cyhal_system_critical_section_exit(state);
+
+    if (post)
+    {
+        publisher_q_data.cmd = PUBLISH_MQTT_BATCH;
+        publisher_q_data.payload = NULL;
+        publisher_q_data.complete_cb = NULL;
+        publisher_q_data.conn = MQTT_CONN_ROUTE(MQTT_CONN_BULK);
+
+        if (publisher_queue_put(&publisher_q_data, false) != CY_RSLT_SUCCESS)
+        {
+            /* The records stay in the ring for the next drain. */
+            CY_LOGD(TAG, "publisher_queue_put failed!");
+            s_batch_pending = false;
+        }
     }
+    return CY_RSLT_SUCCESS;
 }
 
 /* [] END OF FILE */
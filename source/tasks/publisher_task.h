@@ -45,6 +45,10 @@
 #include "feature_config.h"
 #include "cy_debug.h"
 #include "cyabs_rtos.h"
+#include "cy_mqtt_api.h"
+#include "mqtt_publish_ring.h"
+#include "mqtt_payload.h"
+#include "mqtt_task.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -59,6 +63,10 @@ extern "C"
 #define PUBLISHER_TASK_PRIORITY               CY_RTOS_PRIORITY_BELOWNORMAL
 #define PUBLISHER_TASK_STACK_SIZE             (1024 * 2)
 
+/* Task parameters for the publisher task of the bulk connection. */
+#define PUBLISHER_BULK_TASK_NAME              "Bulk publisher task"
+#define PUBLISHER_BULK_TASK_PRIORITY          CY_RTOS_PRIORITY_LOW
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -67,26 +75,59 @@ typedef enum
 {
     PUBLISHER_INIT,
     PUBLISHER_DEINIT,
-    PUBLISH_MQTT_MSG
+    PUBLISH_MQTT_MSG,
+    PUBLISH_MQTT_BATCH,
+    PUBLISH_MQTT_AGGREGATE      /* windows of mqtt_aggregator.c have ended */
 } publisher_cmd_t;
 
-/* Struct to be passed via the publisher task queue */
+/* Lane of a PUBLISH_MQTT_MSG in the publisher queue. Control commands
+ * always go in the high lane.
+ */
+typedef enum
+{
+    PUBLISHER_PRIORITY_NORMAL,            /* periodic telemetry */
+    PUBLISHER_PRIORITY_HIGH               /* alarms and commands */
+} publisher_priority_t;
+
+/* Callback invoked by the publisher task once a PUBLISH_MQTT_MSG has been
+ * handled. For QoS1/QoS2 this is after the broker acknowledged the message.
+ * A message kept in the offline store for later replay also counts as a
+ * success.
+ */
+typedef void (*publisher_complete_cb_t)(cy_rslt_t result,
+                                        cy_time_t enqueue_time,
+                                        void *arg);
+
+/* Struct to be passed via the publisher task queue. For PUBLISH_MQTT_MSG,
+ * the queue takes over the producer's payload reference; the publisher
+ * task releases it once cy_mqtt_publish() has returned (after the
+ * acknowledgement for QoS1/QoS2).
+ */
 typedef struct{
     publisher_cmd_t cmd;
-    char *data;
+    mqtt_payload_t *payload;
+    const char *topic;                    /* NULL = MQTT_PUB_TOPIC */
+    cy_mqtt_qos_t qos;
+    publisher_priority_t priority;
+    cy_time_t enqueue_time;               /* set by the producer (optional) */
+    publisher_complete_cb_t complete_cb;  /* NULL if not needed */
+    void *complete_arg;
+    mqtt_conn_id_t conn;                  /* connection that publishes it */
 } publisher_data_t;
 
 /*******************************************************************************
 * Extern Variables
 ********************************************************************************/
-extern cy_thread_t g_publisher_task_handle;
-extern cy_queue_t g_publisher_task_q;
+extern cy_thread_t g_publisher_task_handle[MQTT_CONNECTION_COUNT];
 
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
 void publisher_task(cy_thread_arg_t pvParameters);
 
+cy_rslt_t publisher_publish_batch(const mqtt_publish_record_t *records,
+                                  size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,6 +49,7 @@
 /* Task header files */
 #include "subscriber_task.h"
 #include "mqtt_task.h"
+#include "bringup_timeline.h"
 
 /* Configuration file for MQTT client */
 #include "mqtt_client_config.h"
@@ -57,6 +58,10 @@
 #include "cy_mqtt_api.h"
 #include "cy_retarget_io.h"
 
+#include "mqtt_topic_trie.h"
+#include "mqtt_rx_pool.h"
+#include "mqtt_stream.h"
+
 /*-- Local Definitions -------------------------------------------------*/
 
 /* Maximum number of retries for MQTT subscribe operation */
@@ -65,13 +70,14 @@
 /* Time interval in milliseconds between MQTT subscribe retries. */
 #define MQTT_SUBSCRIBE_RETRY_INTERVAL_MS        (1000)
 
-/* The number of MQTT topics to be subscribed to. */
-#define SUBSCRIPTION_COUNT                      (1)
+/* Number of topic filters sent in one SUBSCRIBE/UNSUBSCRIBE packet. */
+#define SUBSCRIPTION_CHUNK_SIZE                 (8u)
 
 /* Queue length of a message queue that is used to communicate with the
- * subscriber task.
+ * subscriber task: every slab of the receive pool, plus room for the
+ * control commands.
  */
-#define SUBSCRIBER_TASK_QUEUE_LENGTH            (1u)
+#define SUBSCRIBER_TASK_QUEUE_LENGTH            (MQTT_RX_SLAB_COUNT + 2u)
 
 
 /*-- Public Data -------------------------------------------------*/
@@ -91,12 +97,19 @@ uint32_t g_current_device_state = DEVICE_OFF_STATE;
 
 static const char *TAG = "subscriber_task";
 
-/* Configure the subscription information structure. */
-static cy_mqtt_subscribe_info_t s_subscribe_info = {
-    .qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
-    .topic = MQTT_SUB_TOPIC,
-    .topic_len = (sizeof(MQTT_SUB_TOPIC) - 1)
-};
+/* Command being handled. It is kept across restarts of the task so that
+ * the slab of a message whose handling was cut short can be reclaimed.
+ */
+static subscriber_data_t s_q_data;
+
+/* Subscription information of the filters in the topic trie. */
+static cy_mqtt_subscribe_info_t s_subscribe_info[MQTT_TOPIC_TRIE_MAX_FILTERS];
+
+/* Received messages dropped because the subscriber queue was full */
+static volatile uint32_t s_rx_queue_full = 0;
+
+/* CRC-32 of the configuration being received */
+static uint32_t s_config_crc = 0;
 
 
 /*-- Local Functions -------------------------------------------------*/
@@ -105,9 +118,9 @@ static cy_mqtt_subscribe_info_t s_subscribe_info = {
  * Function Name: subscribe_to_topic
  ******************************************************************************
  * Summary:
- *  Function that subscribes to the MQTT topic specified by the macro
- *  'MQTT_SUB_TOPIC'. This operation is retried a maximum of
- *  'MAX_SUBSCRIBE_RETRIES' times with interval of
+ *  Function that subscribes to the topic filters registered in the topic
+ *  trie, SUBSCRIPTION_CHUNK_SIZE filters per SUBSCRIBE packet. Each packet
+ *  is retried a maximum of 'MAX_SUBSCRIBE_RETRIES' times with interval of
  *  'MQTT_SUBSCRIBE_RETRY_INTERVAL_MS' milliseconds.
  *
  * Parameters:
@@ -122,63 +135,71 @@ static void subscribe_to_topic(void)
     /* Status variable */
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    /* Command to the MQTT client task */
-    mqtt_task_cmd_t mqtt_task_cmd;
+    size_t count = mqtt_topic_trie_get_subscriptions(s_subscribe_info,
+                                                     MQTT_TOPIC_TRIE_MAX_FILTERS);
+
+    for (size_t first = 0; (first < count) && (result == CY_RSLT_SUCCESS);
+         first += SUBSCRIPTION_CHUNK_SIZE) {
+        size_t chunk = count - first;
 
-    /* Subscribe with the configured parameters. */
-    for (uint32_t retry_count = 0; retry_count < MAX_SUBSCRIBE_RETRIES; retry_count++) {
-        result = cy_mqtt_subscribe(g_mqtt_connection, &s_subscribe_info, SUBSCRIPTION_COUNT);
-        if (result == CY_RSLT_SUCCESS) {
-            CY_LOGD(TAG, "MQTT client subscribed to the topic '%.*s' successfully.\n",
-                   s_subscribe_info.topic_len, s_subscribe_info.topic);
-            break;
+        if (chunk > SUBSCRIPTION_CHUNK_SIZE) {
+            chunk = SUBSCRIPTION_CHUNK_SIZE;
         }
 
-        cy_rtos_delay_milliseconds(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS);
+        /* Subscribe with the configured parameters. */
+        for (uint32_t retry_count = 0; retry_count < MAX_SUBSCRIBE_RETRIES; retry_count++) {
+            result = cy_mqtt_subscribe(g_mqtt_connection[MQTT_CONN_COMMAND], &s_subscribe_info[first], (uint8_t)chunk);
+            if (result == CY_RSLT_SUCCESS) {
+                for (size_t i = first; i < (first + chunk); i++) {
+                    CY_LOGD(TAG, "MQTT client subscribed to the topic '%.*s' successfully.\n",
+                           s_subscribe_info[i].topic_len, s_subscribe_info[i].topic);
+                }
+                break;
+            }
+
+            cy_rtos_delay_milliseconds(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS);
+        }
     }
 
-    if (result != CY_RSLT_SUCCESS) {
+    if (result == CY_RSLT_SUCCESS) {
+        bringup_timeline_mark(BRINGUP_STAGE_SUBSCRIBED);
+    } else {
         CY_LOGD(TAG, "MQTT Subscribe failed with error 0x%0X after %d retries...\n",
                (int)result, MAX_SUBSCRIBE_RETRIES);
 
         /* Notify the MQTT client task about the subscription failure */
-        mqtt_task_cmd = HANDLE_MQTT_SUBSCRIBE_FAILURE;
-
-        if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_mqtt_task_q,
-                (void *)&mqtt_task_cmd,
-                CY_RTOS_NEVER_TIMEOUT,
-                false
-                                                )) {
-            CY_LOGD(TAG, "cy_rtos_put_queue(g_mqtt_task_q) failed!");
-        }
+        (void) mqtt_task_post(HANDLE_MQTT_SUBSCRIBE_FAILURE, MQTT_CONN_COMMAND);
     }
 }
 
 /******************************************************************************
- * Function Name: mqtt_subscription_callback
+ * Function Name: device_state_handler
  ******************************************************************************
  * Summary:
- *  Callback to handle incoming MQTT messages. This callback prints the
+ *  Topic trie handler of 'MQTT_SUB_TOPIC'. This handler prints the
  *  contents of the incoming message and informs the subscriber task, via a
  *  message queue, to turn on / turn off the device based on the received
  *  message.
  *
  * Parameters:
- *  cy_mqtt_publish_info_t *received_msg_info : Information structure of the
- *                                              received MQTT message
+ *  const cy_mqtt_publish_info_t *received_msg_info : Information structure
+ *                                                    of the received MQTT message
+ *  void *arg : argument given at registration (unused)
  *
  * Return:
  *  void
  *
  ******************************************************************************/
-void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
+static void device_state_handler(const cy_mqtt_publish_info_t *received_msg_info,
+                                 void *arg)
 {
     /* Received MQTT message */
     const char *received_msg = received_msg_info->payload;
     int received_msg_len = received_msg_info->payload_len;
 
-    /* Data to be sent to the subscriber task queue. */
-    subscriber_data_t subscriber_q_data;
+    uint8_t device_state;
+
+    (void) arg;
 
     CY_LOGD(TAG, "Subsciber: Incoming MQTT message received:\n"
            "    Publish topic name: %.*s\n"
@@ -188,28 +209,68 @@ void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
            (int) received_msg_info->qos,
            (int) received_msg_info->payload_len, (const char *)received_msg_info->payload);
 
-    /* Assign the command to be sent to the subscriber task. */
-    subscriber_q_data.cmd = UPDATE_DEVICE_STATE;
-
     /* Assign the device state depending on the received MQTT message. */
     if ((strlen(MQTT_DEVICE_ON_MESSAGE) == received_msg_len) &&
             (strncmp(MQTT_DEVICE_ON_MESSAGE, received_msg, received_msg_len) == 0)) {
-        subscriber_q_data.data = DEVICE_ON_STATE;
+        device_state = DEVICE_ON_STATE;
     } else if ((strlen(MQTT_DEVICE_OFF_MESSAGE) == received_msg_len) &&
                (strncmp(MQTT_DEVICE_OFF_MESSAGE, received_msg, received_msg_len) == 0)) {
-        subscriber_q_data.data = DEVICE_OFF_STATE;
+        device_state = DEVICE_OFF_STATE;
     } else {
         CY_LOGD(TAG, "Subscriber: Received MQTT message not in valid format!");
         return;
     }
 
-    /* Send the command and data to subscriber task queue */
-    if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_subscriber_task_q,
-            (void *)&subscriber_q_data,
-            CY_RTOS_NEVER_TIMEOUT,
-            false
-                                            )) {
-        CY_LOGD(TAG, "cy_rtos_put_queue(g_subscriber_task_q) failed!");
+    /* Handlers run on the subscriber task, so the LED is updated here. */
+    cyhal_gpio_write(CYBSP_USER_LED, device_state);
+    g_current_device_state = device_state;
+}
+
+/******************************************************************************
+ * Function Name: config_stream_handler
+ ******************************************************************************
+ * Summary:
+ *  Stream handler of 'MQTT_CONFIG_TOPIC'. It receives a configuration blob
+ *  streamed in chunks, and reports its size and CRC-32 once complete, the
+ *  same as printed by tools/stream_send. What the configuration holds is
+ *  up to the application; it would be parsed or stored here.
+ *
+ * Parameters:
+ *  const mqtt_stream_chunk_t *chunk : the next chunk, or the abort
+ *  void *arg : argument given at registration (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void config_stream_handler(const mqtt_stream_chunk_t *chunk, void *arg)
+{
+    (void) arg;
+
+    if (chunk->data == NULL) {
+        CY_LOGD(TAG, "Configuration %lu aborted at %lu of %lu bytes",
+                (unsigned long)chunk->stream_id,
+                (unsigned long)chunk->offset,
+                (unsigned long)chunk->total);
+        return;
+    }
+
+    if (chunk->offset == 0) {
+        s_config_crc = 0xFFFFFFFFu;
+    }
+
+    for (size_t i = 0; i < chunk->len; i++) {
+        s_config_crc ^= chunk->data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            s_config_crc = (s_config_crc >> 1) ^ (0xEDB88320u & (0u - (s_config_crc & 1u)));
+        }
+    }
+
+    if ((chunk->offset + chunk->len) == chunk->total) {
+        CY_LOGD(TAG, "Configuration %lu received: %lu bytes, CRC-32 0x%08lx",
+                (unsigned long)chunk->stream_id,
+                (unsigned long)chunk->total,
+                (unsigned long)(s_config_crc ^ 0xFFFFFFFFu));
     }
 }
 
@@ -217,8 +278,8 @@ void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
  * Function Name: unsubscribe_from_topic
  ******************************************************************************
  * Summary:
- *  Function that unsubscribes from the topic specified by the macro
- *  'MQTT_SUB_TOPIC'.
+ *  Function that unsubscribes from the topic filters registered in the
+ *  topic trie. The filters stay registered for the next subscription.
  *
  * Parameters:
  *  void
@@ -231,18 +292,62 @@ static void unsubscribe_from_topic(void)
 {
     CY_LOGD(TAG, "%s [%d]", __FUNCTION__, __LINE__);
 
-    cy_rslt_t result = cy_mqtt_unsubscribe(g_mqtt_connection,
-                                           (cy_mqtt_unsubscribe_info_t *) &s_subscribe_info,
-                                           SUBSCRIPTION_COUNT);
+    size_t count = mqtt_topic_trie_get_subscriptions(s_subscribe_info,
+                                                     MQTT_TOPIC_TRIE_MAX_FILTERS);
+
+    for (size_t first = 0; first < count; first += SUBSCRIPTION_CHUNK_SIZE) {
+        size_t chunk = count - first;
 
-    if (result != CY_RSLT_SUCCESS) {
-        CY_LOGD(TAG, "MQTT Unsubscribe operation failed with error 0x%0X!", (int)result);
+        if (chunk > SUBSCRIPTION_CHUNK_SIZE) {
+            chunk = SUBSCRIPTION_CHUNK_SIZE;
+        }
+
+        cy_rslt_t result = cy_mqtt_unsubscribe(g_mqtt_connection[MQTT_CONN_COMMAND],
+                                               (cy_mqtt_unsubscribe_info_t *) &s_subscribe_info[first],
+                                               (uint8_t)chunk);
+
+        if (result != CY_RSLT_SUCCESS) {
+            CY_LOGD(TAG, "MQTT Unsubscribe operation failed with error 0x%0X!", (int)result);
+        }
     }
 }
 
 
 /*-- Public Functions -------------------------------------------------*/
 
+/******************************************************************************
+ * Function Name: subscriber_init
+ ******************************************************************************
+ * Summary:
+ *  Function that creates the queue of the subscriber task and fills the
+ *  receive pool, once, before the first MQTT connection can feed them.
+ *  Neither is reset afterwards: messages queued while the task restarts
+ *  are handled by its next run.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS, or the error of cy_rtos_init_queue()
+ *
+ ******************************************************************************/
+cy_rslt_t subscriber_init(void)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if (g_subscriber_task_q == NULL) {
+        mqtt_rx_pool_init();
+        result = cy_rtos_init_queue(&g_subscriber_task_q,
+                                    SUBSCRIBER_TASK_QUEUE_LENGTH,
+                                    sizeof(subscriber_data_t));
+        if (result != CY_RSLT_SUCCESS) {
+            CY_LOGD(TAG, "cy_rtos_init_queue(g_subscriber_task_q) failed!");
+            g_subscriber_task_q = NULL;
+        }
+    }
+    return result;
+}
+
 /******************************************************************************
  * Function Name: subscriber_task
  ******************************************************************************
@@ -261,7 +366,7 @@ static void unsubscribe_from_topic(void)
  ******************************************************************************/
 void subscriber_task(cy_thread_arg_t pvParameters)
 {
-    subscriber_data_t subscriber_q_data;
+    uint32_t state;
 
     /* To avoid compiler warnings */
     (void) pvParameters;
@@ -270,26 +375,48 @@ void subscriber_task(cy_thread_arg_t pvParameters)
     cyhal_gpio_init(CYBSP_USER_LED, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_PULLUP,
                     CYBSP_LED_STATE_OFF);
 
-    /* Subscribe to the specified MQTT topic. */
-    subscribe_to_topic();
+    /* The queue is created by subscriber_init(), and what a previous run
+     * left in it is handled below. Only the message that run was handling
+     * when it was terminated is dropped, to reclaim its slab.
+     */
+    DEBUG_ASSERT(g_subscriber_task_q != NULL);
+    if ((s_q_data.cmd == HANDLE_MESSAGE) && (s_q_data.msg != NULL)) {
+        mqtt_rx_pool_free(s_q_data.msg);
+        s_q_data.msg = NULL;
+    }
 
-    /* Create a message queue to communicate with other tasks and callbacks. */
-    if (CY_RSLT_SUCCESS !=  cy_rtos_init_queue( &g_subscriber_task_q,
-            SUBSCRIBER_TASK_QUEUE_LENGTH,
-            sizeof(subscriber_data_t)
-                                              )) {
-        CY_LOGD(TAG, "cy_rtos_init_queue(g_subscriber_task_q) failed!");
+    /* Route the messages on MQTT_SUB_TOPIC to the device state handler.
+     * Other modules register their own filters in the same topic trie.
+     */
+    if ((CY_RSLT_SUCCESS != mqtt_topic_trie_init()) ||
+        (CY_RSLT_SUCCESS != mqtt_topic_trie_add(MQTT_SUB_TOPIC,
+                                                (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
+                                                device_state_handler,
+                                                NULL))) {
+        CY_LOGD(TAG, "mqtt_topic_trie_add(MQTT_SUB_TOPIC) failed!");
         DEBUG_ASSERT(0);
     }
 
+    /* Configuration blobs larger than a message arrive as a stream. */
+    if (CY_RSLT_SUCCESS != mqtt_stream_register(MQTT_CONFIG_TOPIC,
+                                                (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
+                                                config_stream_handler,
+                                                NULL)) {
+        CY_LOGD(TAG, "mqtt_stream_register(MQTT_CONFIG_TOPIC) failed!");
+    }
+
+    /* Subscribe to the registered MQTT topics. */
+    subscribe_to_topic();
+    mqtt_subscribed();
+
     while (true) {
         /* Wait for commands from other tasks and callbacks. */
         if (CY_RSLT_SUCCESS == cy_rtos_get_queue(  &g_subscriber_task_q,
-                (void *)&subscriber_q_data,
+                (void *)&s_q_data,
                 CY_RTOS_NEVER_TIMEOUT,
                 false))
         {
-            switch(subscriber_q_data.cmd) {
+            switch(s_q_data.cmd) {
                 case SUBSCRIBE_TO_TOPIC: {
                     subscribe_to_topic();
                     break;
@@ -300,12 +427,28 @@ void subscriber_task(cy_thread_arg_t pvParameters)
                     break;
                 }
 
+                case HANDLE_MESSAGE: {
+                    /* Run the handlers of the received message here, not
+                     * on the MQTT library thread.
+                     */
+                    (void) mqtt_topic_trie_dispatch(&s_q_data.msg->info);
+
+                    /* Freed and forgotten at once, so that a termination
+                     * cannot come in between.
+                     */
+                    state = cyhal_system_critical_section_enter();
+                    mqtt_rx_pool_free(s_q_data.msg);
+                    s_q_data.msg = NULL;
+                    cyhal_system_critical_section_exit(state);
+                    break;
+                }
+
                 case UPDATE_DEVICE_STATE: {
                     /* Update the LED state as per received notification. */
-                    cyhal_gpio_write(CYBSP_USER_LED, subscriber_q_data.data);
+                    cyhal_gpio_write(CYBSP_USER_LED, s_q_data.data);
 
                     /* Update the current device state extern variable. */
-                    g_current_device_state = subscriber_q_data.data;
+                    g_current_device_state = s_q_data.data;
                     break;
                 }
             }
@@ -313,4 +456,89 @@ void subscriber_task(cy_thread_arg_t pvParameters)
     }
 }
 
+/******************************************************************************
+ * Function Name: subscriber_post_message
+ ******************************************************************************
+ * Summary:
+ *  Function called on the MQTT library thread for each received message.
+ *  The message is copied into a slab of the receive pool and queued for
+ *  the subscriber task without blocking, so that slow handlers cannot
+ *  stall the MQTT receive path. When no slab or queue entry is free, the
+ *  message is dropped and counted.
+ *
+ * Parameters:
+ *  const cy_mqtt_publish_info_t *received_msg_info : Information structure
+ *                                                    of the received MQTT message
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void subscriber_post_message(const cy_mqtt_publish_info_t *received_msg_info)
+{
+    subscriber_data_t subscriber_q_data;
+
+    if (g_subscriber_task_q == NULL) {
+        return;
+    }
+
+    subscriber_q_data.cmd = HANDLE_MESSAGE;
+    subscriber_q_data.msg = mqtt_rx_pool_copy(received_msg_info);
+
+    if (subscriber_q_data.msg == NULL) {
+        return;
+    }
+
+    if (CY_RSLT_SUCCESS != cy_rtos_put_queue(&g_subscriber_task_q,
+            (void *)&subscriber_q_data,
+            0,
+            false
+                                            )) {
+        mqtt_rx_pool_free(subscriber_q_data.msg);
+        s_rx_queue_full++;
+    }
+}
+
+/******************************************************************************
+ * Function Name: subscriber_print_stats
+ ******************************************************************************
+ * Summary:
+ *  Function that prints the receive pool usage and the dropped messages.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void subscriber_print_stats(void)
+{
+    mqtt_rx_pool_stats_t stats;
+    mqtt_stream_stats_t stream_stats;
+
+    mqtt_rx_pool_get_stats(&stats);
+    mqtt_stream_get_stats(&stream_stats);
+
+    PRINT_MSG(("subscriber: received=%lu slabs=%u/%u peak=%u "
+               "dropped_no_slab=%lu dropped_too_big=%lu dropped_queue_full=%lu\n",
+               (unsigned long)stats.copied,
+               (unsigned int)stats.in_use,
+               (unsigned int)MQTT_RX_SLAB_COUNT,
+               (unsigned int)stats.peak_in_use,
+               (unsigned long)stats.no_slab,
+               (unsigned long)stats.too_big,
+               (unsigned long)s_rx_queue_full));
+    PRINT_MSG(("subscriber: largest message=%lu (slab %u, network buffer %u)\n",
+               (unsigned long)stats.largest,
+               (unsigned int)MQTT_RX_SLAB_SIZE,
+               (unsigned int)MQTT_NETWORK_BUFFER_SIZE));
+    PRINT_MSG(("streams: chunks=%lu completed=%lu aborted=%lu duplicates=%lu ignored=%lu\n",
+               (unsigned long)stream_stats.chunks,
+               (unsigned long)stream_stats.completed,
+               (unsigned long)stream_stats.aborted,
+               (unsigned long)stream_stats.duplicates,
+               (unsigned long)stream_stats.ignored));
+}
+
 /* [] END OF FILE */
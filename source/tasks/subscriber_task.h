@@ -47,6 +47,7 @@
 
 #include "cyabs_rtos.h"
 #include "cy_mqtt_api.h"
+#include "mqtt_rx_pool.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -72,13 +73,15 @@ extern "C"
 typedef enum {
     SUBSCRIBE_TO_TOPIC,
     UNSUBSCRIBE_FROM_TOPIC,
-    UPDATE_DEVICE_STATE
+    UPDATE_DEVICE_STATE,
+    HANDLE_MESSAGE
 } subscriber_cmd_t;
 
 /* Struct to be passed via the subscriber task queue */
 typedef struct {
     subscriber_cmd_t cmd;
     uint8_t data;
+    mqtt_rx_msg_t *msg;     /* HANDLE_MESSAGE, freed by the subscriber task */
 } subscriber_data_t;
 
 /*******************************************************************************
@@ -91,8 +94,10 @@ extern uint32_t g_current_device_state;
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
+cy_rslt_t subscriber_init(void);
 void subscriber_task(cy_thread_arg_t pvParameters);
-void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info);
+void subscriber_post_message(const cy_mqtt_publish_info_t *received_msg_info);
+void subscriber_print_stats(void);
 
 #ifdef __cplusplus
 }
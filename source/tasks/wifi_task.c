@@ -43,8 +43,10 @@
 
 #include "wifi_task.h"
 #include "common_task.h"
+#include "link_events.h"
 
 #include "cy_notification.h"
+#include "fake_io.h"
 
 #include <lwip/api.h>     /* for netconn_gethostbyname */
 #include <lwip/dns.h>     /* for dns_getserver/dns_setserver */
@@ -84,6 +86,12 @@ static common_status_t s_wifi_status = COMMON_STATUS_STOPPED;
 /*-- Local Functions -------------------------------------------------*/
 
 #if (FEATURE_WIFI == ENABLE_FEATURE)
+static void wifi_set_status(common_status_t status)
+{
+    s_wifi_status = status;
+    link_events_publish(WIFI_STA_CONNECTIVITY, LINK_EVENT_STATUS, status);
+}
+
 /* WIFI SSID and Password defined in wifi_config.h */
 static cy_rslt_t connect_to_wifi_ap(void)
 {
@@ -192,16 +200,20 @@ void wifi_task(cy_thread_arg_t arg)
         /* Notification values received from other tasks */
         uint32_t ulNotifiedValue;
 
-        s_wifi_status = COMMON_STATUS_STARTING;
+        wifi_set_status(COMMON_STATUS_STARTING);
 
         if (connect_to_wifi_ap() != CY_RSLT_SUCCESS ) {
             CY_LOGD(TAG, "\nFailed to connect to Wi-FI AP.");
             s_wifi_connected = false;
-            s_wifi_status = COMMON_STATUS_FAILED_TO_START;
+            wifi_set_status(COMMON_STATUS_FAILED_TO_START);
 
         } else {
             s_wifi_connected = true;
-            s_wifi_status = COMMON_STATUS_STARTED;
+            wifi_set_status(COMMON_STATUS_STARTED);
+
+            /* e.g. lets a waiting MQTT reconnection proceed at once */
+            link_events_publish(WIFI_STA_CONNECTIVITY, LINK_EVENT_IP_UP, s_wifi_status);
+            link_events_publish(WIFI_STA_CONNECTIVITY, LINK_EVENT_DNS_CHANGED, s_wifi_status);
         }
 
         do {
@@ -231,7 +243,7 @@ void wifi_task(cy_thread_arg_t arg)
                        (NOTIF_SHUTDOWN_IO == ulNotifiedValue)) {
 
                 if (s_wifi_connected) {
-                    s_wifi_status = COMMON_STATUS_STOPPING;
+                    wifi_set_status(COMMON_STATUS_STOPPING);
 
                     result = cy_wcm_disconnect_ap();
                     if (result != CY_RSLT_SUCCESS) {
@@ -245,7 +257,8 @@ void wifi_task(cy_thread_arg_t arg)
                     memset(&s_wifi_ip_addr, 0, sizeof(s_wifi_ip_addr));
                     memset(&s_wifi_dns_addr, 0, sizeof(s_wifi_dns_addr));
 
-                    s_wifi_status = COMMON_STATUS_STOPPED;
+                    link_events_publish(WIFI_STA_CONNECTIVITY, LINK_EVENT_IP_DOWN, s_wifi_status);
+                    wifi_set_status(COMMON_STATUS_STOPPED);
 
                 } else {
                     CY_LOGD(TAG, "Wi-Fi already stopped");
@@ -292,6 +305,12 @@ bool is_wifi_connected(void)
     return s_wifi_connected && cy_wcm_is_connected_to_ap();
 }
 
+bool is_wifi_down(void)
+{
+    return (s_wifi_status == COMMON_STATUS_FAILED_TO_START) ||
+           ((s_wifi_status == COMMON_STATUS_STARTED) && !is_wifi_connected());
+}
+
 const ip_addr_t* get_wifi_dns_address(void)
 {
     return &s_wifi_dns_addr;
@@ -80,6 +80,9 @@ bool is_wcm_initialized(void);
 
 bool is_wifi_connected(void);
 
+/* Failed to start, or lost the AP; false once stopped on purpose */
+bool is_wifi_down(void);
+
 const ip_addr_t* get_wifi_dns_address(void);
 
 const cy_wcm_ip_address_t* get_wifi_ip_address(void);
@@ -0,0 +1,110 @@
+/******************************************************************************
+* File Name:   spsc_ring.c
+*
+* Description: This file implements a lock-free single-producer single-consumer
+*              ring, e.g. to hand events from an ISR to a task
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cyhal.h"
+
+#include "spsc_ring.h"
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+bool spsc_ring_init(spsc_ring_t *ring,
+                    void *storage,
+                    size_t elem_size,
+                    uint32_t capacity)
+{
+    if ((ring == NULL) || (storage == NULL) || (elem_size == 0) ||
+        (capacity == 0) || ((capacity & (capacity - 1u)) != 0)) {
+        return false;
+    }
+
+    ring->storage = (uint8_t *)storage;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1u;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    return true;
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *elem)
+{
+    uint32_t tail = ring->tail;
+
+    if ((tail - ring->head) > ring->mask) {
+        ring->dropped++;
+        return false;
+    }
+
+    memcpy(&ring->storage[(tail & ring->mask) * ring->elem_size], elem, ring->elem_size);
+
+    /* The element must be written before the consumer can see it */
+    __DMB();
+    ring->tail = tail + 1u;
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *elem)
+{
+    uint32_t head = ring->head;
+
+    if (ring->tail == head) {
+        return false;
+    }
+
+    /* Read the element only after the index that published it */
+    __DMB();
+    memcpy(elem, &ring->storage[(head & ring->mask) * ring->elem_size], ring->elem_size);
+
+    /* ... and finish reading it before the producer may reuse the slot */
+    __DMB();
+    ring->head = head + 1u;
+    return true;
+}
+
+uint32_t spsc_ring_count(const spsc_ring_t *ring)
+{
+    return ring->tail - ring->head;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+/******************************************************************************
+* File Name:   spsc_ring.h
+*
+* Description: This file is the public interface of spsc_ring.c
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SOURCE_SPSC_RING_H_
+#define SOURCE_SPSC_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*-- Public Definitions -------------------------------------------------*/
+
+/* Fixed-size elements, copied in and out. One context pushes (e.g. an ISR,
+ * or several ISRs of one interrupt priority, which cannot preempt each
+ * other) and one task pops; neither takes a lock or masks interrupts.
+ * The indices run freely and wrap at 2^32.
+ */
+typedef struct {
+    uint8_t *storage;
+    size_t elem_size;
+    uint32_t mask;              /* capacity - 1 */
+    volatile uint32_t head;     /* next to pop, written by the consumer */
+    volatile uint32_t tail;     /* next to push, written by the producer */
+    volatile uint32_t dropped;  /* pushes to a full ring, by the producer */
+} spsc_ring_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+/* 'storage' holds 'capacity' elements; 'capacity' is a power of two */
+bool spsc_ring_init(spsc_ring_t *ring,
+                    void *storage,
+                    size_t elem_size,
+                    uint32_t capacity);
+
+/* Producer side. Fails, and counts the element as dropped, when full. */
+bool spsc_ring_push(spsc_ring_t *ring, const void *elem);
+
+/* Consumer side */
+bool spsc_ring_pop(spsc_ring_t *ring, void *elem);
+
+uint32_t spsc_ring_count(const spsc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCE_SPSC_RING_H_ */
+
+/* [] END OF FILE */
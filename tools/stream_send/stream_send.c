@@ -0,0 +1,194 @@
+/******************************************************************************
+* File Name:   stream_send.c
+*
+* Description: Host tool that splits a file into the chunk messages of a stream
+*              (see mqtt_stream.h), to publish them with an MQTT client
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/* Build on the host, from this directory:
+ *   gcc -O2 -o stream_send stream_send.c
+ *
+ * Usage:
+ *   stream_send [-s chunk_size] [-i stream_id] file outdir
+ *
+ * Writes the chunk messages of 'file' to outdir/chunk_0000.bin and on, and
+ * prints the size and CRC-32 that the device reports once it has received
+ * the whole stream. The chunks are then published in order, with QoS 1,
+ * on the topic of the stream (MQTT_CONFIG_TOPIC for the configuration):
+ *   for f in outdir/chunk_*.bin; do
+ *       mosquitto_pub -h <broker> -t ledstatus/config -q 1 -f "$f"
+ *   done
+ * A chunk message, topic included, must fit in MQTT_RX_SLAB_SIZE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+/* Chunk header of mqtt_stream.h: stream ID, offset and total size, each a
+ * big-endian uint32_t
+ */
+#define MQTT_STREAM_HEADER_SIZE (12u)
+
+#define FILE_MAX_SIZE           (1024u * 1024u)
+
+/* Fits the default MQTT_RX_SLAB_SIZE of 256 bytes with a short topic */
+#define DEFAULT_CHUNK_SIZE      (200u)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static uint8_t s_file[FILE_MAX_SIZE];
+static uint8_t s_chunk[MQTT_STREAM_HEADER_SIZE + FILE_MAX_SIZE];
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void put_be32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+/* CRC-32 (IEEE 802.3), as computed by the configuration handler */
+static uint32_t crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: stream_send [-s chunk_size] [-i stream_id] file outdir\n");
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    unsigned long chunk_size = DEFAULT_CHUNK_SIZE;
+    uint32_t stream_id = (uint32_t)time(NULL);
+    const char *path;
+    const char *outdir;
+    FILE *file;
+    size_t len;
+    uint32_t count = 0;
+    int arg = 1;
+
+    while ((arg + 1 < argc) && (argv[arg][0] == '-')) {
+        if (strcmp(argv[arg], "-s") == 0) {
+            chunk_size = strtoul(argv[arg + 1], NULL, 0);
+        } else if (strcmp(argv[arg], "-i") == 0) {
+            stream_id = (uint32_t)strtoul(argv[arg + 1], NULL, 0);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+        arg += 2;
+    }
+
+    if ((argc - arg != 2) || (chunk_size == 0) || (chunk_size > FILE_MAX_SIZE)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    path = argv[arg];
+    outdir = argv[arg + 1];
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    len = fread(s_file, 1, sizeof(s_file), file);
+    if (!feof(file)) {
+        fprintf(stderr, "%s: larger than %u bytes\n", path, (unsigned int)FILE_MAX_SIZE);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    fclose(file);
+
+    /* An empty file is still one chunk, so that the stream completes. */
+    for (size_t offset = 0; (offset < len) || (count == 0); offset += chunk_size) {
+        size_t part = len - offset;
+        char name[1024];
+        FILE *out;
+
+        if (part > chunk_size) {
+            part = chunk_size;
+        }
+
+        put_be32(&s_chunk[0], stream_id);
+        put_be32(&s_chunk[4], (uint32_t)offset);
+        put_be32(&s_chunk[8], (uint32_t)len);
+        memcpy(&s_chunk[MQTT_STREAM_HEADER_SIZE], &s_file[offset], part);
+
+        snprintf(name, sizeof(name), "%s/chunk_%04lu.bin", outdir, (unsigned long)count);
+        out = fopen(name, "wb");
+        if ((out == NULL) ||
+            (fwrite(s_chunk, 1, MQTT_STREAM_HEADER_SIZE + part, out) != (MQTT_STREAM_HEADER_SIZE + part))) {
+            perror(name);
+            if (out != NULL) {
+                fclose(out);
+            }
+            return EXIT_FAILURE;
+        }
+        fclose(out);
+        count++;
+    }
+
+    printf("stream %lu: %lu bytes in %lu chunks, CRC-32 0x%08lx\n",
+           (unsigned long)stream_id, (unsigned long)len,
+           (unsigned long)count, (unsigned long)crc32(s_file, len));
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
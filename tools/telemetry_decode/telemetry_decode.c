@@ -0,0 +1,129 @@
+/******************************************************************************
+* File Name:   telemetry_decode.c
+*
+* Description: Host tool that decodes telemetry frames (see mqtt_telemetry.h)
+*              and prints their samples as CSV
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/* Build on the host, from this directory:
+ *   gcc -O2 -I../../source/mqtt -o telemetry_decode \
+ *       telemetry_decode.c ../../source/mqtt/mqtt_telemetry.c
+ *
+ * Usage:
+ *   telemetry_decode [frame.bin]     (reads stdin without a file)
+ *
+ * One frame per run, e.g. captured with
+ *   mosquitto_sub -h <broker> -t <topic> -C 1 -N > frame.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mqtt_telemetry.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define FRAME_MAX_SIZE      (64u * 1024u)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static uint8_t s_frame[FRAME_MAX_SIZE];
+static uint8_t s_scratch[FRAME_MAX_SIZE];
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void print_sample(const mqtt_telemetry_header_t *header,
+                         uint32_t time_ms,
+                         const int32_t *values,
+                         void *arg)
+{
+    (void) arg;
+
+    printf("%lu", (unsigned long)time_ms);
+    for (uint8_t f = 0; f < header->field_count; f++) {
+        printf(",%ld", (long)values[f]);
+    }
+    printf("\n");
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    FILE *file = stdin;
+    size_t len;
+    int32_t count;
+
+    if (argc > 1) {
+        file = fopen(argv[1], "rb");
+        if (file == NULL) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    len = fread(s_frame, 1, sizeof(s_frame), file);
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    printf("# schema=%u version=%u fields=%u%s\n",
+           (len > 1) ? s_frame[1] : 0u,
+           (len > 2) ? s_frame[2] : 0u,
+           (len > 3) ? s_frame[3] : 0u,
+           ((len > 0) && (s_frame[0] & MQTT_TELEMETRY_FLAG_COMPRESSED)) ? " compressed" : "");
+    printf("time_ms,values...\n");
+
+    count = mqtt_telemetry_decode(s_frame, len, s_scratch, sizeof(s_scratch),
+                                  print_sample, NULL);
+    if (count < 0) {
+        fprintf(stderr, "malformed frame (%lu bytes)\n", (unsigned long)len);
+        return EXIT_FAILURE;
+    }
+
+    if (count > 0) {
+        printf("# %ld samples in %lu bytes, %.2f bytes/sample\n",
+               (long)count, (unsigned long)len, (double)len / (double)count);
+    }
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,195 @@
+/******************************************************************************
+* File Name:   host_shim.c
+*
+* Description: Host implementation of the RTOS and HAL stand-ins in this directory
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <assert.h>
+
+#include "cyabs_rtos.h"
+#include "cyhal.h"
+#include "task.h"
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static cy_time_t s_now_ms = 0;
+static uint32_t s_critical_depth = 0;
+
+/* Handle of the one task, the test */
+static int s_test_task;
+static uint32_t s_notify_count = 0;
+static uint32_t s_notifications_given = 0;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore,
+                                 uint32_t max_count,
+                                 uint32_t init_count)
+{
+    semaphore->count = init_count;
+    semaphore->max_count = max_count;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore,
+                                cy_time_t timeout_ms,
+                                bool in_isr)
+{
+    (void)in_isr;
+
+    if (semaphore->count > 0) {
+        semaphore->count--;
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Nothing else runs: a wait without a timeout would never end */
+    assert(timeout_ms != CY_RTOS_NEVER_TIMEOUT);
+    s_now_ms += timeout_ms;
+    return CY_RTOS_TIMEOUT;
+}
+
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore,
+                                bool in_isr)
+{
+    (void)in_isr;
+
+    if (semaphore->count < semaphore->max_count) {
+        semaphore->count++;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore)
+{
+    semaphore->count = 0;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex)
+{
+    mutex->locked = false;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex,
+                            cy_time_t timeout_ms)
+{
+    (void)timeout_ms;
+
+    assert(!mutex->locked);
+    mutex->locked = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    assert(mutex->locked);
+    mutex->locked = false;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval)
+{
+    *tval = s_now_ms;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms)
+{
+    s_now_ms += num_ms;
+    return CY_RSLT_SUCCESS;
+}
+
+void host_shim_advance_time(cy_time_t num_ms)
+{
+    s_now_ms += num_ms;
+}
+
+uint32_t cyhal_system_critical_section_enter(void)
+{
+    return s_critical_depth++;
+}
+
+void cyhal_system_critical_section_exit(uint32_t old_state)
+{
+    assert(s_critical_depth == (old_state + 1u));
+    s_critical_depth = old_state;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &s_test_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    s_notifications_given++;
+    if (task == &s_test_task) {
+        s_notify_count++;
+    }
+    return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    (void) xTaskNotifyGive(task);
+    *higher_priority_task_woken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    uint32_t count = s_notify_count;
+
+    if (count > 0) {
+        s_notify_count = (clear_count_on_exit != pdFALSE) ? 0 : (count - 1u);
+        return count;
+    }
+
+    /* Nothing else runs: a wait without a timeout would never end */
+    assert(ticks_to_wait != portMAX_DELAY);
+    s_now_ms += ticks_to_wait;
+    return 0;
+}
+
+uint32_t host_shim_notifications_given(void)
+{
+    return s_notifications_given;
+}
+
+/* [] END OF FILE */
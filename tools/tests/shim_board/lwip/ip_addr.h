@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name:   ip_addr.h
+*
+* Description: Host stand-in for the lwIP addresses used by the link manager, for its
+*              compile check in tools/tests
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef HOST_SHIM_LWIP_IP_ADDR_H_
+#define HOST_SHIM_LWIP_IP_ADDR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int8_t err_t;
+#define ERR_OK                      (0)
+
+typedef struct
+{
+    uint32_t addr;
+} ip4_addr_t;
+
+typedef struct
+{
+    union
+    {
+        ip4_addr_t ip4;
+        uint32_t ip6[4];
+    } u_addr;
+    uint8_t type;
+} ip_addr_t;
+
+#define IPADDR_TYPE_V4              (0u)
+
+#define IP_IS_V4(a)                 ((a)->type == IPADDR_TYPE_V4)
+#define ip_2_ip4(a)                 (&(a)->u_addr.ip4)
+#define ip4_addr_get_u32(a)         ((a)->addr)
+#define ip_addr_isany(a)            (((a) == NULL) || ((a)->u_addr.ip4.addr == 0))
+
+int ipaddr_aton(const char *cp, ip_addr_t *addr);
+char *ipaddr_ntoa(const ip_addr_t *addr);
+
+#endif /* HOST_SHIM_LWIP_IP_ADDR_H_ */
+
+/* [] END OF FILE */
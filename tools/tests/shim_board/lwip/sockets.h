@@ -0,0 +1,97 @@
+/******************************************************************************
+* File Name:   sockets.h
+*
+* Description: Host stand-in for the lwIP sockets used by the link manager, for its
+*              compile check in tools/tests. Declarations only: nothing is linked.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef HOST_SHIM_LWIP_SOCKETS_H_
+#define HOST_SHIM_LWIP_SOCKETS_H_
+
+#include <stdint.h>
+#include <sys/select.h>     /* for fd_set and struct timeval */
+
+#include "lwip/ip_addr.h"
+
+typedef uint32_t socklen_t;
+
+struct sockaddr
+{
+    uint8_t sa_len;
+    uint8_t sa_family;
+    char sa_data[14];
+};
+
+struct in_addr
+{
+    uint32_t s_addr;
+};
+
+struct sockaddr_in
+{
+    uint8_t sin_len;
+    uint8_t sin_family;
+    uint16_t sin_port;
+    struct in_addr sin_addr;
+    char sin_zero[8];
+};
+
+struct ifreq
+{
+    char ifr_name[6];
+};
+
+#define AF_INET                     (2)
+#define SOCK_STREAM                 (1)
+#define IPPROTO_TCP                 (6)
+#define SOL_SOCKET                  (0xfff)
+#define SO_ERROR                    (0x1007)
+#define SO_BINDTODEVICE             (0x100b)
+#define F_SETFL                     (4)
+#define O_NONBLOCK                  (1)
+
+int socket(int domain, int type, int protocol);
+int closesocket(int s);
+int connect(int s, const struct sockaddr *name, socklen_t namelen);
+int setsockopt(int s, int level, int optname, const void *optval, socklen_t optlen);
+int getsockopt(int s, int level, int optname, void *optval, socklen_t *optlen);
+int fcntl(int s, int cmd, int val);
+uint16_t htons(uint16_t n);
+
+#endif /* HOST_SHIM_LWIP_SOCKETS_H_ */
+
+/* [] END OF FILE */
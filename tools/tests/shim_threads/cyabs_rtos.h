@@ -0,0 +1,126 @@
+/******************************************************************************
+* File Name:   cyabs_rtos.h
+*
+* Description: Host stand-in for the abstraction-rtos API on POSIX threads, for
+*              the unit tests in tools/tests that run tasks of their own.
+*              Semaphores, mutexes and the clock are real.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef HOST_SHIM_THREADS_CYABS_RTOS_H_
+#define HOST_SHIM_THREADS_CYABS_RTOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "cy_result.h"
+
+/*-- Public Definitions -------------------------------------------------*/
+
+#define CY_RTOS_NEVER_TIMEOUT   (0xFFFFFFFFu)
+#define CY_RTOS_TIMEOUT         (0x1u)
+#define CY_RTOS_GENERAL_ERROR   (0x2u)
+
+typedef enum
+{
+    CY_RTOS_PRIORITY_MIN,
+    CY_RTOS_PRIORITY_LOW,
+    CY_RTOS_PRIORITY_BELOWNORMAL,
+    CY_RTOS_PRIORITY_NORMAL,
+    CY_RTOS_PRIORITY_ABOVENORMAL,
+    CY_RTOS_PRIORITY_HIGH,
+    CY_RTOS_PRIORITY_REALTIME,
+    CY_RTOS_PRIORITY_MAX
+} cy_thread_priority_t;
+
+typedef uint32_t cy_time_t;
+typedef pthread_t cy_thread_t;
+typedef void *cy_thread_arg_t;
+typedef void (*cy_thread_entry_fn_t)(cy_thread_arg_t arg);
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+    uint32_t max_count;
+} cy_semaphore_t;
+
+typedef pthread_mutex_t cy_mutex_t;
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore,
+                                 uint32_t max_count,
+                                 uint32_t init_count);
+
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore,
+                                cy_time_t timeout_ms,
+                                bool in_isr);
+
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore,
+                                bool in_isr);
+
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore);
+
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex);
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex,
+                            cy_time_t timeout_ms);
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex);
+
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex);
+
+/* The thread is detached; the stack and priority are ignored */
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread,
+                                cy_thread_entry_fn_t entry_function,
+                                const char *name,
+                                void *stack,
+                                uint32_t stack_size,
+                                cy_thread_priority_t priority,
+                                cy_thread_arg_t arg);
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval);
+
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms);
+
+#endif /* HOST_SHIM_THREADS_CYABS_RTOS_H_ */
+
+/* [] END OF FILE */
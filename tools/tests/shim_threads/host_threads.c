@@ -0,0 +1,242 @@
+/******************************************************************************
+* File Name:   host_threads.c
+*
+* Description: Host implementation of the threaded RTOS stand-in in this
+*              directory, and of the HAL critical sections.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cyabs_rtos.h"
+#include "cyhal.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+typedef struct
+{
+    cy_thread_entry_fn_t entry_function;
+    cy_thread_arg_t arg;
+} host_thread_start_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+/* Stands in for the interrupt lock of the critical sections, which the
+ * modules under test do not nest
+ */
+static pthread_mutex_t s_critical = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void *host_thread_main(void *arg)
+{
+    host_thread_start_t start = *(host_thread_start_t *)arg;
+
+    free(arg);
+    start.entry_function(start.arg);
+    return NULL;
+}
+
+static void host_deadline(struct timespec *deadline, cy_time_t timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000u;
+    deadline->tv_nsec += (long)(timeout_ms % 1000u) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore,
+                                 uint32_t max_count,
+                                 uint32_t init_count)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&semaphore->lock, NULL);
+    pthread_cond_init(&semaphore->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    semaphore->count = init_count;
+    semaphore->max_count = max_count;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore,
+                                cy_time_t timeout_ms,
+                                bool in_isr)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    struct timespec deadline;
+
+    (void)in_isr;
+
+    host_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&semaphore->lock);
+    while ((semaphore->count == 0) && (result == CY_RSLT_SUCCESS)) {
+        if (timeout_ms == CY_RTOS_NEVER_TIMEOUT) {
+            pthread_cond_wait(&semaphore->cond, &semaphore->lock);
+        } else if (pthread_cond_timedwait(&semaphore->cond, &semaphore->lock,
+                                          &deadline) == ETIMEDOUT) {
+            result = CY_RTOS_TIMEOUT;
+        }
+    }
+    if (semaphore->count > 0) {
+        semaphore->count--;
+        result = CY_RSLT_SUCCESS;
+    }
+    pthread_mutex_unlock(&semaphore->lock);
+    return result;
+}
+
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore,
+                                bool in_isr)
+{
+    (void)in_isr;
+
+    pthread_mutex_lock(&semaphore->lock);
+    if (semaphore->count < semaphore->max_count) {
+        semaphore->count++;
+        pthread_cond_signal(&semaphore->cond);
+    }
+    pthread_mutex_unlock(&semaphore->lock);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore)
+{
+    pthread_cond_destroy(&semaphore->cond);
+    pthread_mutex_destroy(&semaphore->lock);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex)
+{
+    return (pthread_mutex_init(mutex, NULL) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_GENERAL_ERROR;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex,
+                            cy_time_t timeout_ms)
+{
+    (void)timeout_ms;
+
+    return (pthread_mutex_lock(mutex) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_GENERAL_ERROR;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    return (pthread_mutex_unlock(mutex) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_GENERAL_ERROR;
+}
+
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex)
+{
+    return (pthread_mutex_destroy(mutex) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_GENERAL_ERROR;
+}
+
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread,
+                                cy_thread_entry_fn_t entry_function,
+                                const char *name,
+                                void *stack,
+                                uint32_t stack_size,
+                                cy_thread_priority_t priority,
+                                cy_thread_arg_t arg)
+{
+    host_thread_start_t *start = malloc(sizeof(*start));
+
+    (void)name;
+    (void)stack;
+    (void)stack_size;
+    (void)priority;
+
+    if (start == NULL) {
+        return CY_RTOS_GENERAL_ERROR;
+    }
+    start->entry_function = entry_function;
+    start->arg = arg;
+
+    if (pthread_create(thread, NULL, host_thread_main, start) != 0) {
+        free(start);
+        return CY_RTOS_GENERAL_ERROR;
+    }
+    pthread_detach(*thread);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *tval = (cy_time_t)((uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms)
+{
+    struct timespec delay;
+
+    delay.tv_sec = num_ms / 1000u;
+    delay.tv_nsec = (long)(num_ms % 1000u) * 1000000L;
+    while (nanosleep(&delay, &delay) != 0) {
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+uint32_t cyhal_system_critical_section_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+    return 0;
+}
+
+void cyhal_system_critical_section_exit(uint32_t old_state)
+{
+    (void)old_state;
+    pthread_mutex_unlock(&s_critical);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,258 @@
+/******************************************************************************
+* File Name:   test_mqtt_telemetry.c
+*
+* Description: Host unit tests of the telemetry frame encoder, compressor and
+*              decoder (source/mqtt/mqtt_telemetry.c)
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "mqtt_telemetry.h"
+
+#include "test_util.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define TEST_FIELDS         (3u)
+#define TEST_SAMPLES        (64u)
+#define TEST_FRAME_SIZE     (2048u)
+
+typedef struct {
+    uint32_t count;
+    uint32_t time_ms[TEST_SAMPLES];
+    int32_t values[TEST_SAMPLES][TEST_FIELDS];
+} test_samples_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static const mqtt_telemetry_field_t s_fields[TEST_FIELDS] = {
+    { "temperature", 2 },
+    { "humidity", 1 },
+    { "pressure", 0 },
+};
+
+static const mqtt_telemetry_schema_t s_schema = {
+    .id = 7,
+    .version = 2,
+    .field_count = TEST_FIELDS,
+    .fields = s_fields,
+};
+
+static test_samples_t s_sent;
+static test_samples_t s_received;
+
+static uint8_t s_frame[TEST_FRAME_SIZE];
+static uint8_t s_compressed[TEST_FRAME_SIZE];
+static uint8_t s_scratch[TEST_FRAME_SIZE];
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static void test_collect(const mqtt_telemetry_header_t *header,
+                         uint32_t time_ms,
+                         const int32_t *values,
+                         void *arg)
+{
+    test_samples_t *samples = (test_samples_t *)arg;
+
+    CHECK_EQ(header->schema_id, s_schema.id);
+    CHECK_EQ(header->schema_version, s_schema.version);
+    CHECK_EQ(header->field_count, TEST_FIELDS);
+
+    if (samples->count < TEST_SAMPLES) {
+        samples->time_ms[samples->count] = time_ms;
+        memcpy(samples->values[samples->count], values, sizeof(samples->values[0]));
+    }
+    samples->count++;
+}
+
+/* Slowly varying readings at an uneven period, as a sensor gives them */
+static void test_make_samples(uint32_t count)
+{
+    memset(&s_sent, 0, sizeof(s_sent));
+
+    for (uint32_t i = 0; i < count; i++) {
+        s_sent.time_ms[i] = 100000u + (i * 1000u) + ((i % 3u) * 7u);
+        s_sent.values[i][0] = -1250 + (int32_t)(i % 5u);
+        s_sent.values[i][1] = 455 - (int32_t)(i / 8u);
+        s_sent.values[i][2] = 101325;
+    }
+    s_sent.count = count;
+}
+
+static size_t test_encode(uint32_t count)
+{
+    mqtt_telemetry_encoder_t encoder;
+
+    CHECK(mqtt_telemetry_begin(&encoder, &s_schema, s_frame, sizeof(s_frame), s_sent.time_ms[0]));
+    for (uint32_t i = 0; i < count; i++) {
+        CHECK(mqtt_telemetry_add(&encoder, s_sent.time_ms[i], s_sent.values[i]));
+    }
+    return mqtt_telemetry_length(&encoder);
+}
+
+static void test_check_received(void)
+{
+    CHECK_EQ(s_received.count, s_sent.count);
+    for (uint32_t i = 0; (i < s_sent.count) && (i < s_received.count); i++) {
+        CHECK_EQ(s_received.time_ms[i], s_sent.time_ms[i]);
+        for (uint32_t f = 0; f < TEST_FIELDS; f++) {
+            CHECK_EQ(s_received.values[i][f], s_sent.values[i][f]);
+        }
+    }
+}
+
+
+/*-- Tests -------------------------------------------------*/
+
+static void test_round_trip(void)
+{
+    size_t len;
+
+    test_make_samples(TEST_SAMPLES);
+    len = test_encode(TEST_SAMPLES);
+
+    /* The changes take a few bytes per sample */
+    CHECK(len < (TEST_SAMPLES * 6u));
+
+    memset(&s_received, 0, sizeof(s_received));
+    CHECK_EQ(mqtt_telemetry_decode(s_frame, len, NULL, 0, test_collect, &s_received), TEST_SAMPLES);
+    test_check_received();
+}
+
+static void test_compressed_round_trip(void)
+{
+    size_t len;
+    size_t compressed_len;
+
+    test_make_samples(TEST_SAMPLES);
+    len = test_encode(TEST_SAMPLES);
+
+    compressed_len = mqtt_telemetry_compress(s_frame, len, s_compressed, sizeof(s_compressed));
+    CHECK(compressed_len > 0);
+    CHECK(compressed_len < len);
+    CHECK(s_compressed[0] & MQTT_TELEMETRY_FLAG_COMPRESSED);
+
+    memset(&s_received, 0, sizeof(s_received));
+    CHECK_EQ(mqtt_telemetry_decode(s_compressed, compressed_len, s_scratch, sizeof(s_scratch),
+                                   test_collect, &s_received), TEST_SAMPLES);
+    test_check_received();
+}
+
+static void test_extreme_values(void)
+{
+    size_t len;
+
+    test_make_samples(4);
+    s_sent.values[1][0] = INT32_MAX;
+    s_sent.values[2][0] = INT32_MIN;
+    s_sent.values[3][1] = INT32_MIN;
+    s_sent.values[3][2] = INT32_MAX;
+    len = test_encode(4);
+
+    memset(&s_received, 0, sizeof(s_received));
+    CHECK_EQ(mqtt_telemetry_decode(s_frame, len, NULL, 0, test_collect, &s_received), 4);
+    test_check_received();
+}
+
+static void test_full_buffer(void)
+{
+    mqtt_telemetry_encoder_t encoder;
+    uint32_t added = 0;
+    size_t len;
+
+    test_make_samples(TEST_SAMPLES);
+
+    /* Room for the header and a few samples only */
+    CHECK(mqtt_telemetry_begin(&encoder, &s_schema, s_frame, 40, s_sent.time_ms[0]));
+    while ((added < TEST_SAMPLES) && mqtt_telemetry_add(&encoder, s_sent.time_ms[added], s_sent.values[added])) {
+        added++;
+    }
+    CHECK(added > 0);
+    CHECK(added < TEST_SAMPLES);
+
+    /* The sample that did not fit left the frame as it was */
+    len = mqtt_telemetry_length(&encoder);
+    CHECK(len <= 40);
+    CHECK(!mqtt_telemetry_add(&encoder, s_sent.time_ms[added], s_sent.values[added]));
+    CHECK_EQ(mqtt_telemetry_length(&encoder), len);
+
+    s_sent.count = added;
+    memset(&s_received, 0, sizeof(s_received));
+    CHECK_EQ(mqtt_telemetry_decode(s_frame, len, NULL, 0, test_collect, &s_received), added);
+    test_check_received();
+}
+
+static void test_malformed(void)
+{
+    size_t len;
+
+    test_make_samples(8);
+    len = test_encode(8);
+
+    /* Unknown format version */
+    s_frame[0] ^= 0x0Fu;
+    CHECK_EQ(mqtt_telemetry_decode(s_frame, len, NULL, 0, test_collect, &s_received), -1);
+    s_frame[0] ^= 0x0Fu;
+
+    /* A sample cut short */
+    CHECK_EQ(mqtt_telemetry_decode(s_frame, len - 1, NULL, 0, test_collect, &s_received), -1);
+
+    /* A compressed frame without room to decompress it */
+    len = test_encode(TEST_SAMPLES);
+    len = mqtt_telemetry_compress(s_frame, len, s_compressed, sizeof(s_compressed));
+    CHECK(len > 0);
+    CHECK_EQ(mqtt_telemetry_decode(s_compressed, len, s_scratch, 16, test_collect, &s_received), -1);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+int main(void)
+{
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_compressed_round_trip);
+    RUN_TEST(test_extreme_values);
+    RUN_TEST(test_full_buffer);
+    RUN_TEST(test_malformed);
+
+    return test_failures();
+}
+
+/* [] END OF FILE */
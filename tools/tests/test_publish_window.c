@@ -0,0 +1,278 @@
+/******************************************************************************
+* File Name:   test_publish_window.c
+*
+* Description: Host unit tests of the publish window with four slot tasks:
+*              records completing out of order, failed records going back
+*              into the outbound ring in push order, and stopping the window.
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "mqtt_publish_window.h"
+#include "mqtt_publish_ring.h"
+
+#include "test_util.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#if (MQTT_PUBLISH_WINDOW_SIZE != 4)
+#error "built with MQTT_PUBLISH_WINDOW_SIZE=4u (see the Makefile)"
+#endif
+
+#define TEST_RECORDS        (6u)
+#define TEST_WAIT_MS        (2000u)
+#define TEST_ERROR          ((cy_rslt_t)0x0A020002U)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static uint8_t s_data[TEST_RECORDS];
+static mqtt_payload_t s_payloads[TEST_RECORDS];
+
+/* Per record: given by the test to let its cy_mqtt_publish() return */
+static cy_semaphore_t s_release[TEST_RECORDS];
+static cy_rslt_t s_result[TEST_RECORDS];
+
+static cy_semaphore_t s_started;    /* one give per cy_mqtt_publish() */
+static cy_semaphore_t s_done;       /* one give per completion callback */
+
+static cy_mutex_t s_mutex;
+static uint8_t s_acked[TEST_RECORDS];
+static size_t s_acked_count;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* Stand-in of the MQTT library: blocks like a QoS 1 publish until the
+ * test releases the record
+ */
+cy_rslt_t cy_mqtt_publish(cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg)
+{
+    uint8_t index = (uint8_t)pub_msg->payload[0];
+
+    (void)mqtt_handle;
+
+    cy_rtos_set_semaphore(&s_started, false);
+    cy_rtos_get_semaphore(&s_release[index], CY_RTOS_NEVER_TIMEOUT, false);
+    return s_result[index];
+}
+
+/* As the publisher task: an acknowledged record is done, a failed one goes
+ * back into the ring
+ */
+static void test_complete(cy_rslt_t result, const mqtt_publish_record_t *record, void *arg)
+{
+    (void)arg;
+
+    if (result == CY_RSLT_SUCCESS) {
+        cy_rtos_get_mutex(&s_mutex, CY_RTOS_NEVER_TIMEOUT);
+        s_acked[s_acked_count++] = record->payload->data[0];
+        cy_rtos_set_mutex(&s_mutex);
+    } else {
+        CHECK(mqtt_publish_ring_requeue(record) == CY_RSLT_SUCCESS);
+    }
+    cy_rtos_set_semaphore(&s_done, false);
+}
+
+/* As the drain of the publisher task: out of the ring, then submitted, or
+ * back into the ring if the window refuses it
+ */
+static bool test_submit_next(cy_time_t timeout_ms)
+{
+    mqtt_publish_record_t record;
+
+    if (!mqtt_publish_ring_peek(&record)) {
+        return false;
+    }
+    mqtt_publish_ring_drop();
+
+    if (mqtt_publish_window_submit(NULL, &record, timeout_ms) != CY_RSLT_SUCCESS) {
+        CHECK(mqtt_publish_ring_requeue(&record) == CY_RSLT_SUCCESS);
+        return false;
+    }
+    return true;
+}
+
+static void test_release(uint8_t index, cy_rslt_t result)
+{
+    s_result[index] = result;
+    cy_rtos_set_semaphore(&s_release[index], false);
+    CHECK(cy_rtos_get_semaphore(&s_done, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+}
+
+static void test_check_ring(const uint8_t *expected, size_t count)
+{
+    mqtt_publish_record_t record;
+
+    CHECK_EQ(mqtt_publish_ring_count(), count);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(mqtt_publish_ring_peek(&record));
+        CHECK_EQ(record.payload->data[0], expected[i]);
+        mqtt_publish_ring_drop();
+    }
+}
+
+static void test_push_all(void)
+{
+    mqtt_publish_record_t records[TEST_RECORDS];
+
+    memset(records, 0, sizeof(records));
+    for (size_t i = 0; i < TEST_RECORDS; i++) {
+        records[i].topic = "test";
+        records[i].payload = &s_payloads[i];
+        records[i].qos = CY_MQTT_QOS1;
+    }
+    CHECK(mqtt_publish_ring_push(records, TEST_RECORDS) == CY_RSLT_SUCCESS);
+}
+
+
+/*-- Tests -------------------------------------------------*/
+
+static void test_out_of_order(void)
+{
+    static const uint8_t expected[] = { 0, 2, 4, 5 };
+    mqtt_publish_window_stats_t stats;
+
+    s_acked_count = 0;
+    test_push_all();
+
+    /* Four records in flight at once, each in its own cy_mqtt_publish() */
+    for (size_t i = 0; i < MQTT_PUBLISH_WINDOW_SIZE; i++) {
+        CHECK(test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+    }
+    for (size_t i = 0; i < MQTT_PUBLISH_WINDOW_SIZE; i++) {
+        CHECK(cy_rtos_get_semaphore(&s_started, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+    }
+
+    /* The window is full: the fifth record waits, then goes back */
+    CHECK(!test_submit_next(50));
+    CHECK_EQ(mqtt_publish_ring_count(), 2);
+
+    /* Completions in the reverse order, every other one failed */
+    test_release(3, CY_RSLT_SUCCESS);
+    test_release(2, TEST_ERROR);
+    test_release(1, CY_RSLT_SUCCESS);
+    test_release(0, TEST_ERROR);
+
+    CHECK(mqtt_publish_window_stop(TEST_WAIT_MS) == CY_RSLT_SUCCESS);
+    mqtt_publish_window_get_stats(&stats);
+    CHECK_EQ(stats.in_flight, 0);
+    CHECK_EQ(stats.peak, MQTT_PUBLISH_WINDOW_SIZE);
+    CHECK_EQ(stats.completed, 2);
+    CHECK_EQ(stats.failed, 2);
+
+    CHECK_EQ(s_acked_count, 2);
+    CHECK_EQ(s_acked[0], 3);
+    CHECK_EQ(s_acked[1], 1);
+
+    /* The failed records are back ahead of the ones never sent */
+    test_check_ring(expected, sizeof(expected));
+    mqtt_publish_window_start();
+}
+
+static void test_fail_while_in_flight(void)
+{
+    static const uint8_t expected[] = { 0, 2, 3, 4, 5 };
+
+    test_push_all();
+
+    /* Record 0 fails while record 1 is in flight */
+    CHECK(test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+    CHECK(cy_rtos_get_semaphore(&s_started, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+    CHECK(test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+    test_release(0, TEST_ERROR);
+    CHECK(cy_rtos_get_semaphore(&s_started, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+    test_release(1, CY_RSLT_SUCCESS);
+
+    /* Neither record is lost or sent twice */
+    CHECK(mqtt_publish_window_stop(TEST_WAIT_MS) == CY_RSLT_SUCCESS);
+    test_check_ring(expected, sizeof(expected));
+    mqtt_publish_window_start();
+}
+
+static void test_stop(void)
+{
+    static const uint8_t expected[] = { 0, 1, 2, 3, 4, 5 };
+
+    test_push_all();
+
+    CHECK(test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+    CHECK(cy_rtos_get_semaphore(&s_started, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+
+    /* The stop waits for the message in flight */
+    CHECK(mqtt_publish_window_stop(50) != CY_RSLT_SUCCESS);
+
+    /* Stopped: new records are refused and stay in the ring */
+    CHECK(!test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+
+    test_release(0, TEST_ERROR);
+    CHECK(mqtt_publish_window_stop(TEST_WAIT_MS) == CY_RSLT_SUCCESS);
+    test_check_ring(expected, sizeof(expected));
+
+    /* And accepted again once started */
+    mqtt_publish_window_start();
+    test_push_all();
+    CHECK(test_submit_next(CY_RTOS_NEVER_TIMEOUT));
+    CHECK(cy_rtos_get_semaphore(&s_started, TEST_WAIT_MS, false) == CY_RSLT_SUCCESS);
+    test_release(0, CY_RSLT_SUCCESS);
+    CHECK(mqtt_publish_window_stop(TEST_WAIT_MS) == CY_RSLT_SUCCESS);
+    test_check_ring(&expected[1], sizeof(expected) - 1u);
+    mqtt_publish_window_start();
+}
+
+int main(void)
+{
+    for (uint8_t i = 0; i < TEST_RECORDS; i++) {
+        s_data[i] = i;
+        mqtt_payload_init(&s_payloads[i], &s_data[i], 1, NULL, NULL);
+        cy_rtos_init_semaphore(&s_release[i], 1, 0);
+    }
+    cy_rtos_init_semaphore(&s_started, TEST_RECORDS, 0);
+    cy_rtos_init_semaphore(&s_done, TEST_RECORDS, 0);
+    cy_rtos_init_mutex(&s_mutex);
+
+    CHECK(mqtt_publish_ring_init() == CY_RSLT_SUCCESS);
+    CHECK(mqtt_publish_window_init(test_complete, NULL) == CY_RSLT_SUCCESS);
+
+    RUN_TEST(test_out_of_order);
+    RUN_TEST(test_fail_while_in_flight);
+    RUN_TEST(test_stop);
+    return test_failures();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,496 @@
+/******************************************************************************
+* File Name:   test_publisher_queue.c
+*
+* Description: Host unit tests of the overflow policies and lanes of the
+*              publisher queue (source/tasks/publisher_queue.c)
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "publisher_queue.h"
+#include "mqtt_client_config.h"
+#include "mqtt_uplink_budget.h"
+#include "task.h"
+
+#include "test_util.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define TEST_MSG_COUNT      (PUBLISHER_QUEUE_DEPTH + 4u)
+
+/* Long enough for the pacing of the normal lane to let a message go */
+#define TEST_GET_TIMEOUT_MS (10u * 1000u)
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static uint8_t s_data[TEST_MSG_COUNT];
+static mqtt_payload_t s_payloads[TEST_MSG_COUNT];
+static uint32_t s_released[TEST_MSG_COUNT];
+static uint32_t s_failed[TEST_MSG_COUNT];
+
+static mqtt_budget_level_t s_budget_level = MQTT_BUDGET_LEVEL_NORMAL;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+/* The queue only asks the uplink budget for its level and pacing */
+mqtt_budget_level_t mqtt_uplink_budget_level(void)
+{
+    return s_budget_level;
+}
+
+uint32_t mqtt_uplink_budget_wait_ms(void)
+{
+    return 0;
+}
+
+static void test_release_cb(mqtt_payload_t *payload, void *arg)
+{
+    (void)payload;
+    s_released[(uintptr_t)arg]++;
+}
+
+static void test_complete_cb(cy_rslt_t result, cy_time_t enqueue_time, void *arg)
+{
+    (void)enqueue_time;
+
+    if (result != CY_RSLT_SUCCESS) {
+        s_failed[(uintptr_t)arg]++;
+    }
+}
+
+static publisher_data_t test_msg(uint32_t id,
+                                 const char *topic,
+                                 publisher_priority_t priority)
+{
+    publisher_data_t item;
+
+    mqtt_payload_init(&s_payloads[id], &s_data[id], 1, test_release_cb, (void *)(uintptr_t)id);
+
+    memset(&item, 0, sizeof(item));
+    item.cmd = PUBLISH_MQTT_MSG;
+    item.payload = &s_payloads[id];
+    item.topic = topic;
+    item.qos = CY_MQTT_QOS1;
+    item.priority = priority;
+    item.complete_cb = test_complete_cb;
+    item.complete_arg = (void *)(uintptr_t)id;
+    item.conn = MQTT_CONN_COMMAND;
+    return item;
+}
+
+static publisher_data_t test_cmd(publisher_cmd_t cmd)
+{
+    publisher_data_t item;
+
+    memset(&item, 0, sizeof(item));
+    item.cmd = cmd;
+    item.conn = MQTT_CONN_COMMAND;
+    return item;
+}
+
+/* Id of the message taken, or -1 for a control command or nothing */
+static int test_get_id(cy_time_t timeout_ms)
+{
+    publisher_data_t item;
+
+    if (publisher_queue_get(MQTT_CONN_COMMAND, &item, timeout_ms) != CY_RSLT_SUCCESS) {
+        return -2;
+    }
+    if (item.cmd != PUBLISH_MQTT_MSG) {
+        return -1;
+    }
+    return (int)(uintptr_t)item.complete_arg;
+}
+
+static void test_reset(publisher_queue_policy_t policy)
+{
+    while (test_get_id(TEST_GET_TIMEOUT_MS) != -2);
+
+    memset(s_released, 0, sizeof(s_released));
+    memset(s_failed, 0, sizeof(s_failed));
+    s_budget_level = MQTT_BUDGET_LEVEL_NORMAL;
+    publisher_queue_set_policy(policy);
+    publisher_queue_reset_stats();
+
+    /* A fresh burst for the normal lane */
+    host_shim_advance_time(PUBLISHER_NORMAL_LANE_INTERVAL_MS * PUBLISHER_NORMAL_LANE_BURST);
+}
+
+static void test_fill(publisher_priority_t priority)
+{
+    for (uint32_t i = 0; i < PUBLISHER_QUEUE_DEPTH; i++) {
+        publisher_data_t item = test_msg(i, "t", priority);
+
+        CHECK_EQ(publisher_queue_put(&item, false), CY_RSLT_SUCCESS);
+    }
+}
+
+
+/*-- Tests -------------------------------------------------*/
+
+static void test_drop_newest(void)
+{
+    publisher_data_t item;
+    publisher_queue_stats_t stats;
+
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+    test_fill(PUBLISHER_PRIORITY_NORMAL);
+
+    /* Rejected: the caller keeps its reference */
+    item = test_msg(PUBLISHER_QUEUE_DEPTH, "t", PUBLISHER_PRIORITY_NORMAL);
+    CHECK(publisher_queue_put(&item, false) != CY_RSLT_SUCCESS);
+    CHECK_EQ(s_released[PUBLISHER_QUEUE_DEPTH], 0);
+    CHECK_EQ(s_failed[PUBLISHER_QUEUE_DEPTH], 0);
+
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.dropped_newest, 1);
+    CHECK_EQ(stats.depth, PUBLISHER_QUEUE_DEPTH);
+
+    for (uint32_t i = 0; i < PUBLISHER_QUEUE_DEPTH; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+    CHECK_EQ(test_get_id(0), -2);
+}
+
+static void test_drop_oldest(void)
+{
+    publisher_data_t item;
+    publisher_queue_stats_t stats;
+
+    test_reset(PUBLISHER_QUEUE_DROP_OLDEST);
+    test_fill(PUBLISHER_PRIORITY_NORMAL);
+
+    /* Evicts message 0, whose producer is told and whose payload is released */
+    item = test_msg(PUBLISHER_QUEUE_DEPTH, "t", PUBLISHER_PRIORITY_NORMAL);
+    CHECK_EQ(publisher_queue_put(&item, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(s_released[0], 1);
+    CHECK_EQ(s_failed[0], 1);
+
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.dropped_oldest, 1);
+
+    for (uint32_t i = 1; i <= PUBLISHER_QUEUE_DEPTH; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+    CHECK_EQ(test_get_id(0), -2);
+}
+
+static void test_coalesce_by_topic(void)
+{
+    publisher_data_t a = test_msg(0, "temp", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t b = test_msg(1, "humidity", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t c = test_msg(2, "temp", PUBLISHER_PRIORITY_NORMAL);
+    publisher_queue_stats_t stats;
+
+    test_reset(PUBLISHER_QUEUE_COALESCE_BY_TOPIC);
+
+    CHECK_EQ(publisher_queue_put(&a, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&b, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&c, false), CY_RSLT_SUCCESS);
+
+    /* The latest value takes the place of the queued one */
+    CHECK_EQ(s_released[0], 1);
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.coalesced, 1);
+    CHECK_EQ(stats.depth, 2);
+
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 2);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 1);
+}
+
+static void test_coalesce_when_budget_low(void)
+{
+    publisher_data_t a = test_msg(0, "temp", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t b = test_msg(1, "temp", PUBLISHER_PRIORITY_NORMAL);
+
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+    s_budget_level = MQTT_BUDGET_LEVEL_COALESCE;
+
+    CHECK_EQ(publisher_queue_put(&a, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&b, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(s_released[0], 1);
+
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 1);
+    CHECK_EQ(test_get_id(0), -2);
+}
+
+static void test_control_commands_reserved(void)
+{
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+    test_fill(PUBLISHER_PRIORITY_NORMAL);
+
+    /* A full queue of messages still takes the control commands */
+    for (uint32_t i = 0; i < PUBLISHER_QUEUE_RESERVED_SLOTS; i++) {
+        publisher_data_t cmd = test_cmd(PUBLISHER_INIT);
+
+        CHECK_EQ(publisher_queue_put(&cmd, false), CY_RSLT_SUCCESS);
+    }
+
+    /* ...and never evicts one for a message */
+    publisher_queue_set_policy(PUBLISHER_QUEUE_DROP_OLDEST);
+    {
+        publisher_data_t cmd = test_cmd(PUBLISHER_DEINIT);
+
+        CHECK(publisher_queue_put(&cmd, false) != CY_RSLT_SUCCESS);
+    }
+}
+
+static void test_block_times_out(void)
+{
+    publisher_data_t item;
+    publisher_queue_stats_t stats;
+    cy_time_t start = 0;
+    cy_time_t end = 0;
+
+    test_reset(PUBLISHER_QUEUE_BLOCK);
+    test_fill(PUBLISHER_PRIORITY_NORMAL);
+
+    item = test_msg(PUBLISHER_QUEUE_DEPTH, "t", PUBLISHER_PRIORITY_NORMAL);
+    cy_rtos_get_time(&start);
+    CHECK(publisher_queue_put(&item, false) != CY_RSLT_SUCCESS);
+    cy_rtos_get_time(&end);
+
+    CHECK_EQ(end - start, PUBLISHER_QUEUE_BLOCK_TIMEOUT_MS);
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.blocked, 1);
+    CHECK_EQ(stats.block_timeouts, 1);
+    CHECK_EQ(stats.dropped_newest, 1);
+}
+
+static void test_high_lane_first(void)
+{
+    publisher_data_t a = test_msg(0, "t", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t b = test_msg(1, "t", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t alarm = test_msg(2, "alarm", PUBLISHER_PRIORITY_HIGH);
+    publisher_queue_stats_t stats;
+
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+
+    CHECK_EQ(publisher_queue_put(&a, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&b, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&alarm, false), CY_RSLT_SUCCESS);
+
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.high_enqueued, 1);
+
+    /* The high message overtakes the normal ones queued before it */
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 2);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 0);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 1);
+}
+
+static void test_high_evicts_normal(void)
+{
+    publisher_data_t alarm;
+    publisher_queue_stats_t stats;
+
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+    test_fill(PUBLISHER_PRIORITY_NORMAL);
+
+    /* Drop-newest rejects normal messages, not a high one */
+    alarm = test_msg(PUBLISHER_QUEUE_DEPTH, "alarm", PUBLISHER_PRIORITY_HIGH);
+    CHECK_EQ(publisher_queue_put(&alarm, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(s_released[0], 1);
+    CHECK_EQ(s_failed[0], 1);
+
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.dropped_oldest, 1);
+    CHECK_EQ(stats.depth, PUBLISHER_QUEUE_DEPTH);
+
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), PUBLISHER_QUEUE_DEPTH);
+    for (uint32_t i = 1; i < PUBLISHER_QUEUE_DEPTH; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+    CHECK_EQ(test_get_id(0), -2);
+}
+
+static void test_high_not_evicted(void)
+{
+    publisher_data_t item;
+
+    test_reset(PUBLISHER_QUEUE_DROP_OLDEST);
+    test_fill(PUBLISHER_PRIORITY_HIGH);
+
+    /* A normal message never takes the place of a high one */
+    item = test_msg(PUBLISHER_QUEUE_DEPTH, "t", PUBLISHER_PRIORITY_NORMAL);
+    CHECK(publisher_queue_put(&item, false) != CY_RSLT_SUCCESS);
+    for (uint32_t i = 0; i < PUBLISHER_QUEUE_DEPTH; i++) {
+        CHECK_EQ(s_released[i], 0);
+    }
+
+    for (uint32_t i = 0; i < PUBLISHER_QUEUE_DEPTH; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+}
+
+static void test_normal_lane_paced(void)
+{
+    publisher_data_t alarm;
+    publisher_queue_stats_t stats;
+    cy_time_t start = 0;
+    cy_time_t end = 0;
+
+    test_reset(PUBLISHER_QUEUE_DROP_NEWEST);
+
+    for (uint32_t i = 0; i <= PUBLISHER_NORMAL_LANE_BURST; i++) {
+        publisher_data_t item = test_msg(i, "t", PUBLISHER_PRIORITY_NORMAL);
+
+        CHECK_EQ(publisher_queue_put(&item, false), CY_RSLT_SUCCESS);
+    }
+
+    /* A burst goes out back-to-back... */
+    for (uint32_t i = 0; i < PUBLISHER_NORMAL_LANE_BURST; i++) {
+        CHECK_EQ(test_get_id(0), i);
+    }
+
+    /* ...then the normal lane waits for its pace... */
+    CHECK_EQ(test_get_id(0), -2);
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK(stats.paced > 0);
+
+    /* ...which a high message does not */
+    alarm = test_msg(PUBLISHER_NORMAL_LANE_BURST + 1, "alarm", PUBLISHER_PRIORITY_HIGH);
+    CHECK_EQ(publisher_queue_put(&alarm, false), CY_RSLT_SUCCESS);
+    CHECK_EQ(test_get_id(0), PUBLISHER_NORMAL_LANE_BURST + 1);
+
+    cy_rtos_get_time(&start);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), PUBLISHER_NORMAL_LANE_BURST);
+    cy_rtos_get_time(&end);
+    CHECK_EQ(end - start, PUBLISHER_NORMAL_LANE_INTERVAL_MS);
+}
+
+static void test_isr_put(void)
+{
+    publisher_data_t a = test_msg(0, "a", PUBLISHER_PRIORITY_NORMAL);
+    publisher_data_t b = test_msg(1, "b", PUBLISHER_PRIORITY_NORMAL);
+
+    test_reset(PUBLISHER_QUEUE_DROP_OLDEST);
+
+    /* Items put from an ISR wait in the lock-free ring for the get */
+    CHECK_EQ(publisher_queue_put(&a, true), CY_RSLT_SUCCESS);
+    CHECK_EQ(publisher_queue_put(&b, true), CY_RSLT_SUCCESS);
+
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 0);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 1);
+}
+
+static void test_isr_wakeup(void)
+{
+    publisher_data_t item;
+    uint32_t given;
+
+    test_reset(PUBLISHER_QUEUE_DROP_OLDEST);
+    publisher_queue_attach(MQTT_CONN_COMMAND);
+    given = host_shim_notifications_given();
+
+    /* One notification when the ring goes from empty to non-empty */
+    for (uint32_t i = 0; i < 3; i++) {
+        item = test_msg(i, "t", PUBLISHER_PRIORITY_NORMAL);
+        CHECK_EQ(publisher_queue_put(&item, true), CY_RSLT_SUCCESS);
+    }
+    CHECK_EQ(host_shim_notifications_given() - given, 1);
+
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+
+    /* Emptied by the get: the next push notifies again */
+    item = test_msg(3, "t", PUBLISHER_PRIORITY_NORMAL);
+    CHECK_EQ(publisher_queue_put(&item, true), CY_RSLT_SUCCESS);
+    CHECK_EQ(host_shim_notifications_given() - given, 2);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 3);
+
+    /* None once the task is detached, before it is deleted */
+    publisher_queue_detach(MQTT_CONN_COMMAND);
+    item = test_msg(4, "t", PUBLISHER_PRIORITY_NORMAL);
+    CHECK_EQ(publisher_queue_put(&item, true), CY_RSLT_SUCCESS);
+    CHECK_EQ(host_shim_notifications_given() - given, 2);
+    CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), 4);
+}
+
+static void test_isr_ring_full(void)
+{
+    publisher_queue_stats_t stats;
+    uint32_t accepted = 0;
+
+    test_reset(PUBLISHER_QUEUE_DROP_OLDEST);
+
+    for (uint32_t i = 0; i <= PUBLISHER_QUEUE_ISR_RING_SIZE; i++) {
+        publisher_data_t item = test_msg(i, "t", PUBLISHER_PRIORITY_NORMAL);
+
+        if (publisher_queue_put(&item, true) == CY_RSLT_SUCCESS) {
+            accepted++;
+        }
+    }
+    CHECK_EQ(accepted, PUBLISHER_QUEUE_ISR_RING_SIZE);
+
+    /* The drop is counted once the publisher task drains the ring */
+    for (uint32_t i = 0; i < accepted; i++) {
+        CHECK_EQ(test_get_id(TEST_GET_TIMEOUT_MS), i);
+    }
+    publisher_queue_get_stats(MQTT_CONN_COMMAND, &stats);
+    CHECK_EQ(stats.dropped_newest, 1);
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+int main(void)
+{
+    CHECK_EQ(publisher_queue_init(MQTT_CONN_COMMAND), CY_RSLT_SUCCESS);
+
+    RUN_TEST(test_drop_newest);
+    RUN_TEST(test_drop_oldest);
+    RUN_TEST(test_coalesce_by_topic);
+    RUN_TEST(test_coalesce_when_budget_low);
+    RUN_TEST(test_control_commands_reserved);
+    RUN_TEST(test_block_times_out);
+    RUN_TEST(test_high_lane_first);
+    RUN_TEST(test_high_evicts_normal);
+    RUN_TEST(test_high_not_evicted);
+    RUN_TEST(test_normal_lane_paced);
+    RUN_TEST(test_isr_put);
+    RUN_TEST(test_isr_wakeup);
+    RUN_TEST(test_isr_ring_full);
+
+    return test_failures();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,242 @@
+/******************************************************************************
+* File Name:   test_spsc_ring.c
+*
+* Description: Host unit tests of the lock-free single-producer, single-consumer
+*              ring (source/utils/spsc_ring.c)
+*
+* Related Document: See README.md
+*
+*******************************************************************************
+* Copyright 2020-2021, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "spsc_ring.h"
+
+#include "test_util.h"
+
+
+/*-- Local Definitions -------------------------------------------------*/
+
+#define TEST_CAPACITY       (8u)
+#define TEST_STRESS_COUNT   (100000u)
+
+typedef struct {
+    uint32_t seq;
+    uint8_t pad[6];             /* an element size that is not a word */
+} test_elem_t;
+
+
+/*-- Local Data -------------------------------------------------*/
+
+static test_elem_t s_storage[TEST_CAPACITY];
+static spsc_ring_t s_ring;
+
+
+/*-- Local Functions -------------------------------------------------*/
+
+static test_elem_t test_elem(uint32_t seq)
+{
+    test_elem_t elem;
+
+    memset(&elem, 0, sizeof(elem));
+    elem.seq = seq;
+    memset(elem.pad, (int)(seq & 0xFFu), sizeof(elem.pad));
+    return elem;
+}
+
+static void test_init_args(void)
+{
+    CHECK(!spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), 0));
+    CHECK(!spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), 6));
+    CHECK(!spsc_ring_init(&s_ring, s_storage, 0, TEST_CAPACITY));
+    CHECK(!spsc_ring_init(&s_ring, NULL, sizeof(test_elem_t), TEST_CAPACITY));
+    CHECK(!spsc_ring_init(NULL, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), 1));
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+    CHECK_EQ(spsc_ring_count(&s_ring), 0);
+}
+
+/* Elements come out in push order, also across the end of the storage */
+static void test_fifo_order(void)
+{
+    test_elem_t elem;
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+    CHECK(!spsc_ring_pop(&s_ring, &elem));
+
+    for (uint32_t round = 0; round < 5; round++) {
+        for (uint32_t i = 0; i < 5; i++) {
+            elem = test_elem(next_push++);
+            CHECK(spsc_ring_push(&s_ring, &elem));
+        }
+        CHECK_EQ(spsc_ring_count(&s_ring), 5);
+
+        for (uint32_t i = 0; i < 5; i++) {
+            test_elem_t expected = test_elem(next_pop++);
+
+            CHECK(spsc_ring_pop(&s_ring, &elem));
+            CHECK(memcmp(&elem, &expected, sizeof(elem)) == 0);
+        }
+        CHECK_EQ(spsc_ring_count(&s_ring), 0);
+    }
+    CHECK(!spsc_ring_pop(&s_ring, &elem));
+    CHECK_EQ(s_ring.dropped, 0);
+}
+
+/* A full ring refuses the push, counts it, and keeps its elements */
+static void test_full(void)
+{
+    test_elem_t elem;
+
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) {
+        elem = test_elem(i);
+        CHECK(spsc_ring_push(&s_ring, &elem));
+    }
+    elem = test_elem(100);
+    CHECK(!spsc_ring_push(&s_ring, &elem));
+    CHECK(!spsc_ring_push(&s_ring, &elem));
+    CHECK_EQ(s_ring.dropped, 2);
+    CHECK_EQ(spsc_ring_count(&s_ring), TEST_CAPACITY);
+
+    /* One pop makes room for one push */
+    CHECK(spsc_ring_pop(&s_ring, &elem));
+    CHECK_EQ(elem.seq, 0);
+    elem = test_elem(TEST_CAPACITY);
+    CHECK(spsc_ring_push(&s_ring, &elem));
+
+    for (uint32_t i = 1; i <= TEST_CAPACITY; i++) {
+        CHECK(spsc_ring_pop(&s_ring, &elem));
+        CHECK_EQ(elem.seq, i);
+    }
+    CHECK_EQ(spsc_ring_count(&s_ring), 0);
+}
+
+/* The free-running indices wrap at 2^32 */
+static void test_index_wrap(void)
+{
+    test_elem_t elem;
+
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+    s_ring.head = UINT32_MAX - 3u;
+    s_ring.tail = UINT32_MAX - 3u;
+
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) {
+        elem = test_elem(i);
+        CHECK(spsc_ring_push(&s_ring, &elem));
+    }
+    CHECK(s_ring.tail < s_ring.head);
+    CHECK_EQ(spsc_ring_count(&s_ring), TEST_CAPACITY);
+
+    elem = test_elem(100);
+    CHECK(!spsc_ring_push(&s_ring, &elem));
+
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) {
+        CHECK(spsc_ring_pop(&s_ring, &elem));
+        CHECK_EQ(elem.seq, i);
+    }
+    CHECK(!spsc_ring_pop(&s_ring, &elem));
+    CHECK_EQ(spsc_ring_count(&s_ring), 0);
+}
+
+static void *test_producer(void *arg)
+{
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while (seq < TEST_STRESS_COUNT) {
+        test_elem_t elem = test_elem(seq);
+
+        if (spsc_ring_push(&s_ring, &elem)) {
+            seq++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* A producer and a consumer thread: every element arrives once, in order
+ * and intact. The drops are the retried pushes to a full ring.
+ */
+static void test_threads(void)
+{
+    pthread_t producer;
+    test_elem_t elem;
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+
+    CHECK(spsc_ring_init(&s_ring, s_storage, sizeof(test_elem_t), TEST_CAPACITY));
+    CHECK_EQ(pthread_create(&producer, NULL, test_producer, NULL), 0);
+
+    while (expected < TEST_STRESS_COUNT) {
+        if (spsc_ring_pop(&s_ring, &elem)) {
+            test_elem_t want = test_elem(expected);
+
+            if (memcmp(&elem, &want, sizeof(elem)) != 0) {
+                errors++;
+            }
+            expected++;
+        } else {
+            sched_yield();
+        }
+    }
+
+    CHECK_EQ(pthread_join(producer, NULL), 0);
+    CHECK_EQ(errors, 0);
+    CHECK(!spsc_ring_pop(&s_ring, &elem));
+}
+
+
+/*-- Public Functions -------------------------------------------------*/
+
+int main(void)
+{
+    RUN_TEST(test_init_args);
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full);
+    RUN_TEST(test_index_wrap);
+    RUN_TEST(test_threads);
+
+    return test_failures();
+}
+
+/* [] END OF FILE */